@@ -11,20 +11,165 @@
 
 #define ECG_PROCESSING_MAX_R_PEAKS 64U
 
+/* Centered moving-integration width of the QRS detector: 150 ms. */
+#define ECG_QRS_INTEGRATION_WINDOW_SAMPLES ((15U * ECG_PROCESSOR_SAMPLE_RATE_HZ) / 100U)
+
+/* RR intervals averaged by the adaptive detector for search-back and rhythm regularity. */
+#define ECG_QRS_RR_HISTORY 8U
+
 enum ecg_window_append_result {
 	ECG_WINDOW_SAMPLE_STORED,
 	ECG_WINDOW_COMPLETED,
 	ECG_WINDOW_ALREADY_FULL,
 };
 
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+/*
+ * Q15 fraction of the MAX30003 input range: the signed 18-bit sample without
+ * its two least significant bits, so one step is about 1 uV. Standardization
+ * removes the scale, so it is never converted to millivolts.
+ */
+typedef int16_t ecg_sample_t;
+#else
+/* Millivolts. */
+typedef float ecg_sample_t;
+#endif
+
+/*
+ * Statistics kept for consecutive blocks of samples merge into those of the
+ * combined samples, so a window built from blocks needs no extra pass to find
+ * its mean and variance. Float samples keep a running mean and sum of squared
+ * deviations (Welford); Q15 samples keep exact integer sums.
+ */
+struct ecg_running_stats {
+	size_t count;
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	int64_t sum;
+	uint64_t sum_squares;
+#else
+	float mean;
+	float m2;
+#endif
+};
+
+/*
+ * Raw samples of one window. stats is updated by every append, so
+ * standardizing a complete window is a single normalize pass.
+ */
 struct ecg_sample_window {
-	float samples[ECG_PROCESSOR_WINDOW_SIZE];
+	ecg_sample_t samples[ECG_PROCESSOR_WINDOW_SIZE];
 	size_t count;
+	struct ecg_running_stats stats;
 };
 
-struct ecg_processing_workspace {
-	float squared_derivative[ECG_PROCESSOR_WINDOW_SIZE];
+/*
+ * Incremental R-peak detector for one window. Each appended sample updates the
+ * squared derivative, the centered moving integration, and the running mean
+ * and variance of the integrated signal, so only thresholding remains when the
+ * window completes. Peaks depend only on the shape of the signal, not on its
+ * offset or scale, so raw samples give the same peaks as standardized ones.
+ *
+ * With CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE, each integrated sample
+ * instead runs one step of a Pan-Tompkins detector: its signal and noise peak
+ * levels, learned over the first two seconds, set two thresholds; a beat
+ * missing for 166% of the recent RR average is searched back for at the lower
+ * threshold, and a late peak with a shallow slope is taken for a T wave.
+ * The learning samples are classified a few per new sample once the levels
+ * are set, and each beat is placed at the centre of its plateau on finish.
+ */
+struct ecg_qrs_detector {
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	/* Integration sums of squared Q15 differences, saturated to keep the statistics exact. */
+	uint32_t integrated_signal[ECG_PROCESSOR_WINDOW_SIZE];
+	uint32_t squared_derivative[ECG_QRS_INTEGRATION_WINDOW_SAMPLES];
+	uint64_t rolling_sum;
+	uint64_t integrated_sum;
+	uint64_t integrated_sum_squares;
+#else
 	float integrated_signal[ECG_PROCESSOR_WINDOW_SIZE];
+	float squared_derivative[ECG_QRS_INTEGRATION_WINDOW_SAMPLES];
+	float rolling_sum;
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+	float signal_level;
+	float noise_level;
+	float learning_max;
+	float learning_sum;
+	float last_qrs_value;
+	float last_qrs_slope;
+	/* Highest noise peak since the last beat, the search-back candidate. */
+	float searchback_value;
+	size_t searchback_index;
+	size_t last_qrs_index;
+	/* Integrated samples classified so far; the learning samples are caught up on later. */
+	size_t classified_count;
+	size_t rr_intervals[ECG_QRS_RR_HISTORY];
+	size_t rr_count;
+	size_t rr_next;
+	bool irregular;
+	size_t peak_indices[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t peak_count;
+#else
+	float integrated_mean;
+	float integrated_m2;
+#endif
+#endif
+	ecg_sample_t previous_sample;
+	size_t sample_count;
+	size_t integrated_count;
+};
+
+#if !defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_NOTCH_50HZ) || defined(CONFIG_TINYCARDIA_ECG_QRS_NOTCH_60HZ)
+#define ECG_QRS_FILTER_STAGES 3U
+#else
+#define ECG_QRS_FILTER_STAGES 2U
+#endif
+
+/*
+ * Streaming biquad cascade for the R-peak detector input: a 5-15 Hz
+ * Butterworth band-pass that removes baseline wander and emphasizes the QRS
+ * complex, plus the configured mains notch. The state carries across windows.
+ */
+struct ecg_qrs_filter {
+	float state[ECG_QRS_FILTER_STAGES][2];
+	bool primed;
+};
+#endif
+
+/*
+ * Signal-quality statistics of consecutive samples, kept in 18-bit MAX30003
+ * counts so they are independent of the stored sample type. Like running
+ * statistics, those of consecutive blocks merge into those of the combined
+ * samples; a flat run may span block boundaries.
+ */
+struct ecg_quality_stats {
+	size_t count;
+	size_t saturated_count;
+	/* Flat samples at the start and end of the block, and the longest flat run. */
+	size_t leading_flat_count;
+	size_t trailing_flat_count;
+	size_t longest_flat_count;
+	/* Sums of squared first and second differences. */
+	uint64_t slope_energy;
+	uint64_t curvature_energy;
+	int32_t baseline_min;
+	int32_t baseline_max;
+};
+
+/*
+ * Sample history behind the quality statistics. It carries across blocks and
+ * windows, so only a discontinuity in the captured samples restarts it.
+ */
+struct ecg_quality_tracker {
+	int32_t last_sample;
+	int32_t last_difference;
+	/* One-pole low-pass of the samples, scaled by its time constant. */
+	int32_t baseline_scaled;
+	uint8_t history;
+};
+
+struct ecg_processing_workspace {
+	struct ecg_qrs_detector qrs;
 	size_t r_peak_indices[ECG_PROCESSING_MAX_R_PEAKS];
 };
 
@@ -47,10 +192,93 @@ int32_t ecg_decode_raw_sample(uint32_t raw_word);
 /** Decode one MAX30003 FIFO word and convert the sample to millivolts. */
 float ecg_decode_sample_mv(uint32_t raw_word);
 
+/** Decode one MAX30003 FIFO word to the configured sample type. */
+ecg_sample_t ecg_decode_sample(uint32_t raw_word);
+
+/** True when the FIFO tag marks a sample taken during fast recovery. */
+bool ecg_sample_is_fast_recovery(uint32_t raw_word);
+
 void ecg_sample_window_reset(struct ecg_sample_window *window);
 
 enum ecg_window_append_result ecg_sample_window_append(struct ecg_sample_window *window,
-							       float sample);
+							       ecg_sample_t sample);
+
+void ecg_running_stats_reset(struct ecg_running_stats *stats);
+
+void ecg_running_stats_add(struct ecg_running_stats *stats, ecg_sample_t sample);
+
+/** Fold the statistics of a disjoint block of samples into stats. */
+void ecg_running_stats_merge(struct ecg_running_stats *stats,
+			     const struct ecg_running_stats *block);
+
+/**
+ * Whether the mean and the population standard deviation of reference each
+ * differ from those of stats by at most tolerance_permille thousandths of the
+ * standard deviation of stats, with the same floor as window standardization.
+ * Samples quantized with reference then move by at most about that fraction of
+ * a standard deviation, scaled by their own standardized magnitude, from their
+ * quantization with stats. False when either is empty.
+ */
+bool ecg_running_stats_within(const struct ecg_running_stats *stats,
+			      const struct ecg_running_stats *reference,
+			      uint32_t tolerance_permille);
+
+#if !defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+/**
+ * Write (sample - mean) / standard deviation for count samples, using the
+ * population standard deviation with the same floor as window standardization.
+ * Float samples and standardized may be the same buffer.
+ */
+void ecg_running_stats_standardize(const struct ecg_running_stats *stats,
+				   const ecg_sample_t *samples, float *standardized, size_t count);
+#endif
+
+/**
+ * Standardize count samples with the population standard deviation and
+ * quantize them to the model's INT8 ECG input in the same pass, rounding and
+ * saturating like tinycardia_model_quantize(). No float copy of the window is
+ * written. Q15 samples are scaled with one integer multiplier and shift.
+ */
+void ecg_running_stats_quantize(const struct ecg_running_stats *stats,
+				const ecg_sample_t *samples, int8_t *quantized, size_t count);
+
+void ecg_qrs_detector_reset(struct ecg_qrs_detector *detector);
+
+/** Feed the next sample of the window; samples past the window size are ignored. */
+void ecg_qrs_detector_append(struct ecg_qrs_detector *detector, ecg_sample_t sample);
+
+/**
+ * Complete detection for a full window and store up to max_peaks ordered peak
+ * indices. Returns the number of peaks, or zero for an incomplete window.
+ */
+size_t ecg_qrs_detector_finish(struct ecg_qrs_detector *detector, size_t *peak_indices,
+			       size_t max_peaks);
+
+#if !defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+void ecg_qrs_filter_reset(struct ecg_qrs_filter *filter);
+
+/**
+ * Filter the next sample. The first sample after a reset settles the filter as
+ * if that value had always been held, so a restart adds no transient.
+ */
+ecg_sample_t ecg_qrs_filter_apply(struct ecg_qrs_filter *filter, ecg_sample_t sample);
+#endif
+
+void ecg_quality_tracker_reset(struct ecg_quality_tracker *tracker);
+
+void ecg_quality_stats_reset(struct ecg_quality_stats *stats);
+
+/** Account for the next signed 18-bit sample, as from ecg_decode_raw_sample(). */
+void ecg_quality_stats_add(struct ecg_quality_stats *stats, struct ecg_quality_tracker *tracker,
+			   int32_t raw_sample);
+
+/** Fold the statistics of the block of samples that directly follows into stats. */
+void ecg_quality_stats_merge(struct ecg_quality_stats *stats,
+			     const struct ecg_quality_stats *block);
+
+/** Derive a window's signal-quality index and its level from its statistics. */
+void ecg_quality_stats_evaluate(const struct ecg_quality_stats *stats,
+				struct ecg_signal_quality_index *index);
 
 /**
  * Compute RR intervals and model features from ordered, in-window peak indices.
@@ -62,9 +290,54 @@ enum ecg_window_append_result ecg_sample_window_append(struct ecg_sample_window
 int ecg_extract_rr_features(const size_t *peak_indices, size_t peak_count,
 			    struct ecg_rr_result *result);
 
-/** Standardize a complete window and prepare both model input branches. */
+/**
+ * Compute RR features from externally measured intervals, such as the
+ * MAX30003 RTOR detector, using the same feature definitions and constants.
+ */
+int ecg_extract_rr_features_from_intervals(const float *intervals_ms, size_t interval_count,
+					   struct ecg_rr_result *result);
+
+#if !defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+/**
+ * Standardize a complete window with the statistics gathered as it was
+ * appended, then prepare both model input branches.
+ */
 int ecg_prepare_model_inputs(struct ecg_sample_window *window,
 			     struct ecg_processing_workspace *workspace,
 			     struct ecg_processing_result *result);
 
+/**
+ * Prepare model inputs for a complete window the caller already standardized,
+ * for example from running statistics kept while it was captured.
+ */
+int ecg_prepare_standardized_model_inputs(struct ecg_sample_window *window,
+					  struct ecg_processing_workspace *workspace,
+					  struct ecg_processing_result *result);
+#endif
+
+/**
+ * Standardize a complete window whose samples were also fed, in order, to
+ * detector, then finish R-peak detection and extract RR features. peak_indices
+ * must hold ECG_PROCESSING_MAX_R_PEAKS entries.
+ *
+ * When quantized_ecg is not NULL, the ECG branch is written there as the
+ * model's INT8 input instead, for example straight into the TFLM input tensor,
+ * and the window keeps its raw samples. Compact Q15 windows have no float
+ * branch and return -ENOTSUP without quantized_ecg.
+ */
+int ecg_prepare_model_inputs_from_detector(struct ecg_sample_window *window,
+					   struct ecg_qrs_detector *detector,
+					   size_t *peak_indices, int8_t *quantized_ecg,
+					   struct ecg_processing_result *result);
+
+/**
+ * Prepare model inputs using hardware RR intervals instead of software R-peak
+ * detection. r_peak_count reports the beats implied by the intervals, and
+ * quantized_ecg is handled as by ecg_prepare_model_inputs_from_detector().
+ */
+int ecg_prepare_model_inputs_from_intervals(struct ecg_sample_window *window,
+					    const float *intervals_ms, size_t interval_count,
+					    int8_t *quantized_ecg,
+					    struct ecg_processing_result *result);
+
 #endif /* TINYCARDIA_ECG_PROCESSING_H_ */
@@ -22,47 +22,190 @@ enum ecg_rr_feature_index {
 	ECG_RR_SD2_MS,
 };
 
+enum ecg_signal_quality {
+	/* Clean enough to classify. */
+	ECG_SIGNAL_QUALITY_GOOD,
+	/* Classified, but the result is reported as from a poor-quality window. */
+	ECG_SIGNAL_QUALITY_POOR,
+	/* Not worth R-peak detection or inference. */
+	ECG_SIGNAL_QUALITY_UNUSABLE,
+};
+
+/**
+ * Signal-quality index (SQI) of one window, accumulated as its samples are
+ * captured. Saturated samples are within 1/32 of either MAX30003 rail; the
+ * longest flat run counts consecutive samples that moved by at most half a
+ * microvolt. noise_permille is the energy of the second difference relative to
+ * that of the first difference, which grows with the share of high-frequency
+ * content: below 250 for QRS content under 20 Hz, about 1330 for 50 Hz mains,
+ * and 3000 for white noise. baseline_drift_uv is the range of a 0.5-second
+ * baseline over the window.
+ */
+struct ecg_signal_quality_index {
+	enum ecg_signal_quality level;
+	size_t saturated_sample_count;
+	size_t longest_flat_sample_count;
+	uint32_t noise_permille;
+	uint32_t baseline_drift_uv;
+};
+
 /**
- * Prepared model inputs for one non-overlapping ECG window.
+ * Prepared model inputs for one ECG window. Windows do not overlap unless
+ * CONFIG_TINYCARDIA_ECG_WINDOW_HOP_SAMPLES is shorter than the window.
  *
  * The ECG samples and RR features are standardized using the same constants as
  * the model-training pipeline. The unscaled RR features are provided for
- * diagnostics. All pointers remain valid only for the duration of the handler.
+ * diagnostics. filled_sample_count counts samples bridged across short
+ * acquisition gaps by ecg_processor_submit_gap().
+ *
+ * When a model input was set with ecg_processor_set_model_input(), the ECG
+ * samples are quantized straight into it: ecg_quantized_samples points there
+ * and ecg_samples is NULL. Otherwise ecg_quantized_samples is NULL. With
+ * CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES windows hold 16-bit samples and are
+ * only prepared into a model input.
+ *
+ * A window containing fast-recovery or lead-off samples, or whose signal
+ * quality is ECG_SIGNAL_QUALITY_UNUSABLE, is not usable: it is reported with
+ * usable false and its per-sample quality counts, but it is not preprocessed,
+ * so the sample, feature, and R-peak fields are empty. All pointers remain
+ * valid only for the duration of the handler.
+ *
+ * streamed is true when every chunk of the window was passed to the chunk
+ * handler, quantized with the statistics of the previous window, and the
+ * window's own statistics are within
+ * CONFIG_TINYCARDIA_ECG_STREAM_STATS_TOLERANCE_PERMILLE of those. The exactly
+ * quantized samples are still written to the model input.
+ *
+ * start_sample is the position of the window's first sample in the captured
+ * stream, counted in whole hops, so consecutive overlapping windows differ by
+ * the hop; it is zero for non-overlapping windows. With
+ * CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS a window quantized with the same
+ * reference statistics as the one before it gives the samples they share the
+ * same INT8 values.
  */
 struct ecg_prepared_window {
 	const float *ecg_samples;
+	const int8_t *ecg_quantized_samples;
 	const float *rr_features;
 	const float *rr_features_unscaled;
 	size_t sample_count;
+	size_t filled_sample_count;
+	size_t fast_recovery_sample_count;
+	size_t lead_off_sample_count;
+	struct ecg_signal_quality_index quality;
+	bool usable;
 	size_t r_peak_count;
 	bool rr_features_valid;
 	uint32_t start_timestamp_ms;
 	uint32_t end_timestamp_ms;
 	uint32_t preparation_time_us;
+	uint32_t start_sample;
+	bool streamed;
 };
 
 typedef void (*ecg_window_handler_t)(const struct ecg_prepared_window *window, void *user_data);
 
+typedef void (*ecg_chunk_handler_t)(const int8_t *quantized_samples, size_t offset, size_t count,
+				    void *user_data);
+
 /**
  * Initialize the ECG window processor.
  *
  * The window handler runs on the ECG processing thread and owns its completed
  * slot until it returns. Acquisition concurrently fills the second slot, so
- * normal preprocessing does not create a sampling gap.
+ * normal preprocessing does not create a sampling gap. With overlapping
+ * windows, acquisition fills a ring instead and the handler owns a copy.
  */
 int ecg_processor_init(ecg_window_handler_t window_handler, void *user_data);
 
+/**
+ * Quantize each usable window's ECG samples directly into ecg_input, which
+ * holds ECG_PROCESSOR_WINDOW_SIZE values, in the same pass that standardizes
+ * them. Use it for the model's INT8 input tensor so no float copy of the
+ * window is made. NULL restores standardized float samples.
+ *
+ * The buffer is written only on the ECG processing thread, before the window
+ * handler runs, so the handler may consume it in place.
+ */
+void ecg_processor_set_model_input(int8_t *ecg_input);
+
+/**
+ * Prepare overlapping windows in memory borrowed from the caller, such as the
+ * scratch region of the tensor arena, instead of a static workspace. It needs
+ * sizeof(struct ecg_processing_workspace) bytes with that structure's
+ * alignment.
+ *
+ * Only the ECG processing thread uses the memory, and only while it prepares a
+ * window, before the window handler runs, so the handler may overwrite it, for
+ * example by running inference. Windows are not prepared until it is set.
+ * Returns -ENOTSUP without CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE.
+ */
+int ecg_processor_set_workspace(void *memory, size_t size);
+
+/**
+ * Pass each CONFIG_TINYCARDIA_ECG_STREAM_CHUNK_SAMPLES chunk of the window
+ * being captured to handler once it is complete, quantized to the model's
+ * INT8 ECG input with the previous window's statistics. offset is the chunk's
+ * first sample in the window; chunks of one window arrive in order starting at
+ * offset 0, and a new offset 0 abandons any window left unfinished.
+ *
+ * The handler runs on the ECG processing thread, and all chunks of a window
+ * reach it before the window handler runs. Windows captured before any
+ * previous window completed, such as the first after monitoring starts, are
+ * not streamed. Returns -ENOTSUP without CONFIG_TINYCARDIA_ECG_STREAMING.
+ */
+int ecg_processor_set_chunk_handler(ecg_chunk_handler_t handler, void *user_data);
+
 /** Start or stop normal 10-second window capture and preprocessing. */
 int ecg_processor_set_monitoring(bool enabled);
 
 /**
  * Submit one acquired sample with its acquisition timestamp.
  *
- * Returns true when the analysis path preserved the sample and false when
- * monitoring was stopped or both bounded window slots were occupied.
+ * The FIFO tag in raw_word marks fast-recovery samples. Returns true when the
+ * analysis path preserved the sample and false when monitoring was stopped or
+ * both bounded window slots were occupied. The overlapping-window ring never
+ * refuses a sample while monitoring.
  */
 bool ecg_processor_submit_sample(uint32_t raw_word, uint32_t timestamp_ms);
 
+/**
+ * Submit a contiguous batch of samples acquired at the deterministic sample
+ * rate, starting at first_timestamp_ms.
+ *
+ * The capture lock is taken once per window segment rather than per sample.
+ * Returns how many of the samples the analysis path preserved.
+ */
+size_t ecg_processor_submit_samples(const uint32_t *raw_words, size_t count,
+				    uint32_t first_timestamp_ms);
+
+/**
+ * Account for samples lost upstream between the previous and the next
+ * submitted sample.
+ *
+ * Gaps of at most CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES inside a window
+ * are bridged by holding the last captured value, which keeps the window's
+ * sample timing and RR intervals intact. A longer gap restarts the window
+ * being captured. Returns false when a partial window was discarded.
+ */
+bool ecg_processor_submit_gap(uint32_t missing_samples);
+
+/**
+ * Mark samples submitted from now on as acquired with electrodes off (or back
+ * on). Call it from the acquisition context, in order with the samples.
+ */
+void ecg_processor_set_lead_off(bool lead_off);
+
+/**
+ * Submit one hardware R-to-R interval for the window currently being captured.
+ *
+ * With CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003 these intervals replace
+ * software R-peak detection. An interval may end a beat that started in the
+ * previous window, so RR timing is continuous across window boundaries.
+ * Returns false when the interval was not retained.
+ */
+bool ecg_processor_submit_rr_interval(float interval_ms);
+
 /** Compatibility callback using current uptime as the sample timestamp. */
 void ecg_processor_sample_handler(uint32_t raw_word, void *user_data);
 
@@ -2,16 +2,27 @@
 #define TINYCARDIA_INFERENCE_POLICY_H_
 
 #include "ble_protocol.h"
+#include "ecg_processor.h"
 #include <stdbool.h>
 #include <stdint.h>
 
 static inline bool
 tinycardia_inference_window_is_eligible(bool rr_features_valid,
+					enum ecg_signal_quality window_quality,
 					enum tinycardia_signal_quality current_quality,
 					uint64_t window_start_ms, uint64_t quality_good_since_ms)
 {
-	return rr_features_valid && current_quality == TINYCARDIA_SIGNAL_QUALITY_GOOD &&
+	return rr_features_valid && window_quality != ECG_SIGNAL_QUALITY_UNUSABLE &&
+	       current_quality == TINYCARDIA_SIGNAL_QUALITY_GOOD &&
 	       window_start_ms >= quality_good_since_ms;
 }
 
+/* Quality reported with a classification, from the window's own signal-quality index. */
+static inline enum tinycardia_signal_quality
+tinycardia_inference_reported_quality(enum ecg_signal_quality window_quality)
+{
+	return window_quality == ECG_SIGNAL_QUALITY_GOOD ? TINYCARDIA_SIGNAL_QUALITY_GOOD
+							 : TINYCARDIA_SIGNAL_QUALITY_POOR;
+}
+
 #endif /* TINYCARDIA_INFERENCE_POLICY_H_ */
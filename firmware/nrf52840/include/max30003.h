@@ -2,11 +2,22 @@
 #define TINYCARDIA_MAX30003_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#define MAX30003_SAMPLE_RATE_HZ 256U
+
 typedef void (*max30003_sample_handler_t)(uint32_t raw_word, uint32_t timestamp_ms,
 					 void *user_data);
 
+/*
+ * One contiguous batch of FIFO words from a single FIFO service. Sample n was
+ * acquired at max30003_block_timestamp_ms(first_timestamp_ms, n), to within a
+ * millisecond of rounding.
+ */
+typedef void (*max30003_sample_block_handler_t)(const uint32_t *words, size_t count,
+						uint32_t first_timestamp_ms, void *user_data);
+
 enum max30003_lead_status {
 	MAX30003_LEAD_STATUS_GOOD,
 	MAX30003_LEAD_STATUS_NEGATIVE_OFF,
@@ -17,7 +28,31 @@ enum max30003_lead_status {
 
 typedef void (*max30003_lead_status_handler_t)(enum max30003_lead_status status,
 					       void *user_data);
-typedef void (*max30003_drop_handler_t)(uint32_t minimum_dropped, void *user_data);
+typedef void (*max30003_drop_handler_t)(uint32_t dropped_samples, void *user_data);
+
+/*
+ * One R-to-R interval from the on-chip RTOR detector. timestamp_ms is the
+ * acquisition time of the FIFO position at which the beat was reported.
+ */
+typedef void (*max30003_rr_interval_handler_t)(float interval_ms, uint32_t timestamp_ms,
+					       void *user_data);
+
+/*
+ * Latency from the FIFO interrupt to the start of its service on the
+ * acquisition work queue. The FIFO holds 32 samples (125 ms), so the margin
+ * left by a threshold of N samples is (32 - N) / 256 s minus this latency.
+ */
+struct max30003_fifo_service_stats {
+	uint32_t services;
+	uint32_t last_latency_us;
+	uint32_t max_latency_us;
+};
+
+/* Timestamp of sample index within a block delivered at first_timestamp_ms. */
+static inline uint32_t max30003_block_timestamp_ms(uint32_t first_timestamp_ms, size_t index)
+{
+	return first_timestamp_ms + (uint32_t)(((uint64_t)index * 1000U) / MAX30003_SAMPLE_RATE_HZ);
+}
 
 /* Initializes SPI, INT1, and the ECG acquisition registers. */
 int max30003_init(max30003_sample_handler_t sample_handler, void *user_data);
@@ -32,9 +67,38 @@ bool max30003_is_monitoring(void);
 void max30003_set_lead_status_handler(max30003_lead_status_handler_t handler,
 				      void *user_data);
 
-/* Register for FIFO discontinuities; the count is a conservative lower bound. */
+/*
+ * Register for FIFO discontinuities. The count is the number of samples missing
+ * before the next delivered sample, measured against the tick-based sample
+ * clock; timestamps continue across the gap as if they had been delivered.
+ */
 void max30003_set_drop_handler(max30003_drop_handler_t handler, void *user_data);
 
+/*
+ * Register for hardware R-to-R intervals. Intervals are reported only with
+ * CONFIG_TINYCARDIA_MAX30003_RTOR, which adds RRINT to the INT1 sources.
+ */
+void max30003_set_rr_interval_handler(max30003_rr_interval_handler_t handler,
+				      void *user_data);
+
+/*
+ * Register for whole FIFO batches instead of single samples. While set, the
+ * per-sample handler passed to max30003_init() is not called. The handler may
+ * be registered before max30003_init().
+ */
+void max30003_set_sample_block_handler(max30003_sample_block_handler_t handler,
+				       void *user_data);
+
+/*
+ * Change the number of unread FIFO samples (1..32) that raise INT1 and form
+ * one batch. Returns -ENOTSUP when DMA capture fixed the burst length at init.
+ */
+int max30003_set_fifo_threshold(uint8_t samples);
+
+/* Snapshot the FIFO service latency measured since init or the last reset. */
+void max30003_get_fifo_service_stats(struct max30003_fifo_service_stats *stats);
+void max30003_reset_fifo_service_stats(void);
+
 int max30003_read_register(uint8_t reg, uint32_t *value);
 int max30003_write_register(uint8_t reg, uint32_t value);
 int max30003_sanity_check(uint32_t *info);
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TINYCARDIA_MAX30003_DMA_H_
+#define TINYCARDIA_MAX30003_DMA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Largest burst one INT1 edge can request: the full 32-word ECG FIFO. */
+#define MAX30003_DMA_MAX_BURST_WORDS 32U
+
+/* Runs in the capture TIMER ISR when one half of the burst ring is full. */
+typedef void (*max30003_dma_ready_handler_t)(void);
+
+/*
+ * Receives the FIFO words of one captured burst, in capture order. edge_ticks
+ * is the uptime tick of the INT1 edge that started the burst, or -1 when it is
+ * unknown; only the last burst of a ring half is timed, by its interrupt.
+ */
+typedef void (*max30003_dma_burst_handler_t)(const uint32_t *words, size_t word_count,
+					     int64_t edge_ticks);
+
+/*
+ * Hardware-triggered FIFO capture for the nRF52 SPIM.
+ *
+ * Each INT1 edge starts a pre-armed EasyDMA burst read through GPIOTE and PPI,
+ * with chip select driven by a GPIOTE task. A TIMER counts completed bursts,
+ * and the CPU is interrupted only when one half of the burst ring is full.
+ * Control calls must be serialized by the caller.
+ */
+int max30003_dma_init(max30003_dma_ready_handler_t ready_handler, uint8_t burst_command,
+		      size_t burst_words);
+
+/* Arm capture on an empty ring, starting one burst if INT1 is already active. */
+int max30003_dma_start(void);
+
+/* Disarm capture; bursts not yet drained are discarded. */
+void max30003_dma_stop(void);
+
+/*
+ * Return SPIM and chip select to the Zephyr SPI driver around a register
+ * access, waiting only for a burst already in flight. Resume continues at the
+ * same ring position, so no burst is lost.
+ */
+void max30003_dma_pause(void);
+void max30003_dma_resume(void);
+
+/*
+ * Opaque ring position of the next burst, read while capture is paused.
+ * Every burst before it was captured before the pause.
+ */
+uint32_t max30003_dma_position(void);
+
+/*
+ * Return and clear the number of FIFO words overwritten before they could be
+ * drained. The lost words are older than every burst a following drain delivers.
+ */
+uint32_t max30003_dma_take_overrun_words(void);
+
+/*
+ * Deliver every burst captured before position to handler, oldest first,
+ * including those of a half that is still filling. Later bursts stay for the
+ * next drain.
+ */
+void max30003_dma_drain(max30003_dma_burst_handler_t handler, uint32_t position);
+
+#endif /* TINYCARDIA_MAX30003_DMA_H_ */
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TINYCARDIA_MAX30003_DMA_RING_H_
+#define TINYCARDIA_MAX30003_DMA_RING_H_
+
+#include "max30003_dma.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX30003_DMA_RING_HALVES     2U
+#define MAX30003_DMA_BURSTS_PER_HALF CONFIG_TINYCARDIA_MAX30003_DMA_BURSTS_PER_WAKE
+#define MAX30003_DMA_COMMAND_SIZE    1U
+#define MAX30003_DMA_WORD_SIZE       3U
+#define MAX30003_DMA_MAX_RECORD_SIZE                                                       \
+	(MAX30003_DMA_COMMAND_SIZE + MAX30003_DMA_MAX_BURST_WORDS * MAX30003_DMA_WORD_SIZE)
+
+/*
+ * Hardware-independent half of the DMA capture: the two-half burst ring, its
+ * positions, overrun accounting, and draining.
+ *
+ * Each burst record holds the byte received during the command byte, then
+ * the burst's 24-bit FIFO words, most significant byte first, exactly as the
+ * SPIM receives them. The capture side writes records at
+ * max30003_dma_ring_burst() and calls max30003_dma_ring_complete_half() from
+ * its interrupt once the active half is full; a single thread drains.
+ */
+void max30003_dma_ring_init(size_t burst_words);
+
+/* Bytes of one burst record; records of a half are packed back to back. */
+size_t max30003_dma_ring_record_size(void);
+
+/* Empty the ring, clear the overrun count, and make the first half active. */
+void max30003_dma_ring_reset(void);
+
+/* Drop completed halves that were not drained yet. */
+void max30003_dma_ring_discard(void);
+
+uint8_t *max30003_dma_ring_burst(uint8_t half, uint32_t burst);
+
+/* Half the capture side is filling. */
+uint8_t max30003_dma_ring_active_half(void);
+
+/*
+ * Mark the active half complete, its last burst started by the INT1 edge at
+ * edge_ticks or -1 when unknown, and return the half that becomes active.
+ * Bursts of that half that were never drained are counted as overrun.
+ */
+uint8_t max30003_dma_ring_complete_half(int64_t edge_ticks);
+
+/* Position of the next burst when burst bursts of the active half are captured. */
+uint32_t max30003_dma_ring_position(uint32_t burst);
+
+uint32_t max30003_dma_ring_take_overrun_words(void);
+
+/* max30003_dma_drain() on the ring. */
+void max30003_dma_ring_drain(max30003_dma_burst_handler_t handler, uint32_t position);
+
+#endif /* TINYCARDIA_MAX30003_DMA_RING_H_ */
@@ -0,0 +1,179 @@
+#ifndef TINYCARDIA_MODEL_AOT_H_
+#define TINYCARDIA_MODEL_AOT_H_
+
+#include "model_contract.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Ahead-of-time compiled AFib model.
+ *
+ * scripts/tflite_aot.py lowers every operator of the canonical artifact to one
+ * kernel call with constant parameters, computed the way TFLM prepares the
+ * same operator, and plans all activations into one static arena. RESHAPE and
+ * EXPAND_DIMS only reinterpret their input and generate no code.
+ */
+
+/** Per-channel quantized CONV_2D over NHWC activations with OHWI weights. */
+struct tinycardia_aot_conv {
+	const int8_t *weights;
+	const int32_t *bias;
+	const int32_t *multipliers;
+	const int32_t *shifts;
+	int32_t input_height;
+	int32_t input_width;
+	int32_t input_channels;
+	int32_t output_height;
+	int32_t output_width;
+	int32_t output_channels;
+	int32_t kernel_height;
+	int32_t kernel_width;
+	int32_t stride_height;
+	int32_t stride_width;
+	int32_t padding_height;
+	int32_t padding_width;
+	int32_t input_offset;
+	int32_t output_offset;
+	int32_t activation_min;
+	int32_t activation_max;
+};
+
+struct tinycardia_aot_pool {
+	int32_t input_height;
+	int32_t input_width;
+	int32_t channels;
+	int32_t output_height;
+	int32_t output_width;
+	int32_t filter_height;
+	int32_t filter_width;
+	int32_t stride_height;
+	int32_t stride_width;
+	int32_t padding_height;
+	int32_t padding_width;
+	int32_t activation_min;
+	int32_t activation_max;
+};
+
+/**
+ * MEAN over the middle of [outer, reduced, inner] values. The multiplier and
+ * shift already include the division by reduced_count.
+ */
+struct tinycardia_aot_mean {
+	int32_t outer_count;
+	int32_t reduced_count;
+	int32_t inner_count;
+	int32_t input_zero_point;
+	int32_t output_zero_point;
+	int32_t multiplier;
+	int32_t shift;
+};
+
+/** Per-channel quantized FULLY_CONNECTED with [output][input] weights. */
+struct tinycardia_aot_fully_connected {
+	const int8_t *weights;
+	const int32_t *bias;
+	const int32_t *multipliers;
+	const int32_t *shifts;
+	int32_t batches;
+	int32_t input_count;
+	int32_t output_count;
+	int32_t input_offset;
+	int32_t output_offset;
+	int32_t activation_min;
+	int32_t activation_max;
+};
+
+struct tinycardia_aot_softmax {
+	int32_t rows;
+	int32_t row_size;
+	int32_t input_multiplier;
+	int32_t input_left_shift;
+	int32_t diff_min;
+};
+
+struct tinycardia_aot_operator {
+	const char *name;
+	/* NULL when the operator only reinterprets its input's shape. */
+	int (*invoke)(void);
+};
+
+#define TINYCARDIA_AOT_MAX_STREAM_STAGES 4U
+
+/**
+ * One stage of the convolutional front end run while a window is captured:
+ * a 1-D CONV_2D, optionally followed by the MAX_POOL_2D that consumes it.
+ * input holds the conv input with its SAME padding, kernel_width - 1
+ * columns, stored around the input_width columns of samples.
+ */
+struct tinycardia_aot_stage {
+	const struct tinycardia_aot_conv *conv;
+	const struct tinycardia_aot_pool *pool;
+	int8_t *input;
+};
+
+/**
+ * Streaming form of the front end, from the ECG input to the activation the
+ * remaining operators read. The last stage writes output, which is copied to
+ * tail_input before operators from tail_operator on run. Convolutions advance
+ * in bands of at most band_columns output columns, computed in band when a
+ * pool follows.
+ */
+struct tinycardia_aot_stream {
+	const struct tinycardia_aot_stage *stages;
+	size_t stage_count;
+	int8_t *output;
+	size_t output_size;
+	int8_t *tail_input;
+	size_t tail_operator;
+	int8_t *band;
+	int32_t band_columns;
+	void *scratch;
+	size_t scratch_size;
+};
+
+/*
+ * Kernels, in model_aot_kernels.c. With CONFIG_TINYCARDIA_MODEL_AOT_CMSIS_NN
+ * the convolution, pooling, and softmax calls run on CMSIS-NN; otherwise all
+ * kernels are portable C that matches the TFLM reference kernels bit for bit.
+ * Each returns 0 or a negative errno.
+ */
+size_t tinycardia_aot_conv_scratch_size(const struct tinycardia_aot_conv *conv);
+int tinycardia_aot_conv_s8(const struct tinycardia_aot_conv *conv, const int8_t *input,
+			   int8_t *output, void *scratch, size_t scratch_size);
+int tinycardia_aot_max_pool_s8(const struct tinycardia_aot_pool *pool, const int8_t *input,
+			       int8_t *output);
+int tinycardia_aot_mean_s8(const struct tinycardia_aot_mean *mean, const int8_t *input,
+			   int8_t *output);
+int tinycardia_aot_fully_connected_s8(const struct tinycardia_aot_fully_connected *fc,
+				      const int8_t *input, int8_t *output);
+int tinycardia_aot_softmax_s8(const struct tinycardia_aot_softmax *softmax, const int8_t *input,
+			      int8_t *output);
+
+/* Generated from the canonical artifact at build time. */
+extern int8_t tinycardia_aot_ecg_input[TINYCARDIA_MODEL_ECG_COUNT];
+extern int8_t tinycardia_aot_rr_input[TINYCARDIA_MODEL_RR_COUNT];
+extern int8_t *const tinycardia_aot_output;
+extern int8_t tinycardia_aot_arena[];
+extern const size_t tinycardia_aot_arena_size;
+extern const struct tinycardia_aot_operator
+	tinycardia_aot_operators[TINYCARDIA_MODEL_OPERATOR_COUNT];
+#if defined(CONFIG_TINYCARDIA_MODEL_AOT_FRONT_END)
+extern const struct tinycardia_aot_stream tinycardia_aot_stream;
+#endif
+
+/**
+ * Check that every kernel's scratch fits the space planned for it in the
+ * arena. Returns -ENOMEM when a kernel build needs more than planned.
+ */
+int tinycardia_aot_prepare(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TINYCARDIA_MODEL_AOT_H_ */
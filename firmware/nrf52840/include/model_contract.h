@@ -4,9 +4,10 @@
 #include <math.h>
 #include <stdint.h>
 
-#define TINYCARDIA_MODEL_ECG_COUNT   2560U
-#define TINYCARDIA_MODEL_RR_COUNT    7U
-#define TINYCARDIA_MODEL_CLASS_COUNT 2U
+#define TINYCARDIA_MODEL_ECG_COUNT      2560U
+#define TINYCARDIA_MODEL_RR_COUNT       7U
+#define TINYCARDIA_MODEL_CLASS_COUNT    2U
+#define TINYCARDIA_MODEL_OPERATOR_COUNT 21U
 
 #define TINYCARDIA_MODEL_RR_SCALE          0.014579945243895054f
 #define TINYCARDIA_MODEL_RR_ZERO_POINT     (-27)
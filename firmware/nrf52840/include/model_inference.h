@@ -18,7 +18,23 @@ struct tinycardia_model_result {
 	uint32_t invoke_time_us;
 };
 
-/** Initialize TFLM and validate the complete embedded model contract. */
+/** Cycles spent in one operator of the model graph, summed over inferences. */
+struct tinycardia_model_operator_profile {
+	const char *name;
+	uint64_t cycles;
+};
+
+struct tinycardia_model_profile {
+	uint32_t invocations;
+	uint32_t cycles_per_second;
+	struct tinycardia_model_operator_profile operators[TINYCARDIA_MODEL_OPERATOR_COUNT];
+};
+
+/**
+ * Initialize the selected engine: TFLM validates the complete embedded model
+ * contract, the ahead-of-time graph was validated when it was generated. Both
+ * run the zero-input self-test.
+ */
 int tinycardia_model_init(void);
 
 /**
@@ -30,6 +46,81 @@ int tinycardia_model_init(void);
 int tinycardia_model_infer(const float *ecg, size_t ecg_count, const float *rr_features,
 			   size_t rr_count, struct tinycardia_model_result *result);
 
+/**
+ * INT8 ECG input tensor of TINYCARDIA_MODEL_ECG_COUNT values, quantized with
+ * TINYCARDIA_MODEL_ECG_SCALE and TINYCARDIA_MODEL_ECG_ZERO_POINT.
+ *
+ * Preprocessing may write the quantized window here directly instead of
+ * passing floats to tinycardia_model_infer(). Only the ECG processing thread
+ * writes it, and only between inferences. Returns NULL before initialization.
+ */
+int8_t *tinycardia_model_ecg_input(void);
+
+/**
+ * Quantize the RR features and run inference on the ECG window already written
+ * to tinycardia_model_ecg_input(). Same thread and result rules as
+ * tinycardia_model_infer().
+ */
+int tinycardia_model_infer_quantized(const float *rr_features, size_t rr_count,
+				     struct tinycardia_model_result *result);
+
+/**
+ * Activation memory of the tensor arena that holds no live tensor between
+ * inferences, with its size in *size; NULL before initialization.
+ *
+ * Between two Invoke() calls only the input tensors hold data in the arena's
+ * non-persistent region, so preprocessing may use this memory as scratch
+ * while it prepares the next inputs. Every inference overwrites it, and only
+ * the ECG processing thread, which runs inference, may use it.
+ */
+void *tinycardia_model_scratch(size_t *size);
+
+/**
+ * Copy the per-operator cycle counts accumulated since initialization, in
+ * graph order. The startup self-test is not included. Returns -ENOTSUP without
+ * CONFIG_TINYCARDIA_MODEL_PROFILING and -EACCES before initialization.
+ */
+int tinycardia_model_get_profile(struct tinycardia_model_profile *profile);
+
+/**
+ * Stream count quantized ECG samples, starting at sample offset of the
+ * window, into the model and run every front-end convolution and pooling
+ * column they complete. Offset zero starts a new window; any other offset
+ * must continue the previous call. Samples use the scale and zero point of
+ * tinycardia_model_ecg_input(), which is left untouched.
+ *
+ * Called only from the ECG processing thread, between inferences. Returns
+ * -EINVAL for samples out of order or past the window, and -ENOTSUP without
+ * CONFIG_TINYCARDIA_MODEL_STREAMING.
+ */
+int tinycardia_model_stream_append(const int8_t *ecg, size_t offset, size_t count);
+
+/**
+ * Finish inference on the window streamed with tinycardia_model_stream_append():
+ * the convolution columns that waited for the last samples, then the rest of
+ * the graph. The result matches tinycardia_model_infer_quantized() on the same
+ * samples exactly; its invoke_time_us covers only this step. Returns -ENODATA
+ * unless a complete window was streamed, which a successful call consumes.
+ */
+int tinycardia_model_stream_finish(const float *rr_features, size_t rr_count,
+				   struct tinycardia_model_result *result);
+
+/**
+ * Run inference on the ECG window already written to
+ * tinycardia_model_ecg_input(), which starts at start_sample of the monitored
+ * stream, reusing the front-end activations of the previous window where the
+ * two overlap. Reuse needs the window to move forward by a multiple of the
+ * front end's pooling strides and the overlapping samples to be identical;
+ * otherwise the whole front end runs. The result always matches
+ * tinycardia_model_infer_quantized() on the same samples exactly.
+ *
+ * Same thread rules as tinycardia_model_stream_append(). Returns the number of
+ * samples whose activations were reused, zero for a full front end, or a
+ * negative errno; -ENOTSUP without CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE.
+ */
+int tinycardia_model_infer_window(uint32_t start_sample, const float *rr_features,
+				  size_t rr_count, struct tinycardia_model_result *result);
+
 /** Actual bytes used within the statically allocated tensor arena. */
 size_t tinycardia_model_arena_used_bytes(void);
 
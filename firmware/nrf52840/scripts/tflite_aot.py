@@ -0,0 +1,800 @@
+#!/usr/bin/env python3
+"""Compile the Tinycardia AFib TFLite model ahead of time into C.
+
+Usage: tflite_aot.py MODEL.tflite OUTPUT.c
+
+Every operator of the single subgraph is lowered to one call of a kernel in
+src/model_aot_kernels.c with constant parameters, and every activation is
+placed in one statically planned arena. Quantization parameters are computed
+the way TFLM prepares the same operators, so the generated graph produces the
+interpreter's output bit for bit. Only the operators and layouts of the
+canonical artifact are supported; anything else stops the build.
+
+The chain of 1-D convolutions and poolings fed by the ECG input is also
+described as stages with their own padded buffers, so that with
+CONFIG_TINYCARDIA_MODEL_STREAMING it can run band by band while a window is
+captured, and with CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE keep the columns one
+sliding window shares with the next; only the operators after it wait for the
+complete window.
+
+The script uses the Python standard library only.
+"""
+
+import math
+import struct
+import sys
+
+ARENA_ALIGNMENT = 16
+# Output columns per streamed convolution call; a multiple of every pool stride.
+STREAM_BAND_COLUMNS = 64
+MAX_STREAM_STAGES = 4
+
+TENSOR_INT32 = 2
+TENSOR_INT8 = 9
+
+OP_CONCATENATION = 2
+OP_CONV_2D = 3
+OP_FULLY_CONNECTED = 9
+OP_MAX_POOL_2D = 17
+OP_RESHAPE = 22
+OP_SOFTMAX = 25
+OP_MEAN = 40
+OP_EXPAND_DIMS = 70
+
+OPERATOR_NAMES = {
+    OP_CONCATENATION: "CONCATENATION",
+    OP_CONV_2D: "CONV_2D",
+    OP_FULLY_CONNECTED: "FULLY_CONNECTED",
+    OP_MAX_POOL_2D: "MAX_POOL_2D",
+    OP_RESHAPE: "RESHAPE",
+    OP_SOFTMAX: "SOFTMAX",
+    OP_MEAN: "MEAN",
+    OP_EXPAND_DIMS: "EXPAND_DIMS",
+}
+
+PADDING_SAME = 0
+ACTIVATION_NONE = 0
+ACTIVATION_RELU = 1
+ACTIVATION_RELU6 = 3
+
+RR_INPUT_NAME = "serving_default_rr_features:0"
+ECG_INPUT_NAME = "serving_default_ecg_signal:0"
+OUTPUT_NAME = "StatefulPartitionedCall_1:0"
+
+
+class CompileError(Exception):
+    pass
+
+
+def require(condition, message):
+    if not condition:
+        raise CompileError(message)
+
+
+class Table:
+    """Read-only view of one FlatBuffer table."""
+
+    def __init__(self, data, position):
+        self.data = data
+        self.position = position
+        self.vtable = position - struct.unpack_from("<i", data, position)[0]
+        self.vtable_size = struct.unpack_from("<H", data, self.vtable)[0]
+
+    def _field(self, index):
+        offset = 4 + 2 * index
+        if offset >= self.vtable_size:
+            return 0
+        return struct.unpack_from("<H", self.data, self.vtable + offset)[0]
+
+    def _indirect(self, index):
+        offset = self._field(index)
+        if not offset:
+            return None
+        position = self.position + offset
+        return position + struct.unpack_from("<I", self.data, position)[0]
+
+    def scalar(self, index, fmt, default=0):
+        offset = self._field(index)
+        if not offset:
+            return default
+        return struct.unpack_from("<" + fmt, self.data, self.position + offset)[0]
+
+    def table(self, index):
+        position = self._indirect(index)
+        return None if position is None else Table(self.data, position)
+
+    def _vector(self, index):
+        position = self._indirect(index)
+        if position is None:
+            return None, 0
+        return position + 4, struct.unpack_from("<I", self.data, position)[0]
+
+    def tables(self, index):
+        start, count = self._vector(index)
+        result = []
+        for item in range(count):
+            position = start + 4 * item
+            result.append(
+                Table(self.data, position + struct.unpack_from("<I", self.data, position)[0]))
+        return result
+
+    def scalars(self, index, fmt):
+        start, count = self._vector(index)
+        if start is None:
+            return []
+        return list(struct.unpack_from("<%d%s" % (count, fmt), self.data, start))
+
+    def raw(self, index):
+        start, count = self._vector(index)
+        return b"" if start is None else self.data[start:start + count]
+
+    def string(self, index):
+        return self.raw(index).decode()
+
+
+class Tensor:
+    def __init__(self, index, table, buffers):
+        self.index = index
+        self.shape = table.scalars(0, "i")
+        self.type = table.scalar(1, "b")
+        self.name = table.string(3)
+        self.data = buffers[table.scalar(2, "I")].raw(0)
+        quantization = table.table(4)
+        self.scales = quantization.scalars(2, "f") if quantization else []
+        self.zero_points = quantization.scalars(3, "q") if quantization else []
+
+    @property
+    def count(self):
+        return math.prod(self.shape)
+
+    @property
+    def scale(self):
+        require(len(self.scales) == 1, "tensor %s is not per-tensor quantized" % self.name)
+        return self.scales[0]
+
+    @property
+    def zero_point(self):
+        require(len(self.zero_points) == 1,
+                "tensor %s is not per-tensor quantized" % self.name)
+        return self.zero_points[0]
+
+    def values(self):
+        if self.type == TENSOR_INT8:
+            return list(struct.unpack("<%db" % len(self.data), self.data))
+        require(self.type == TENSOR_INT32, "constant %s has unsupported type" % self.name)
+        return list(struct.unpack("<%di" % (len(self.data) // 4), self.data))
+
+
+class Operator:
+    def __init__(self, index, table, opcodes):
+        code = opcodes[table.scalar(0, "I")]
+        self.index = index
+        self.code = max(code.scalar(0, "b"), code.scalar(3, "i"))
+        self.inputs = table.scalars(1, "i")
+        self.outputs = table.scalars(2, "i")
+        self.options = table.table(4)
+        require(self.code in OPERATOR_NAMES, "operator %d has unsupported code %d" %
+                (index, self.code))
+        self.name = OPERATOR_NAMES[self.code]
+
+    def option(self, index, fmt, default=0):
+        if self.options is None:
+            return default
+        return self.options.scalar(index, fmt, default)
+
+
+def tflite_round(value):
+    """std::round(): halves away from zero."""
+    return int(math.floor(abs(value) + 0.5)) * (1 if value >= 0 else -1)
+
+
+def quantize_multiplier(real_multiplier):
+    """tflite::QuantizeMultiplier()."""
+    if real_multiplier == 0.0:
+        return 0, 0
+    fraction, shift = math.frexp(real_multiplier)
+    fixed = tflite_round(fraction * (1 << 31))
+    if fixed == 1 << 31:
+        fixed //= 2
+        shift += 1
+    if shift < -31:
+        shift = 0
+        fixed = 0
+    return fixed, shift
+
+
+def activation_range(activation, scale, zero_point):
+    """tflite::CalculateActivationRangeQuantized() for INT8 outputs."""
+
+    def quantize(value):
+        return zero_point + tflite_round(value / scale)
+
+    if activation == ACTIVATION_NONE:
+        return -128, 127
+    if activation == ACTIVATION_RELU:
+        return max(-128, quantize(0.0)), 127
+    if activation == ACTIVATION_RELU6:
+        return max(-128, quantize(0.0)), min(127, quantize(6.0))
+    raise CompileError("unsupported fused activation %d" % activation)
+
+
+def padding(padding_type, input_size, filter_size, stride):
+    """Output size and leading padding, as tflite::ComputePaddingHeightWidth()."""
+    if padding_type == PADDING_SAME:
+        output_size = (input_size + stride - 1) // stride
+    else:
+        output_size = (input_size - filter_size + stride) // stride
+    total = (output_size - 1) * stride + filter_size - input_size
+    return output_size, max(total, 0) // 2
+
+
+def per_channel_multipliers(input_tensor, weights, output_tensor, channels):
+    """Per-channel output rescaling, as TFLM's CONV_2D and FULLY_CONNECTED Prepare()."""
+    require(all(zero_point == 0 for zero_point in weights.zero_points),
+            "weights %s are not symmetric" % weights.name)
+    scales = weights.scales if len(weights.scales) > 1 else weights.scales * channels
+    require(len(scales) == channels, "weights %s have a scale count mismatch" % weights.name)
+    multipliers = []
+    shifts = []
+    for scale in scales:
+        multiplier, shift = quantize_multiplier(
+            input_tensor.scale * scale / output_tensor.scale)
+        multipliers.append(multiplier)
+        shifts.append(shift)
+    return multipliers, shifts
+
+
+def softmax_parameters(beta, input_scale):
+    """tflite::PreprocessSoftmaxScaling() and CalculateInputRadius() with 5 integer bits."""
+    integer_bits = 5
+    real_multiplier = min(beta * input_scale * (1 << (31 - integer_bits)), (1 << 31) - 1.0)
+    multiplier, left_shift = quantize_multiplier(real_multiplier)
+    require(left_shift >= 0, "softmax input scale is too small")
+    radius = ((1 << integer_bits) - 1) * (1 << (31 - integer_bits)) / (1 << left_shift)
+    return multiplier, left_shift, -int(math.floor(radius))
+
+
+class Model:
+    def __init__(self, data):
+        root = Table(data, struct.unpack_from("<I", data, 0)[0])
+        subgraphs = root.tables(2)
+        require(len(subgraphs) == 1, "model must contain exactly one subgraph")
+        buffers = root.tables(4)
+        opcodes = root.tables(1)
+        subgraph = subgraphs[0]
+        self.tensors = [Tensor(index, table, buffers)
+                        for index, table in enumerate(subgraph.tables(0))]
+        self.inputs = subgraph.scalars(1, "i")
+        self.outputs = subgraph.scalars(2, "i")
+        self.operators = [Operator(index, table, opcodes)
+                          for index, table in enumerate(subgraph.tables(3))]
+
+
+class Compiler:
+    def __init__(self, model):
+        self.model = model
+        self.tensors = model.tensors
+        self.constants = []
+        self.functions = []
+        self.prepare_checks = []
+        self.table = []
+        # Activation buffers by root tensor, with the first and last operator using them.
+        self.alias = {}
+        self.lifetimes = {}
+        self.scratch = {}
+        # Descriptor names of the lowered CONV_2D and MAX_POOL_2D operators.
+        self.descriptors = {}
+
+    def tensor(self, index):
+        return self.tensors[index]
+
+    def root(self, index):
+        while index in self.alias:
+            index = self.alias[index]
+        return index
+
+    def check_contract(self):
+        names = [self.tensor(index).name for index in self.model.inputs]
+        require(names == [RR_INPUT_NAME, ECG_INPUT_NAME],
+                "unexpected model inputs %s" % names)
+        require([self.tensor(index).name for index in self.model.outputs] == [OUTPUT_NAME],
+                "unexpected model output")
+        self.rr_input, self.ecg_input = self.model.inputs
+        self.output = self.model.outputs[0]
+        for index in self.model.inputs + self.model.outputs:
+            require(self.tensor(index).type == TENSOR_INT8,
+                    "model input or output %s is not INT8" % self.tensor(index).name)
+
+    def use(self, index, operator):
+        index = self.root(index)
+        require(self.tensor(index).type == TENSOR_INT8,
+                "activation %s is not INT8" % self.tensor(index).name)
+        if index in self.model.inputs:
+            return
+        first, last = self.lifetimes.get(index, (operator, operator))
+        self.lifetimes[index] = (min(first, operator), max(last, operator))
+
+    def analyze_lifetimes(self):
+        for operator in self.model.operators:
+            if operator.code in (OP_RESHAPE, OP_EXPAND_DIMS):
+                source = self.tensor(operator.inputs[0])
+                target = self.tensor(operator.outputs[0])
+                require(source.count == target.count and
+                        source.scales == target.scales and
+                        source.zero_points == target.zero_points,
+                        "%s %d changes its data" % (operator.name, operator.index))
+                self.alias[operator.outputs[0]] = self.root(operator.inputs[0])
+                continue
+            for index in operator.inputs + operator.outputs:
+                if index >= 0 and not self.tensor(index).data:
+                    self.use(index, operator.index)
+            if operator.code == OP_CONV_2D:
+                # arm_convolve_s8()'s im2col buffer: two int16 columns padded to a
+                # multiple of four values on DSP cores, four int8 columns padded to
+                # eight-value lanes with MVE. Reserve the larger; prepare checks it
+                # against the size the linked CMSIS-NN build asks for.
+                output_channels, kernel_height, kernel_width, input_channels = \
+                    self.tensor(operator.inputs[1]).shape
+                columns = input_channels * kernel_height * kernel_width
+                dsp_size = 2 * ((columns + 3) // 4 * 4) * 2
+                mve_size = 4 * ((columns + 7) // 8 * 8)
+                self.scratch[operator.index] = align(max(dsp_size, mve_size))
+        # The output stays readable after the last operator.
+        self.use(self.output, len(self.model.operators))
+
+    def plan(self):
+        """Greedy first-fit placement, largest buffer first, of overlapping lifetimes."""
+        buffers = []
+        for index, (first, last) in self.lifetimes.items():
+            buffers.append((self.tensor(index).count, first, last, ("tensor", index)))
+        for operator, size in self.scratch.items():
+            buffers.append((size, operator, operator, ("scratch", operator)))
+        buffers.sort(key=lambda item: (-item[0], item[1]))
+
+        placed = []
+        self.offsets = {}
+        for size, first, last, key in buffers:
+            conflicts = sorted((offset, offset + other_size)
+                               for offset, other_size, other_first, other_last in placed
+                               if first <= other_last and other_first <= last)
+            offset = 0
+            for start, end in conflicts:
+                if offset + size <= start:
+                    break
+                offset = max(offset, align(end))
+            placed.append((offset, size, first, last))
+            self.offsets[key] = offset
+        self.arena_size = align(max(offset + size for offset, size, _, _ in placed))
+
+    def buffer(self, index):
+        index = self.root(index)
+        if index == self.ecg_input:
+            return "tinycardia_aot_ecg_input"
+        if index == self.rr_input:
+            return "tinycardia_aot_rr_input"
+        return "&tinycardia_aot_arena[%d]" % self.offsets[("tensor", index)]
+
+    def constant(self, ctype, name, values):
+        self.constants.append(array(ctype, name, values))
+
+    def lower_conv(self, operator, name):
+        input_tensor = self.tensor(operator.inputs[0])
+        weights = self.tensor(operator.inputs[1])
+        bias = self.tensor(operator.inputs[2])
+        output_tensor = self.tensor(operator.outputs[0])
+        _, input_height, input_width, input_channels = input_tensor.shape
+        output_channels, kernel_height, kernel_width, weight_channels = weights.shape
+        require(len(input_tensor.shape) == 4 and input_tensor.shape[0] == 1,
+                "CONV_2D %d input is not a single NHWC image" % operator.index)
+        require(weight_channels == input_channels, "CONV_2D %d is grouped" % operator.index)
+        require(operator.option(4, "i", 1) == 1 and operator.option(5, "i", 1) == 1,
+                "CONV_2D %d is dilated" % operator.index)
+        stride_width = operator.option(1, "i")
+        stride_height = operator.option(2, "i")
+        output_height, padding_height = padding(operator.option(0, "b"), input_height,
+                                                kernel_height, stride_height)
+        output_width, padding_width = padding(operator.option(0, "b"), input_width,
+                                              kernel_width, stride_width)
+        require(output_tensor.shape == [1, output_height, output_width, output_channels],
+                "CONV_2D %d output shape mismatch" % operator.index)
+        multipliers, shifts = per_channel_multipliers(input_tensor, weights, output_tensor,
+                                                      output_channels)
+        activation_min, activation_max = activation_range(
+            operator.option(3, "b"), output_tensor.scale, output_tensor.zero_point)
+
+        self.constant("int8_t", name + "_weights", weights.values())
+        self.constant("int32_t", name + "_bias", bias.values())
+        self.constant("int32_t", name + "_multipliers", multipliers)
+        self.constant("int32_t", name + "_shifts", shifts)
+        self.descriptors[operator.index] = name
+        self.constants.append(struct_constant("tinycardia_aot_conv", name, [
+            ("weights", name + "_weights"),
+            ("bias", name + "_bias"),
+            ("multipliers", name + "_multipliers"),
+            ("shifts", name + "_shifts"),
+            ("input_height", input_height),
+            ("input_width", input_width),
+            ("input_channels", input_channels),
+            ("output_height", output_height),
+            ("output_width", output_width),
+            ("output_channels", output_channels),
+            ("kernel_height", kernel_height),
+            ("kernel_width", kernel_width),
+            ("stride_height", stride_height),
+            ("stride_width", stride_width),
+            ("padding_height", padding_height),
+            ("padding_width", padding_width),
+            ("input_offset", -input_tensor.zero_point),
+            ("output_offset", output_tensor.zero_point),
+            ("activation_min", activation_min),
+            ("activation_max", activation_max),
+        ]))
+        return ["\treturn tinycardia_aot_conv_s8(&%s, %s, %s, &tinycardia_aot_arena[%d], %dU);"
+                % (name, self.buffer(operator.inputs[0]), self.buffer(operator.outputs[0]),
+                   self.offsets[("scratch", operator.index)], self.scratch[operator.index])]
+
+    def lower_max_pool(self, operator, name):
+        input_tensor = self.tensor(operator.inputs[0])
+        output_tensor = self.tensor(operator.outputs[0])
+        require(len(input_tensor.shape) == 4 and input_tensor.shape[0] == 1,
+                "MAX_POOL_2D %d input is not a single NHWC image" % operator.index)
+        require(input_tensor.scales == output_tensor.scales and
+                input_tensor.zero_points == output_tensor.zero_points,
+                "MAX_POOL_2D %d rescales its input" % operator.index)
+        _, input_height, input_width, channels = input_tensor.shape
+        stride_width = operator.option(1, "i")
+        stride_height = operator.option(2, "i")
+        filter_width = operator.option(3, "i")
+        filter_height = operator.option(4, "i")
+        output_height, padding_height = padding(operator.option(0, "b"), input_height,
+                                                filter_height, stride_height)
+        output_width, padding_width = padding(operator.option(0, "b"), input_width,
+                                              filter_width, stride_width)
+        require(output_tensor.shape == [1, output_height, output_width, channels],
+                "MAX_POOL_2D %d output shape mismatch" % operator.index)
+        activation_min, activation_max = activation_range(
+            operator.option(5, "b"), output_tensor.scale, output_tensor.zero_point)
+        self.descriptors[operator.index] = name
+        self.constants.append(struct_constant("tinycardia_aot_pool", name, [
+            ("input_height", input_height),
+            ("input_width", input_width),
+            ("channels", channels),
+            ("output_height", output_height),
+            ("output_width", output_width),
+            ("filter_height", filter_height),
+            ("filter_width", filter_width),
+            ("stride_height", stride_height),
+            ("stride_width", stride_width),
+            ("padding_height", padding_height),
+            ("padding_width", padding_width),
+            ("activation_min", activation_min),
+            ("activation_max", activation_max),
+        ]))
+        return ["\treturn tinycardia_aot_max_pool_s8(&%s, %s, %s);" %
+                (name, self.buffer(operator.inputs[0]), self.buffer(operator.outputs[0]))]
+
+    def lower_mean(self, operator, name):
+        input_tensor = self.tensor(operator.inputs[0])
+        output_tensor = self.tensor(operator.outputs[0])
+        rank = len(input_tensor.shape)
+        axes = sorted(set(axis % rank for axis in self.tensor(operator.inputs[1]).values()))
+        require(axes == list(range(axes[0], axes[-1] + 1)),
+                "MEAN %d axes are not contiguous" % operator.index)
+        outer_count = math.prod(input_tensor.shape[:axes[0]])
+        reduced_count = math.prod(input_tensor.shape[axes[0]:axes[-1] + 1])
+        inner_count = math.prod(input_tensor.shape[axes[-1] + 1:])
+        require(output_tensor.count == outer_count * inner_count,
+                "MEAN %d output shape mismatch" % operator.index)
+        require(input_tensor.scale != output_tensor.scale or
+                input_tensor.zero_point != output_tensor.zero_point,
+                "MEAN %d without rescaling is not supported" % operator.index)
+        # reference_ops::QuantizedMeanOrSum() folds 1/reduced_count into the multiplier.
+        multiplier, shift = quantize_multiplier(input_tensor.scale / output_tensor.scale)
+        count_shift = min(reduced_count.bit_length() - 1, 32, 31 + shift)
+        multiplier = (multiplier << count_shift) // reduced_count
+        shift -= count_shift
+        self.constants.append(struct_constant("tinycardia_aot_mean", name, [
+            ("outer_count", outer_count),
+            ("reduced_count", reduced_count),
+            ("inner_count", inner_count),
+            ("input_zero_point", input_tensor.zero_point),
+            ("output_zero_point", output_tensor.zero_point),
+            ("multiplier", multiplier),
+            ("shift", shift),
+        ]))
+        return ["\treturn tinycardia_aot_mean_s8(&%s, %s, %s);" %
+                (name, self.buffer(operator.inputs[0]), self.buffer(operator.outputs[0]))]
+
+    def lower_fully_connected(self, operator, name):
+        input_tensor = self.tensor(operator.inputs[0])
+        weights = self.tensor(operator.inputs[1])
+        bias = self.tensor(operator.inputs[2])
+        output_tensor = self.tensor(operator.outputs[0])
+        output_count, input_count = weights.shape
+        require(input_tensor.count % input_count == 0,
+                "FULLY_CONNECTED %d input size mismatch" % operator.index)
+        require(operator.option(1, "b") == 0, "FULLY_CONNECTED %d weights are shuffled" %
+                operator.index)
+        batches = input_tensor.count // input_count
+        require(output_tensor.count == batches * output_count,
+                "FULLY_CONNECTED %d output shape mismatch" % operator.index)
+        multipliers, shifts = per_channel_multipliers(input_tensor, weights, output_tensor,
+                                                      output_count)
+        activation_min, activation_max = activation_range(
+            operator.option(0, "b"), output_tensor.scale, output_tensor.zero_point)
+        self.constant("int8_t", name + "_weights", weights.values())
+        self.constant("int32_t", name + "_bias", bias.values())
+        self.constant("int32_t", name + "_multipliers", multipliers)
+        self.constant("int32_t", name + "_shifts", shifts)
+        self.constants.append(struct_constant("tinycardia_aot_fully_connected", name, [
+            ("weights", name + "_weights"),
+            ("bias", name + "_bias"),
+            ("multipliers", name + "_multipliers"),
+            ("shifts", name + "_shifts"),
+            ("batches", batches),
+            ("input_count", input_count),
+            ("output_count", output_count),
+            ("input_offset", -input_tensor.zero_point),
+            ("output_offset", output_tensor.zero_point),
+            ("activation_min", activation_min),
+            ("activation_max", activation_max),
+        ]))
+        return ["\treturn tinycardia_aot_fully_connected_s8(&%s, %s, %s);" %
+                (name, self.buffer(operator.inputs[0]), self.buffer(operator.outputs[0]))]
+
+    def lower_concatenation(self, operator, name):
+        output_tensor = self.tensor(operator.outputs[0])
+        rank = len(output_tensor.shape)
+        axis = operator.option(0, "i") % rank
+        require(operator.option(1, "b") == ACTIVATION_NONE,
+                "CONCATENATION %d has a fused activation" % operator.index)
+        outer_count = math.prod(output_tensor.shape[:axis])
+        lines = []
+        offset = 0
+        pieces = []
+        for index in operator.inputs:
+            input_tensor = self.tensor(index)
+            require(input_tensor.scales == output_tensor.scales and
+                    input_tensor.zero_points == output_tensor.zero_points,
+                    "CONCATENATION %d requantizes its inputs" % operator.index)
+            pieces.append((index, input_tensor.count // outer_count))
+        row = sum(size for _, size in pieces)
+        require(row * outer_count == output_tensor.count,
+                "CONCATENATION %d output shape mismatch" % operator.index)
+        # Equal quantization on every input makes concatenation a plain copy.
+        for outer in range(outer_count):
+            offset = outer * row
+            for index, size in pieces:
+                lines.append("\tmemcpy(%s + %d, %s + %d, %d);" % (
+                    self.buffer(operator.outputs[0]), offset, self.buffer(index),
+                    outer * size, size))
+                offset += size
+        lines.append("\treturn 0;")
+        return lines
+
+    def lower_softmax(self, operator, name):
+        input_tensor = self.tensor(operator.inputs[0])
+        output_tensor = self.tensor(operator.outputs[0])
+        require(output_tensor.scale == 1.0 / 256.0 and output_tensor.zero_point == -128,
+                "SOFTMAX %d output is not quantized to 1/256" % operator.index)
+        row_size = input_tensor.shape[-1]
+        multiplier, left_shift, diff_min = softmax_parameters(
+            operator.option(0, "f", 1.0), input_tensor.scale)
+        self.constants.append(struct_constant("tinycardia_aot_softmax", name, [
+            ("rows", input_tensor.count // row_size),
+            ("row_size", row_size),
+            ("input_multiplier", multiplier),
+            ("input_left_shift", left_shift),
+            ("diff_min", diff_min),
+        ]))
+        return ["\treturn tinycardia_aot_softmax_s8(&%s, %s, %s);" %
+                (name, self.buffer(operator.inputs[0]), self.buffer(operator.outputs[0]))]
+
+    def compile(self):
+        self.check_contract()
+        self.analyze_lifetimes()
+        lowerers = {
+            OP_CONV_2D: self.lower_conv,
+            OP_MAX_POOL_2D: self.lower_max_pool,
+            OP_MEAN: self.lower_mean,
+            OP_FULLY_CONNECTED: self.lower_fully_connected,
+            OP_CONCATENATION: self.lower_concatenation,
+            OP_SOFTMAX: self.lower_softmax,
+        }
+        self.plan()
+        for operator in self.model.operators:
+            if operator.code not in lowerers:
+                self.table.append((operator.name, "NULL"))
+                continue
+            name = "%s_%d" % (operator.name.lower(), operator.index)
+            function = "invoke_" + name
+            lines = lowerers[operator.code](operator, name)
+            self.functions.append("static int %s(void)\n{\n%s\n}\n" %
+                                  (function, "\n".join(lines)))
+            self.table.append((operator.name, function))
+            if operator.code == OP_CONV_2D:
+                self.prepare_checks.append((name, self.scratch[operator.index]))
+        self.analyze_front_end()
+
+    def analyze_front_end(self):
+        """Split off the CONV_2D/MAX_POOL_2D chain fed by the ECG input as streaming stages."""
+        stages = []
+        produced = set()
+        current = self.ecg_input
+        self.tail_operator = len(self.model.operators)
+        for operator in self.model.operators:
+            source = self.root(operator.inputs[0])
+            if operator.code in (OP_RESHAPE, OP_EXPAND_DIMS) and source == current:
+                continue
+            if operator.code == OP_CONV_2D and source == current:
+                stages.append([operator, None])
+            elif (operator.code == OP_MAX_POOL_2D and source == current and stages and
+                  stages[-1][1] is None):
+                stages[-1][1] = operator
+            else:
+                self.tail_operator = operator.index
+                break
+            produced.add(current)
+            current = self.root(operator.outputs[0])
+        require(stages, "no convolution reads the ECG input")
+        require(len(stages) <= MAX_STREAM_STAGES, "too many streaming stages")
+        for operator in self.model.operators[self.tail_operator:]:
+            for index in operator.inputs:
+                require(index < 0 or self.root(index) not in produced,
+                        "%s %d reads an inner front-end activation" %
+                        (operator.name, operator.index))
+
+        self.stages = []
+        for conv, pool in stages:
+            input_tensor = self.tensor(conv.inputs[0])
+            _, kernel_height, kernel_width, input_channels = self.tensor(conv.inputs[1]).shape
+            require(input_tensor.shape[1] == 1 and kernel_height == 1 and
+                    conv.option(1, "i") == 1 and conv.option(2, "i") == 1,
+                    "CONV_2D %d is not a 1-D stride-1 convolution" % conv.index)
+            output_channels = self.tensor(conv.outputs[0]).shape[3]
+            if pool is not None:
+                pool_input = self.tensor(pool.inputs[0])
+                stride = pool.option(1, "i")
+                require(pool.option(3, "i") == stride and pool.option(4, "i") == 1 and
+                        pool.option(0, "b") != PADDING_SAME and
+                        pool_input.shape[2] % stride == 0 and STREAM_BAND_COLUMNS % stride == 0,
+                        "MAX_POOL_2D %d does not pool whole bands" % pool.index)
+            self.stages.append((self.descriptors[conv.index],
+                                self.descriptors[pool.index] if pool is not None else None,
+                                (input_tensor.shape[2] + kernel_width - 1) * input_channels,
+                                output_channels))
+        self.stream_output = current
+
+    def emit(self, model_name):
+        lines = [
+            "/*",
+            " * Generated by scripts/tflite_aot.py from %s. Do not edit." % model_name,
+            " *",
+            " * %d operators, %d-byte activation arena." % (len(self.model.operators),
+                                                          self.arena_size),
+            " */",
+            "",
+            "#include \"model_aot.h\"",
+            "",
+            "#include <errno.h>",
+            "#include <string.h>",
+            "",
+            "#include <zephyr/sys/util.h>",
+            "#include <zephyr/toolchain.h>",
+            "",
+            "BUILD_ASSERT(%d == TINYCARDIA_MODEL_ECG_ZERO_POINT);" %
+            self.tensor(self.ecg_input).zero_point,
+            "BUILD_ASSERT(%d == TINYCARDIA_MODEL_RR_ZERO_POINT);" %
+            self.tensor(self.rr_input).zero_point,
+            "BUILD_ASSERT(%d == TINYCARDIA_MODEL_OUTPUT_ZERO_POINT);" %
+            self.tensor(self.output).zero_point,
+            "BUILD_ASSERT(%d == TINYCARDIA_MODEL_ECG_COUNT);" % self.tensor(self.ecg_input).count,
+            "BUILD_ASSERT(%d == TINYCARDIA_MODEL_RR_COUNT);" % self.tensor(self.rr_input).count,
+            "BUILD_ASSERT(%d == TINYCARDIA_MODEL_CLASS_COUNT);" % self.tensor(self.output).count,
+            "BUILD_ASSERT(%d == TINYCARDIA_MODEL_OPERATOR_COUNT);" % len(self.model.operators),
+            "",
+            "int8_t tinycardia_aot_ecg_input[TINYCARDIA_MODEL_ECG_COUNT] __aligned(4);",
+            "int8_t tinycardia_aot_rr_input[TINYCARDIA_MODEL_RR_COUNT] __aligned(4);",
+            "int8_t tinycardia_aot_arena[%d] __aligned(%d);" % (self.arena_size,
+                                                                ARENA_ALIGNMENT),
+            "const size_t tinycardia_aot_arena_size = sizeof(tinycardia_aot_arena);",
+            "int8_t *const tinycardia_aot_output = %s;" % self.buffer(self.output),
+            "",
+        ]
+        lines.extend(self.constants)
+        lines.extend(self.functions)
+        lines.append("const struct tinycardia_aot_operator "
+                     "tinycardia_aot_operators[TINYCARDIA_MODEL_OPERATOR_COUNT] = {")
+        for name, function in self.table:
+            lines.append("\t{\"%s\", %s}," % (name, function))
+        lines.append("};")
+        lines.append("")
+        lines.append("int tinycardia_aot_prepare(void)")
+        lines.append("{")
+        for name, size in self.prepare_checks:
+            lines.append("\tif (tinycardia_aot_conv_scratch_size(&%s) > %dU) {" % (name, size))
+            lines.append("\t\treturn -ENOMEM;")
+            lines.append("\t}")
+        lines.append("")
+        lines.append("\treturn 0;")
+        lines.append("}")
+        lines.extend(self.emit_stream())
+        return "\n".join(lines) + "\n"
+
+    def emit_stream(self):
+        band_size = STREAM_BAND_COLUMNS * max(stage[3] for stage in self.stages)
+        lines = [
+            "",
+            "#if defined(CONFIG_TINYCARDIA_MODEL_AOT_FRONT_END)",
+            "BUILD_ASSERT(%d <= TINYCARDIA_AOT_MAX_STREAM_STAGES);" % len(self.stages),
+            "",
+        ]
+        for index, (_, _, input_size, _) in enumerate(self.stages):
+            lines.append("static int8_t stream_input_%d[%d] __aligned(4);" % (index, input_size))
+        lines.extend([
+            "static int8_t stream_output[%d] __aligned(4);" % self.tensor(self.stream_output).count,
+            "static int8_t stream_band[%d] __aligned(4);" % band_size,
+            "static int8_t stream_scratch[%d] __aligned(4);" % max(self.scratch.values()),
+            "",
+            "static const struct tinycardia_aot_stage stream_stages[] = {",
+        ])
+        for index, (conv, pool, _, _) in enumerate(self.stages):
+            lines.append("\t{&%s, %s, stream_input_%d}," %
+                         (conv, "&" + pool if pool is not None else "NULL", index))
+        lines.extend([
+            "};",
+            "",
+            "const struct tinycardia_aot_stream tinycardia_aot_stream = {",
+            "\t.stages = stream_stages,",
+            "\t.stage_count = ARRAY_SIZE(stream_stages),",
+            "\t.output = stream_output,",
+            "\t.output_size = sizeof(stream_output),",
+            "\t.tail_input = %s," % self.buffer(self.stream_output),
+            "\t.tail_operator = %dU," % self.tail_operator,
+            "\t.band = stream_band,",
+            "\t.band_columns = %d," % STREAM_BAND_COLUMNS,
+            "\t.scratch = stream_scratch,",
+            "\t.scratch_size = sizeof(stream_scratch),",
+            "};",
+            "#endif",
+        ])
+        return lines
+
+
+def align(size):
+    return (size + ARENA_ALIGNMENT - 1) // ARENA_ALIGNMENT * ARENA_ALIGNMENT
+
+
+def array(ctype, name, values):
+    rows = []
+    per_row = 16 if ctype == "int8_t" else 8
+    for start in range(0, len(values), per_row):
+        rows.append("\t" + ", ".join(str(value) for value in values[start:start + per_row]) +
+                    ",")
+    return "static const %s %s[%d] = {\n%s\n};\n" % (ctype, name, len(values), "\n".join(rows))
+
+
+def struct_constant(ctype, name, fields):
+    body = "\n".join("\t.%s = %s," % field for field in fields)
+    return "static const struct %s %s = {\n%s\n};\n" % (ctype, name, body)
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write(__doc__)
+        return 2
+    with open(argv[1], "rb") as model_file:
+        model = Model(model_file.read())
+    compiler = Compiler(model)
+    try:
+        compiler.compile()
+    except CompileError as error:
+        sys.stderr.write("tflite_aot.py: %s\n" % error)
+        return 1
+    with open(argv[2], "w") as output_file:
+        output_file.write(compiler.emit(argv[1].replace("\\", "/").split("/")[-1]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
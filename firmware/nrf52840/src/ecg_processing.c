@@ -2,26 +2,88 @@
 
 #include "ecg_processing.h"
 
+#include "model_contract.h"
+
 #include <errno.h>
 #include <math.h>
 #include <string.h>
 
-#define MAX30003_ECG_SAMPLE_SHIFT 6U
-#define MAX30003_ECG_SAMPLE_MASK  0x3ffffU
-#define MAX30003_ECG_SIGN_BIT     0x20000U
+#if defined(CONFIG_TINYCARDIA_ECG_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+#define MAX30003_ECG_SAMPLE_SHIFT   6U
+#define MAX30003_ECG_SAMPLE_MASK    0x3ffffU
+#define MAX30003_ECG_SIGN_BIT       0x20000U
+#define MAX30003_ECG_ETAG_SHIFT     3U
+#define MAX30003_ECG_ETAG_MASK      0x7U
+#define MAX30003_ECG_ETAG_FAST      1U
+#define MAX30003_ECG_ETAG_FAST_LAST 3U
 
 /* Retained from the STM32 input conversion used to validate the model. */
 #define MAX30003_ECG_LSB_MV (32.5f / 131072.0f)
 
-#define QRS_INTEGRATION_WINDOW_SAMPLES ((15U * ECG_PROCESSOR_SAMPLE_RATE_HZ) / 100U)
+#define QRS_INTEGRATION_WINDOW_SAMPLES ECG_QRS_INTEGRATION_WINDOW_SAMPLES
 #define QRS_INTEGRATION_LEFT_SAMPLES   (QRS_INTEGRATION_WINDOW_SAMPLES / 2U)
 #define QRS_INTEGRATION_RIGHT_SAMPLES                                                      \
 	(QRS_INTEGRATION_WINDOW_SAMPLES - QRS_INTEGRATION_LEFT_SAMPLES - 1U)
 
 /* This interval must remain aligned with the preprocessing used to train the model. */
 #define QRS_MIN_DISTANCE_SAMPLES   ((78U * ECG_PROCESSOR_SAMPLE_RATE_HZ) / 100U)
+
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+/* Pan-Tompkins timing: 2 s learning, 200 ms refractory, and T waves within 360 ms. */
+#define QRS_LEARNING_SAMPLES   (2U * ECG_PROCESSOR_SAMPLE_RATE_HZ)
+#define QRS_REFRACTORY_SAMPLES ((20U * ECG_PROCESSOR_SAMPLE_RATE_HZ) / 100U)
+#define QRS_T_WAVE_SAMPLES     ((36U * ECG_PROCESSOR_SAMPLE_RATE_HZ) / 100U)
+/* Integrated samples classified per new one until the learning samples are caught up. */
+#define QRS_CATCH_UP_STEPS     2U
+#endif
 #define ECG_MIN_STANDARD_DEVIATION 1.0e-6f
 
+/*
+ * Signal-quality index limits. Saturated samples lie within 1/32 of either
+ * rail. A flat sample moves by at most two counts (0.5 uV), well below the
+ * front end's input noise, so only a railed, disconnected, or held input
+ * stays flat. The baseline is a one-pole low-pass with a 128-sample (0.5 s)
+ * time constant, so it follows wander and motion but not the QRS complex.
+ */
+#define ECG_SQI_SATURATION_COUNTS  ((int32_t)(MAX30003_ECG_SIGN_BIT - MAX30003_ECG_SIGN_BIT / 32U))
+#define ECG_SQI_FLAT_STEP_COUNTS   2
+#define ECG_SQI_BASELINE_SHIFT     7U
+#define ECG_SQI_FULL_SCALE_UV      32500U
+/* A quarter second of clipping distorts too many QRS complexes to classify. */
+#define ECG_SQI_UNUSABLE_SATURATED (ECG_PROCESSOR_SAMPLE_RATE_HZ / 4U)
+/* Two flat seconds are longer than any RR interval above 30 bpm. */
+#define ECG_SQI_UNUSABLE_FLAT      (2U * ECG_PROCESSOR_SAMPLE_RATE_HZ)
+/* Mains interference alone lands between these; broadband noise reaches the second. */
+#define ECG_SQI_POOR_NOISE_PERMILLE     1000U
+#define ECG_SQI_UNUSABLE_NOISE_PERMILLE 2000U
+/* Respiratory wander stays well under the first; motion artifacts reach the second. */
+#define ECG_SQI_POOR_DRIFT_UV     2000U
+#define ECG_SQI_UNUSABLE_DRIFT_UV 8000U
+
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+/* Dropping two LSBs makes the 18-bit sample a Q15 fraction of the input range. */
+#define ECG_Q15_SAMPLE_SHIFT 2U
+/* arm_q15_to_float() divides by this power of two. */
+#define ECG_Q15_FULL_SCALE 32768.0f
+#endif
+
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+/*
+ * Integrated samples saturate here so that the squares of a whole window
+ * still sum exactly in 64 bits. The limit is far above the energy of a steep
+ * QRS complex; only gross motion artifacts reach it.
+ */
+#define QRS_INTEGRATED_MAX ((1UL << 24) - 1UL)
+/* 1 / TINYCARDIA_MODEL_ECG_SCALE in Q16, folded at compile time. */
+#define ECG_INPUT_INVERSE_SCALE_Q16 ((uint64_t)(65536.0f / TINYCARDIA_MODEL_ECG_SCALE + 0.5f))
+#elif defined(CONFIG_TINYCARDIA_ECG_CMSIS_DSP)
+/* Stack scratch for the vector kernels of the INT8 normalize pass. */
+#define ECG_DSP_BLOCK_SAMPLES 64U
+#endif
+
 static const float rr_feature_means[ECG_PROCESSOR_RR_FEATURE_COUNT] = {
 	960.825116f, 99.9119008f, 146.620803f, 0.311937086f, 0.477063449f, 100.942917f,
 	74.6044621f,
@@ -54,21 +116,39 @@ float ecg_decode_sample_mv(uint32_t raw_word)
 	return (float)ecg_decode_raw_sample(raw_word) * MAX30003_ECG_LSB_MV;
 }
 
+ecg_sample_t ecg_decode_sample(uint32_t raw_word)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+	return (ecg_sample_t)(ecg_decode_raw_sample(raw_word) >> ECG_Q15_SAMPLE_SHIFT);
+#else
+	return ecg_decode_sample_mv(raw_word);
+#endif
+}
+
+bool ecg_sample_is_fast_recovery(uint32_t raw_word)
+{
+	uint32_t etag = (raw_word >> MAX30003_ECG_ETAG_SHIFT) & MAX30003_ECG_ETAG_MASK;
+
+	return etag == MAX30003_ECG_ETAG_FAST || etag == MAX30003_ECG_ETAG_FAST_LAST;
+}
+
 void ecg_sample_window_reset(struct ecg_sample_window *window)
 {
 	if (window != NULL) {
 		window->count = 0U;
+		ecg_running_stats_reset(&window->stats);
 	}
 }
 
 enum ecg_window_append_result ecg_sample_window_append(struct ecg_sample_window *window,
-							       float sample)
+							       ecg_sample_t sample)
 {
 	if (window == NULL || window->count >= ECG_PROCESSOR_WINDOW_SIZE) {
 		return ECG_WINDOW_ALREADY_FULL;
 	}
 
 	window->samples[window->count++] = sample;
+	ecg_running_stats_add(&window->stats, sample);
 	if (window->count == ECG_PROCESSOR_WINDOW_SIZE) {
 		return ECG_WINDOW_COMPLETED;
 	}
@@ -76,101 +156,1006 @@ enum ecg_window_append_result ecg_sample_window_append(struct ecg_sample_window
 	return ECG_WINDOW_SAMPLE_STORED;
 }
 
-static void standardize_ecg_window(float samples[ECG_PROCESSOR_WINDOW_SIZE])
+void ecg_running_stats_reset(struct ecg_running_stats *stats)
+{
+	if (stats == NULL) {
+		return;
+	}
+
+	stats->count = 0U;
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	stats->sum = 0;
+	stats->sum_squares = 0U;
+#else
+	stats->mean = 0.0f;
+	stats->m2 = 0.0f;
+#endif
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+void ecg_running_stats_add(struct ecg_running_stats *stats, ecg_sample_t sample)
+{
+	if (stats == NULL) {
+		return;
+	}
+
+	++stats->count;
+	stats->sum += sample;
+	stats->sum_squares += (uint64_t)((int32_t)sample * sample);
+}
+
+void ecg_running_stats_merge(struct ecg_running_stats *stats,
+			     const struct ecg_running_stats *block)
+{
+	if (stats == NULL || block == NULL) {
+		return;
+	}
+
+	/* Integer sums merge exactly, whatever the block sizes. */
+	stats->count += block->count;
+	stats->sum += block->sum;
+	stats->sum_squares += block->sum_squares;
+}
+
+/* Floor of the square root, one result bit per step, without a floating-point unit. */
+static uint64_t isqrt_u64(uint64_t value)
+{
+	uint64_t root = 0U;
+	uint64_t bit = 1ULL << 62;
+
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0U) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return root;
+}
+
+void ecg_running_stats_quantize(const struct ecg_running_stats *stats,
+				const ecg_sample_t *samples, int8_t *quantized, size_t count)
+{
+	int64_t stats_count;
+	uint64_t scaled_deviation;
+	uint64_t multiplier;
+	uint32_t shift = 48U;
+	int64_t rounding;
+
+	if (stats == NULL || samples == NULL || quantized == NULL || stats->count == 0U) {
+		return;
+	}
+
+	/*
+	 * count * sum_squares - sum^2 is exactly count^2 times the population
+	 * variance, so its root is count times the standard deviation.
+	 */
+	stats_count = (int64_t)stats->count;
+	scaled_deviation = isqrt_u64((uint64_t)stats_count * stats->sum_squares -
+				     (uint64_t)(stats->sum * stats->sum));
+	if (scaled_deviation == 0U) {
+		/* Every sample of a flat window equals the mean and standardizes to zero. */
+		scaled_deviation = 1U;
+	}
+
+	/* One division per window, normalized so each product keeps 31 significant bits. */
+	multiplier = (ECG_INPUT_INVERSE_SCALE_Q16 << 32) / scaled_deviation;
+	while (multiplier > (uint64_t)INT32_MAX) {
+		multiplier >>= 1;
+		--shift;
+	}
+	rounding = (int64_t)1 << (shift - 1U);
+	for (size_t index = 0; index < count; ++index) {
+		int64_t product = (stats_count * samples[index] - stats->sum) * (int64_t)multiplier;
+		int64_t value;
+
+		/* Round half away from zero, like lroundf(). */
+		value = product >= 0 ? (product + rounding) >> shift
+				     : -((rounding - product) >> shift);
+		value += TINYCARDIA_MODEL_ECG_ZERO_POINT;
+		if (value < INT8_MIN) {
+			value = INT8_MIN;
+		} else if (value > INT8_MAX) {
+			value = INT8_MAX;
+		}
+		quantized[index] = (int8_t)value;
+	}
+}
+
+bool ecg_running_stats_within(const struct ecg_running_stats *stats,
+			      const struct ecg_running_stats *reference,
+			      uint32_t tolerance_permille)
+{
+	int64_t count;
+	int64_t reference_count;
+	int64_t scaled_deviation;
+	int64_t reference_deviation;
+	int64_t limit;
+	int64_t mean_difference;
+	int64_t deviation_difference;
+
+	if (stats == NULL || reference == NULL || stats->count == 0U || reference->count == 0U) {
+		return false;
+	}
+
+	/* Both sides of each comparison are multiplied by 1000 * count * reference count. */
+	count = (int64_t)stats->count;
+	reference_count = (int64_t)reference->count;
+	scaled_deviation = (int64_t)isqrt_u64((uint64_t)count * stats->sum_squares -
+					      (uint64_t)(stats->sum * stats->sum));
+	reference_deviation = (int64_t)isqrt_u64((uint64_t)reference_count *
+						 reference->sum_squares -
+						 (uint64_t)(reference->sum * reference->sum));
+	if (scaled_deviation == 0) {
+		scaled_deviation = 1;
+	}
+	if (reference_deviation == 0) {
+		reference_deviation = 1;
+	}
+	limit = (int64_t)tolerance_permille * scaled_deviation * reference_count;
+	mean_difference = reference->sum * count - stats->sum * reference_count;
+	deviation_difference = reference_deviation * count - scaled_deviation * reference_count;
+
+	return (mean_difference < 0 ? -mean_difference : mean_difference) * 1000 <= limit &&
+	       (deviation_difference < 0 ? -deviation_difference : deviation_difference) * 1000 <=
+		       limit;
+}
+#else
+void ecg_running_stats_add(struct ecg_running_stats *stats, ecg_sample_t sample)
+{
+	float delta;
+
+	if (stats == NULL) {
+		return;
+	}
+
+	delta = sample - stats->mean;
+	++stats->count;
+	stats->mean += delta / (float)stats->count;
+	stats->m2 += delta * (sample - stats->mean);
+}
+
+void ecg_running_stats_merge(struct ecg_running_stats *stats,
+			     const struct ecg_running_stats *block)
+{
+	float delta;
+	float block_weight;
+	size_t count;
+
+	if (stats == NULL || block == NULL || block->count == 0U) {
+		return;
+	}
+	if (stats->count == 0U) {
+		*stats = *block;
+		return;
+	}
+
+	/* Chan et al. pairwise combination of two Welford accumulators. */
+	count = stats->count + block->count;
+	delta = block->mean - stats->mean;
+	block_weight = (float)block->count / (float)count;
+	stats->mean += delta * block_weight;
+	stats->m2 += block->m2 + delta * delta * (float)stats->count * block_weight;
+	stats->count = count;
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_CMSIS_DSP)
+/* Write (sample - mean) * multiplier for count samples with the vector kernels. */
+static void normalize_block(const ecg_sample_t *samples, float mean, float multiplier,
+			    float32_t *normalized, uint32_t count)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+	/*
+	 * The conversion divides by 2^15, so the offset and multiplier are scaled
+	 * by the same power of two and every rounding step matches the C loop.
+	 */
+	arm_q15_to_float(samples, normalized, count);
+	arm_offset_f32(normalized, -mean / ECG_Q15_FULL_SCALE, normalized, count);
+	arm_scale_f32(normalized, multiplier * ECG_Q15_FULL_SCALE, normalized, count);
+#else
+	arm_offset_f32(samples, -mean, normalized, count);
+	arm_scale_f32(normalized, multiplier, normalized, count);
+#endif
+}
+#endif
+
+void ecg_running_stats_standardize(const struct ecg_running_stats *stats,
+				   const ecg_sample_t *samples, float *standardized, size_t count)
 {
-	float mean = 0.0f;
-	float variance = 0.0f;
 	float standard_deviation;
+	float inverse_deviation;
 
-	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		mean += samples[index];
+	if (stats == NULL || samples == NULL || standardized == NULL || stats->count == 0U) {
+		return;
 	}
-	mean /= (float)ECG_PROCESSOR_WINDOW_SIZE;
 
-	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		float difference = samples[index] - mean;
+	standard_deviation = sqrtf(stats->m2 / (float)stats->count);
+	if (standard_deviation < ECG_MIN_STANDARD_DEVIATION) {
+		standard_deviation = ECG_MIN_STANDARD_DEVIATION;
+	}
+	inverse_deviation = 1.0f / standard_deviation;
+#if defined(CONFIG_TINYCARDIA_ECG_CMSIS_DSP)
+	normalize_block(samples, stats->mean, inverse_deviation, standardized, (uint32_t)count);
+#else
+	for (size_t index = 0; index < count; ++index) {
+		standardized[index] = (samples[index] - stats->mean) * inverse_deviation;
+	}
+#endif
+}
+
+/*
+ * lroundf() for the saturated INT8 range without a library call. Truncation
+ * and the subtraction are both exact, so ties round away from zero as before.
+ */
+static inline int32_t round_half_away(float value)
+{
+	int32_t truncated = (int32_t)value;
+	float fraction = value - (float)truncated;
 
-		variance += difference * difference;
+	if (fraction >= 0.5f) {
+		++truncated;
+	} else if (fraction <= -0.5f) {
+		--truncated;
 	}
-	standard_deviation = sqrtf(variance / (float)ECG_PROCESSOR_WINDOW_SIZE);
+	return truncated;
+}
+
+void ecg_running_stats_quantize(const struct ecg_running_stats *stats,
+				const ecg_sample_t *samples, int8_t *quantized, size_t count)
+{
+	const float lowest = (float)(INT8_MIN - TINYCARDIA_MODEL_ECG_ZERO_POINT);
+	const float highest = (float)(INT8_MAX - TINYCARDIA_MODEL_ECG_ZERO_POINT);
+	float standard_deviation;
+	float multiplier;
+
+	if (stats == NULL || samples == NULL || quantized == NULL || stats->count == 0U) {
+		return;
+	}
+
+	standard_deviation = sqrtf(stats->m2 / (float)stats->count);
 	if (standard_deviation < ECG_MIN_STANDARD_DEVIATION) {
 		standard_deviation = ECG_MIN_STANDARD_DEVIATION;
 	}
+	/* One division per window: both the standard deviation and the input scale fold in here. */
+	multiplier = 1.0f / (standard_deviation * TINYCARDIA_MODEL_ECG_SCALE);
+#if defined(CONFIG_TINYCARDIA_ECG_CMSIS_DSP)
+	for (size_t start = 0; start < count; start += ECG_DSP_BLOCK_SAMPLES) {
+		float32_t block[ECG_DSP_BLOCK_SAMPLES];
+		size_t block_count = count - start < ECG_DSP_BLOCK_SAMPLES ? count - start
+									 : ECG_DSP_BLOCK_SAMPLES;
 
-	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		samples[index] = (samples[index] - mean) / standard_deviation;
+		/* The scalar loop's operations in the same order, so the output is identical. */
+		normalize_block(&samples[start], stats->mean, multiplier, block,
+				(uint32_t)block_count);
+		arm_clip_f32(block, block, lowest, highest, (uint32_t)block_count);
+		for (size_t index = 0; index < block_count; ++index) {
+			quantized[start + index] = (int8_t)(round_half_away(block[index]) +
+							    TINYCARDIA_MODEL_ECG_ZERO_POINT);
+		}
+	}
+#else
+	for (size_t index = 0; index < count; ++index) {
+		float scaled = (samples[index] - stats->mean) * multiplier;
+
+		/* Saturating before rounding keeps every value inside the INT8 range. */
+		if (scaled < lowest) {
+			scaled = lowest;
+		} else if (scaled > highest) {
+			scaled = highest;
+		}
+		quantized[index] = (int8_t)(round_half_away(scaled) +
+					    TINYCARDIA_MODEL_ECG_ZERO_POINT);
+	}
+#endif
+}
+
+static float population_deviation(const struct ecg_running_stats *stats)
+{
+	float standard_deviation = sqrtf(stats->m2 / (float)stats->count);
+
+	return standard_deviation < ECG_MIN_STANDARD_DEVIATION ? ECG_MIN_STANDARD_DEVIATION
+							       : standard_deviation;
+}
+
+bool ecg_running_stats_within(const struct ecg_running_stats *stats,
+			      const struct ecg_running_stats *reference,
+			      uint32_t tolerance_permille)
+{
+	float deviation;
+	float limit;
+
+	if (stats == NULL || reference == NULL || stats->count == 0U || reference->count == 0U) {
+		return false;
 	}
+
+	deviation = population_deviation(stats);
+	limit = deviation * (float)tolerance_permille / 1000.0f;
+	return fabsf(reference->mean - stats->mean) <= limit &&
+	       fabsf(population_deviation(reference) - deviation) <= limit;
+}
+
+/* Transposed direct form II coefficients, normalized so that a0 is one. */
+struct ecg_biquad {
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+};
+
+/* Designed for 256 Hz with the bilinear transform; Butterworth Q, notch Q of 10. */
+static const struct ecg_biquad qrs_filter_stages[ECG_QRS_FILTER_STAGES] = {
+	/* 5 Hz high-pass. */
+	{ 0.916877240f, -1.833754481f, 0.916877240f, -1.826833111f, 0.840675850f },
+	/* 15 Hz low-pass. */
+	{ 0.026707072f, 0.053414144f, 0.026707072f, -1.487452426f, 0.594280715f },
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_NOTCH_50HZ)
+	{ 0.955039415f, -0.643486177f, 0.955039415f, -0.643486177f, 0.910078831f },
+#elif defined(CONFIG_TINYCARDIA_ECG_QRS_NOTCH_60HZ)
+	{ 0.952599382f, -0.186742135f, 0.952599382f, -0.186742135f, 0.905198764f },
+#endif
+};
+
+_Static_assert(ECG_PROCESSOR_SAMPLE_RATE_HZ == 256U,
+	       "The QRS filter coefficients are designed for 256 Hz");
+
+void ecg_qrs_filter_reset(struct ecg_qrs_filter *filter)
+{
+	if (filter == NULL) {
+		return;
+	}
+
+	memset(filter->state, 0, sizeof(filter->state));
+	filter->primed = false;
+}
+
+/* Load the steady state each stage reaches for a constant input. */
+static void prime_qrs_filter(struct ecg_qrs_filter *filter, float value)
+{
+	for (size_t stage = 0; stage < ECG_QRS_FILTER_STAGES; ++stage) {
+		const struct ecg_biquad *biquad = &qrs_filter_stages[stage];
+		float output = value * (biquad->b0 + biquad->b1 + biquad->b2) /
+			       (1.0f + biquad->a1 + biquad->a2);
+
+		filter->state[stage][1] = biquad->b2 * value - biquad->a2 * output;
+		filter->state[stage][0] =
+			biquad->b1 * value - biquad->a1 * output + filter->state[stage][1];
+		value = output;
+	}
+	filter->primed = true;
 }
 
-static void integrate_squared_derivative(
-	const float samples[ECG_PROCESSOR_WINDOW_SIZE],
-	struct ecg_processing_workspace *workspace)
+ecg_sample_t ecg_qrs_filter_apply(struct ecg_qrs_filter *filter, ecg_sample_t sample)
 {
-	float rolling_sum = 0.0f;
+	float value = (float)sample;
 
-	workspace->squared_derivative[0] = 0.0f;
-	for (size_t index = 1; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		float difference = samples[index] - samples[index - 1U];
+	if (filter == NULL) {
+		return sample;
+	}
+	if (!filter->primed) {
+		prime_qrs_filter(filter, value);
+	}
+
+	for (size_t stage = 0; stage < ECG_QRS_FILTER_STAGES; ++stage) {
+		const struct ecg_biquad *biquad = &qrs_filter_stages[stage];
+		float *state = filter->state[stage];
+		float output = biquad->b0 * value + state[0];
 
-		workspace->squared_derivative[index] = difference * difference;
+		state[0] = biquad->b1 * value - biquad->a1 * output + state[1];
+		state[1] = biquad->b2 * value - biquad->a2 * output;
+		value = output;
 	}
 
-	for (size_t index = 0; index <= QRS_INTEGRATION_RIGHT_SAMPLES; ++index) {
-		rolling_sum += workspace->squared_derivative[index];
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+	/* The band-pass gain never exceeds one, so only ringing can approach the limits. */
+	if (value < (float)INT16_MIN) {
+		value = (float)INT16_MIN;
+	} else if (value > (float)INT16_MAX) {
+		value = (float)INT16_MAX;
 	}
+	return (ecg_sample_t)round_half_away(value);
+#else
+	return value;
+#endif
+}
 
-	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		int32_t remove_index = (int32_t)index - (int32_t)QRS_INTEGRATION_LEFT_SAMPLES;
-		size_t add_index = index + QRS_INTEGRATION_RIGHT_SAMPLES + 1U;
+#if !defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+/* Mean and variance were accumulated during append, so only the normalize pass remains. */
+static void standardize_ecg_window(struct ecg_sample_window *window)
+{
+	ecg_running_stats_standardize(&window->stats, window->samples, window->samples,
+				      ECG_PROCESSOR_WINDOW_SIZE);
+}
+#endif
+#endif
+
+void ecg_quality_tracker_reset(struct ecg_quality_tracker *tracker)
+{
+	if (tracker == NULL) {
+		return;
+	}
 
-		workspace->integrated_signal[index] =
-			rolling_sum / (float)QRS_INTEGRATION_WINDOW_SAMPLES;
-		if (remove_index >= 0) {
-			rolling_sum -= workspace->squared_derivative[remove_index];
+	tracker->last_sample = 0;
+	tracker->last_difference = 0;
+	tracker->baseline_scaled = 0;
+	tracker->history = 0U;
+}
+
+void ecg_quality_stats_reset(struct ecg_quality_stats *stats)
+{
+	if (stats != NULL) {
+		memset(stats, 0, sizeof(*stats));
+	}
+}
+
+void ecg_quality_stats_add(struct ecg_quality_stats *stats, struct ecg_quality_tracker *tracker,
+			   int32_t raw_sample)
+{
+	bool flat = false;
+	int32_t baseline;
+
+	if (stats == NULL || tracker == NULL) {
+		return;
+	}
+
+	if (tracker->history == 0U) {
+		/* Settle the baseline on the first sample, so a restart shows no drift. */
+		tracker->baseline_scaled = raw_sample * (1 << ECG_SQI_BASELINE_SHIFT);
+		tracker->history = 1U;
+	} else {
+		int32_t difference = raw_sample - tracker->last_sample;
+
+		flat = difference >= -ECG_SQI_FLAT_STEP_COUNTS &&
+		       difference <= ECG_SQI_FLAT_STEP_COUNTS;
+		stats->slope_energy += (uint64_t)((int64_t)difference * difference);
+		if (tracker->history > 1U) {
+			int64_t curvature = (int64_t)difference - tracker->last_difference;
+
+			stats->curvature_energy += (uint64_t)(curvature * curvature);
 		}
-		if (add_index < ECG_PROCESSOR_WINDOW_SIZE) {
-			rolling_sum += workspace->squared_derivative[add_index];
+		tracker->last_difference = difference;
+		tracker->history = 2U;
+	}
+	tracker->last_sample = raw_sample;
+	baseline = tracker->baseline_scaled >> ECG_SQI_BASELINE_SHIFT;
+	tracker->baseline_scaled += raw_sample - baseline;
+	baseline = tracker->baseline_scaled >> ECG_SQI_BASELINE_SHIFT;
+
+	if (stats->count == 0U || baseline < stats->baseline_min) {
+		stats->baseline_min = baseline;
+	}
+	if (stats->count == 0U || baseline > stats->baseline_max) {
+		stats->baseline_max = baseline;
+	}
+	if (flat) {
+		if (stats->leading_flat_count == stats->count) {
+			++stats->leading_flat_count;
 		}
+		++stats->trailing_flat_count;
+		if (stats->trailing_flat_count > stats->longest_flat_count) {
+			stats->longest_flat_count = stats->trailing_flat_count;
+		}
+	} else {
+		stats->trailing_flat_count = 0U;
+	}
+	if (raw_sample >= ECG_SQI_SATURATION_COUNTS || raw_sample <= -ECG_SQI_SATURATION_COUNTS) {
+		++stats->saturated_count;
 	}
+	++stats->count;
 }
 
-static size_t detect_r_peaks(struct ecg_processing_workspace *workspace)
+void ecg_quality_stats_merge(struct ecg_quality_stats *stats,
+			     const struct ecg_quality_stats *block)
 {
-	float mean = 0.0f;
-	float variance = 0.0f;
-	float threshold;
-	int32_t last_peak = -(int32_t)QRS_MIN_DISTANCE_SAMPLES - 1;
-	size_t peak_count = 0U;
+	size_t joined_flat_count;
 
-	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		mean += workspace->integrated_signal[index];
+	if (stats == NULL || block == NULL || block->count == 0U) {
+		return;
+	}
+	if (stats->count == 0U) {
+		*stats = *block;
+		return;
 	}
-	mean /= (float)ECG_PROCESSOR_WINDOW_SIZE;
 
-	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		float difference = workspace->integrated_signal[index] - mean;
+	/* A flat run ending one block continues into the run starting the next. */
+	joined_flat_count = stats->trailing_flat_count + block->leading_flat_count;
+	if (block->longest_flat_count > stats->longest_flat_count) {
+		stats->longest_flat_count = block->longest_flat_count;
+	}
+	if (joined_flat_count > stats->longest_flat_count) {
+		stats->longest_flat_count = joined_flat_count;
+	}
+	if (stats->leading_flat_count == stats->count) {
+		stats->leading_flat_count += block->leading_flat_count;
+	}
+	if (block->trailing_flat_count == block->count) {
+		stats->trailing_flat_count += block->trailing_flat_count;
+	} else {
+		stats->trailing_flat_count = block->trailing_flat_count;
+	}
+
+	stats->count += block->count;
+	stats->saturated_count += block->saturated_count;
+	stats->slope_energy += block->slope_energy;
+	stats->curvature_energy += block->curvature_energy;
+	if (block->baseline_min < stats->baseline_min) {
+		stats->baseline_min = block->baseline_min;
+	}
+	if (block->baseline_max > stats->baseline_max) {
+		stats->baseline_max = block->baseline_max;
+	}
+}
+
+void ecg_quality_stats_evaluate(const struct ecg_quality_stats *stats,
+				struct ecg_signal_quality_index *index)
+{
+	uint64_t noise_permille = 0U;
+	uint64_t drift_uv = 0U;
+
+	if (stats == NULL || index == NULL) {
+		return;
+	}
+
+	if (stats->slope_energy > 0U) {
+		noise_permille = (stats->curvature_energy * 1000U) / stats->slope_energy;
+	}
+	if (stats->count > 0U) {
+		drift_uv = ((uint64_t)(stats->baseline_max - stats->baseline_min) *
+			    ECG_SQI_FULL_SCALE_UV) / MAX30003_ECG_SIGN_BIT;
+	}
+	index->saturated_sample_count = stats->saturated_count;
+	index->longest_flat_sample_count = stats->longest_flat_count;
+	index->noise_permille = noise_permille > UINT32_MAX ? UINT32_MAX : (uint32_t)noise_permille;
+	index->baseline_drift_uv = (uint32_t)drift_uv;
 
-		variance += difference * difference;
+	if (index->saturated_sample_count >= ECG_SQI_UNUSABLE_SATURATED ||
+	    index->longest_flat_sample_count >= ECG_SQI_UNUSABLE_FLAT ||
+	    index->noise_permille >= ECG_SQI_UNUSABLE_NOISE_PERMILLE ||
+	    index->baseline_drift_uv >= ECG_SQI_UNUSABLE_DRIFT_UV) {
+		index->level = ECG_SIGNAL_QUALITY_UNUSABLE;
+	} else if (index->saturated_sample_count > 0U ||
+		   index->noise_permille >= ECG_SQI_POOR_NOISE_PERMILLE ||
+		   index->baseline_drift_uv >= ECG_SQI_POOR_DRIFT_UV) {
+		index->level = ECG_SIGNAL_QUALITY_POOR;
+	} else {
+		index->level = ECG_SIGNAL_QUALITY_GOOD;
 	}
-	threshold = mean + 0.7f * sqrtf(variance / (float)ECG_PROCESSOR_WINDOW_SIZE);
+}
+
+/* Standardize into the float window, or quantize into the model input when one is given. */
+static int write_ecg_model_input(struct ecg_sample_window *window, int8_t *quantized_ecg)
+{
+	if (quantized_ecg != NULL) {
+		ecg_running_stats_quantize(&window->stats, window->samples, quantized_ecg,
+					   ECG_PROCESSOR_WINDOW_SIZE);
+		return 0;
+	}
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+	/* Q15 windows are only ever standardized into the INT8 model input. */
+	return -ENOTSUP;
+#else
+	standardize_ecg_window(window);
+	return 0;
+#endif
+}
+
+void ecg_qrs_detector_reset(struct ecg_qrs_detector *detector)
+{
+	if (detector == NULL) {
+		return;
+	}
+
+	detector->previous_sample = 0;
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	detector->rolling_sum = 0U;
+	detector->integrated_sum = 0U;
+	detector->integrated_sum_squares = 0U;
+#else
+	detector->rolling_sum = 0.0f;
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+	detector->signal_level = 0.0f;
+	detector->noise_level = 0.0f;
+	detector->learning_max = 0.0f;
+	detector->learning_sum = 0.0f;
+	detector->last_qrs_value = 0.0f;
+	detector->last_qrs_slope = 0.0f;
+	detector->searchback_value = 0.0f;
+	detector->searchback_index = 0U;
+	detector->last_qrs_index = 0U;
+	detector->classified_count = 0U;
+	detector->rr_count = 0U;
+	detector->rr_next = 0U;
+	detector->irregular = false;
+	detector->peak_count = 0U;
+#else
+	detector->integrated_mean = 0.0f;
+	detector->integrated_m2 = 0.0f;
+#endif
+#endif
+	detector->sample_count = 0U;
+	detector->integrated_count = 0U;
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+/* Detection threshold I1; search-back uses half of it. Irregular rhythms halve both. */
+static float adaptive_qrs_threshold(const struct ecg_qrs_detector *detector)
+{
+	float threshold = detector->noise_level +
+			  0.25f * (detector->signal_level - detector->noise_level);
+
+	return detector->irregular ? 0.5f * threshold : threshold;
+}
+
+static float average_rr_interval(const struct ecg_qrs_detector *detector)
+{
+	size_t sum = 0U;
+
+	for (size_t index = 0; index < detector->rr_count; ++index) {
+		sum += detector->rr_intervals[index];
+	}
+
+	return (float)sum / (float)detector->rr_count;
+}
+
+/*
+ * Steepest rise of the integrated signal over the integration width before
+ * index. It follows the squared slope of the QRS complex's leading edge, so
+ * half the slope is a quarter of this value.
+ */
+static float steepest_rise(const struct ecg_qrs_detector *detector, size_t index)
+{
+	size_t first = index >= QRS_INTEGRATION_WINDOW_SAMPLES
+			       ? index - QRS_INTEGRATION_WINDOW_SAMPLES + 1U
+			       : 1U;
+	float steepest = 0.0f;
+
+	for (size_t sample = first; sample <= index; ++sample) {
+		float rise = detector->integrated_signal[sample] -
+			     detector->integrated_signal[sample - 1U];
+
+		if (rise > steepest) {
+			steepest = rise;
+		}
+	}
+
+	return steepest;
+}
+
+/*
+ * The input sample at the centre of the QRS complex whose integrated maximum
+ * is at index. The integrated signal is a plateau as wide as the integration
+ * window, so noise moves its maximum by many samples; the centroid of the
+ * plateau above half that maximum is the centre of the complex's slope energy
+ * and barely moves. Each squared derivative lies half a sample before its
+ * input sample, and the centered window is one sample longer on the left.
+ */
+static size_t qrs_center(const struct ecg_qrs_detector *detector, size_t index)
+{
+	const float *signal = detector->integrated_signal;
+	const float offset = ((float)QRS_INTEGRATION_RIGHT_SAMPLES -
+			      (float)QRS_INTEGRATION_LEFT_SAMPLES - 1.0f) / 2.0f;
+	float half = 0.5f * signal[index];
+	float weight_sum = 0.0f;
+	float weighted_offset_sum = 0.0f;
+	float center;
+	size_t first = index;
+	size_t last = index;
+
+	while (first > 0U && index - first < QRS_INTEGRATION_WINDOW_SAMPLES &&
+	       signal[first - 1U] > half) {
+		--first;
+	}
+	while (last + 1U < ECG_PROCESSOR_WINDOW_SIZE &&
+	       last - index < QRS_INTEGRATION_WINDOW_SAMPLES && signal[last + 1U] > half) {
+		++last;
+	}
+	for (size_t sample = first; sample <= last; ++sample) {
+		float weight = signal[sample] - half;
+
+		weight_sum += weight;
+		weighted_offset_sum += weight * (float)(sample - first);
+	}
+	if (weight_sum <= 0.0f) {
+		return index;
+	}
+
+	center = (float)first + weighted_offset_sum / weight_sum + offset;
+	if (center <= 0.0f) {
+		return 0U;
+	}
+	center = floorf(center + 0.5f);
+
+	return center < (float)ECG_PROCESSOR_WINDOW_SIZE ? (size_t)center
+							   : ECG_PROCESSOR_WINDOW_SIZE - 1U;
+}
+
+static void record_qrs(struct ecg_qrs_detector *detector, size_t index, float value)
+{
+	if (detector->peak_count > 0U) {
+		size_t interval = index - detector->last_qrs_index;
+
+		if (detector->rr_count > 0U) {
+			float average = average_rr_interval(detector);
+
+			/* Outside 92-116% of the recent average, the rhythm is irregular. */
+			detector->irregular = (float)interval < 0.92f * average ||
+					      (float)interval > 1.16f * average;
+		}
+		detector->rr_intervals[detector->rr_next] = interval;
+		detector->rr_next = (detector->rr_next + 1U) % ECG_QRS_RR_HISTORY;
+		if (detector->rr_count < ECG_QRS_RR_HISTORY) {
+			++detector->rr_count;
+		}
+	}
+	if (detector->peak_count < ECG_PROCESSING_MAX_R_PEAKS) {
+		detector->peak_indices[detector->peak_count++] = index;
+	}
+	detector->last_qrs_index = index;
+	detector->last_qrs_value = value;
+	detector->last_qrs_slope = steepest_rise(detector, index);
+	detector->searchback_value = 0.0f;
+}
+
+/* Classify one local maximum of the integrated signal as a beat or noise. */
+static void classify_qrs_candidate(struct ecg_qrs_detector *detector, size_t index)
+{
+	float value = detector->integrated_signal[index];
+
+	if (detector->peak_count > 0U &&
+	    index - detector->last_qrs_index <= QRS_REFRACTORY_SAMPLES) {
+		/* A higher peak of the same complex moves the beat, not a new one. */
+		if (value > detector->last_qrs_value &&
+		    detector->peak_count < ECG_PROCESSING_MAX_R_PEAKS) {
+			size_t last_rr = (detector->rr_next + ECG_QRS_RR_HISTORY - 1U) %
+					 ECG_QRS_RR_HISTORY;
+
+			if (detector->peak_count > 1U) {
+				detector->rr_intervals[last_rr] += index - detector->last_qrs_index;
+			}
+			detector->peak_indices[detector->peak_count - 1U] = index;
+			detector->last_qrs_index = index;
+			detector->last_qrs_value = value;
+			detector->last_qrs_slope = steepest_rise(detector, index);
+		}
+		return;
+	}
+
+	if (value > adaptive_qrs_threshold(detector)) {
+		bool t_wave = detector->peak_count > 0U &&
+			      index - detector->last_qrs_index <= QRS_T_WAVE_SAMPLES &&
+			      steepest_rise(detector, index) < 0.25f * detector->last_qrs_slope;
+
+		if (!t_wave) {
+			detector->signal_level = 0.125f * value + 0.875f * detector->signal_level;
+			record_qrs(detector, index, value);
+			return;
+		}
+	}
+
+	detector->noise_level = 0.125f * value + 0.875f * detector->noise_level;
+	if (value > detector->searchback_value && detector->peak_count > 0U) {
+		detector->searchback_value = value;
+		detector->searchback_index = index;
+	}
+}
+
+/* Take the highest noise peak as a missed beat once 166% of the RR average has passed. */
+static void search_back_for_qrs(struct ecg_qrs_detector *detector, size_t index)
+{
+	if (detector->rr_count == 0U || detector->searchback_value <= 0.0f ||
+	    (float)(index - detector->last_qrs_index) <= 1.66f * average_rr_interval(detector)) {
+		return;
+	}
+	if (detector->searchback_value > 0.5f * adaptive_qrs_threshold(detector)) {
+		detector->signal_level =
+			0.25f * detector->searchback_value + 0.75f * detector->signal_level;
+		record_qrs(detector, detector->searchback_index, detector->searchback_value);
+	}
+}
+
+/* Examine the candidate completed by integrated sample index, one sample behind. */
+static void step_adaptive_qrs(struct ecg_qrs_detector *detector, size_t index)
+{
+	const float *signal = detector->integrated_signal;
+
+	if (index >= 2U && signal[index - 1U] > signal[index - 2U] &&
+	    signal[index - 1U] >= signal[index]) {
+		classify_qrs_candidate(detector, index - 1U);
+	}
+	search_back_for_qrs(detector, index);
+}
+
+/* Classify integrated samples in order, up to max_steps of them, through last_index. */
+static void classify_adaptive_qrs(struct ecg_qrs_detector *detector, size_t last_index,
+				  size_t max_steps)
+{
+	for (size_t step = 0; step < max_steps && detector->classified_count <= last_index;
+	     ++step) {
+		step_adaptive_qrs(detector, detector->classified_count++);
+	}
+}
+
+/*
+ * Learn the peak levels over the first two seconds, then classify from the
+ * first sample on. The learning samples are caught up on a few per new
+ * sample rather than all at once, so no captured sample costs a whole pass.
+ */
+static void append_adaptive_qrs(struct ecg_qrs_detector *detector, size_t index)
+{
+	float value = detector->integrated_signal[index];
+
+	if (index >= QRS_LEARNING_SAMPLES) {
+		classify_adaptive_qrs(detector, index, QRS_CATCH_UP_STEPS);
+		return;
+	}
+
+	if (value > detector->learning_max) {
+		detector->learning_max = value;
+	}
+	detector->learning_sum += value;
+	if (index == QRS_LEARNING_SAMPLES - 1U) {
+		detector->signal_level = detector->learning_max / 3.0f;
+		detector->noise_level = 0.5f * detector->learning_sum / (float)QRS_LEARNING_SAMPLES;
+	}
+}
+#endif
+
+/*
+ * Emit the next integrated sample from the rolling sum, then drop the oldest
+ * squared derivative from it. The order of additions and subtractions matches
+ * a whole-window centered integration exactly.
+ */
+static void emit_integrated_sample(struct ecg_qrs_detector *detector)
+{
+	size_t index = detector->integrated_count;
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	/* The sum is not divided by the width: thresholds depend only on its shape. */
+	uint32_t value = detector->rolling_sum < QRS_INTEGRATED_MAX
+				 ? (uint32_t)detector->rolling_sum
+				 : (uint32_t)QRS_INTEGRATED_MAX;
+
+	detector->integrated_signal[index] = value;
+	++detector->integrated_count;
+	detector->integrated_sum += value;
+	detector->integrated_sum_squares += (uint64_t)value * value;
+#else
+	float value = detector->rolling_sum / (float)QRS_INTEGRATION_WINDOW_SAMPLES;
+#if !defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+	float delta = value - detector->integrated_mean;
+#endif
+
+	detector->integrated_signal[index] = value;
+	++detector->integrated_count;
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+	append_adaptive_qrs(detector, index);
+#else
+	detector->integrated_mean += delta / (float)detector->integrated_count;
+	detector->integrated_m2 += delta * (value - detector->integrated_mean);
+#endif
+#endif
+
+	if (index >= QRS_INTEGRATION_LEFT_SAMPLES) {
+		detector->rolling_sum -= detector->squared_derivative
+			[(index - QRS_INTEGRATION_LEFT_SAMPLES) % QRS_INTEGRATION_WINDOW_SAMPLES];
+	}
+}
+
+void ecg_qrs_detector_append(struct ecg_qrs_detector *detector, ecg_sample_t sample)
+{
+	size_t index;
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	uint32_t squared_derivative = 0U;
+#else
+	float squared_derivative = 0.0f;
+#endif
+
+	if (detector == NULL || detector->sample_count >= ECG_PROCESSOR_WINDOW_SIZE) {
+		return;
+	}
+
+	index = detector->sample_count++;
+	if (index > 0U) {
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+		int32_t difference = (int32_t)sample - detector->previous_sample;
+		/* A Q15 step is below 2^16, so its square fits 32 unsigned bits. */
+		uint32_t magnitude = (uint32_t)(difference < 0 ? -difference : difference);
+
+		squared_derivative = magnitude * magnitude;
+#else
+		float difference = sample - detector->previous_sample;
+
+		squared_derivative = difference * difference;
+#endif
+	}
+	detector->previous_sample = sample;
+	detector->squared_derivative[index % QRS_INTEGRATION_WINDOW_SAMPLES] = squared_derivative;
+	detector->rolling_sum += squared_derivative;
+
+	/* Integrated sample n is centered, so it is complete once sample n + right arrives. */
+	if (index >= QRS_INTEGRATION_RIGHT_SAMPLES) {
+		emit_integrated_sample(detector);
+	}
+}
+
+#if !defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+/* Training-compatible detection: one global threshold and a fixed refractory period. */
+static size_t detect_r_peaks(const struct ecg_qrs_detector *detector, size_t *peak_indices,
+			     size_t max_peaks)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	uint64_t mean;
+	uint64_t variance;
+	uint64_t threshold;
+#else
+	float threshold;
+#endif
+	int32_t last_peak = -(int32_t)QRS_MIN_DISTANCE_SAMPLES - 1;
+	size_t peak_count = 0U;
+
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	/* floor(mean)^2 never exceeds floor(mean of squares), so this cannot wrap. */
+	mean = detector->integrated_sum / ECG_PROCESSOR_WINDOW_SIZE;
+	variance = detector->integrated_sum_squares / ECG_PROCESSOR_WINDOW_SIZE - mean * mean;
+	threshold = mean + (7U * isqrt_u64(variance)) / 10U;
+#else
+	threshold = detector->integrated_mean +
+		    0.7f * sqrtf(detector->integrated_m2 / (float)ECG_PROCESSOR_WINDOW_SIZE);
+#endif
 
 	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		if (workspace->integrated_signal[index] <= threshold) {
+		if (detector->integrated_signal[index] <= threshold) {
 			continue;
 		}
 		if (((int32_t)index - last_peak) <= (int32_t)QRS_MIN_DISTANCE_SAMPLES) {
 			continue;
 		}
 
-		workspace->r_peak_indices[peak_count++] = index;
+		peak_indices[peak_count++] = index;
 		last_peak = (int32_t)index;
-		if (peak_count == ECG_PROCESSING_MAX_R_PEAKS) {
+		if (peak_count == max_peaks) {
 			break;
 		}
 	}
 
 	return peak_count;
 }
+#endif
+
+size_t ecg_qrs_detector_finish(struct ecg_qrs_detector *detector, size_t *peak_indices,
+			       size_t max_peaks)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+	size_t peak_count;
+#endif
+
+	if (detector == NULL || peak_indices == NULL ||
+	    detector->sample_count != ECG_PROCESSOR_WINDOW_SIZE) {
+		return 0U;
+	}
+
+	/* The last samples have no right-hand neighbours left to wait for. */
+	while (detector->integrated_count < ECG_PROCESSOR_WINDOW_SIZE) {
+		emit_integrated_sample(detector);
+	}
+
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+	/* Beats were classified as the samples arrived; at most a few are left. */
+	classify_adaptive_qrs(detector, ECG_PROCESSOR_WINDOW_SIZE - 1U, ECG_PROCESSOR_WINDOW_SIZE);
+	peak_count = detector->peak_count < max_peaks ? detector->peak_count : max_peaks;
+	for (size_t peak = 0; peak < peak_count; ++peak) {
+		peak_indices[peak] = qrs_center(detector, detector->peak_indices[peak]);
+	}
+	return peak_count;
+#else
+	return detect_r_peaks(detector, peak_indices, max_peaks);
+#endif
+}
 
 static void standardize_rr_features(struct ecg_rr_result *result)
 {
@@ -181,8 +1166,8 @@ static void standardize_rr_features(struct ecg_rr_result *result)
 	}
 }
 
-int ecg_extract_rr_features(const size_t *peak_indices, size_t peak_count,
-			    struct ecg_rr_result *result)
+/* Derive the seven RR features from result->intervals_ms. */
+static void compute_rr_features(struct ecg_rr_result *result)
 {
 	size_t difference_count;
 	float rr_sum = 0.0f;
@@ -198,36 +1183,13 @@ int ecg_extract_rr_features(const size_t *peak_indices, size_t peak_count,
 	size_t pnn20_count = 0U;
 	float sd2_squared;
 
-	if (result == NULL || (peak_count > 0U && peak_indices == NULL)) {
-		return -EINVAL;
-	}
-	if (peak_count > ECG_PROCESSING_MAX_R_PEAKS) {
-		return -E2BIG;
-	}
-
-	memset(result, 0, sizeof(*result));
-	for (size_t index = 0; index < peak_count; ++index) {
-		if (peak_indices[index] >= ECG_PROCESSOR_WINDOW_SIZE) {
-			return -ERANGE;
-		}
-		if (index > 0U && peak_indices[index] <= peak_indices[index - 1U]) {
-			return -EINVAL;
-		}
-	}
-
-	if (peak_count > 1U) {
-		result->interval_count = peak_count - 1U;
-	}
 	for (size_t index = 0; index < result->interval_count; ++index) {
-		result->intervals_ms[index] =
-			(float)(peak_indices[index + 1U] - peak_indices[index]) * 1000.0f /
-			(float)ECG_PROCESSOR_SAMPLE_RATE_HZ;
 		rr_sum += result->intervals_ms[index];
 	}
 
 	if (result->interval_count < 2U) {
 		standardize_rr_features(result);
-		return 0;
+		return;
 	}
 
 	mean_rr = rr_sum / (float)result->interval_count;
@@ -277,13 +1239,84 @@ int ecg_extract_rr_features(const size_t *peak_indices, size_t peak_count,
 		sd2_squared > 0.0f ? sqrtf(sd2_squared) : 0.0f;
 	result->features_valid = true;
 	standardize_rr_features(result);
+}
+
+int ecg_extract_rr_features(const size_t *peak_indices, size_t peak_count,
+			    struct ecg_rr_result *result)
+{
+	if (result == NULL || (peak_count > 0U && peak_indices == NULL)) {
+		return -EINVAL;
+	}
+	if (peak_count > ECG_PROCESSING_MAX_R_PEAKS) {
+		return -E2BIG;
+	}
+
+	memset(result, 0, sizeof(*result));
+	for (size_t index = 0; index < peak_count; ++index) {
+		if (peak_indices[index] >= ECG_PROCESSOR_WINDOW_SIZE) {
+			return -ERANGE;
+		}
+		if (index > 0U && peak_indices[index] <= peak_indices[index - 1U]) {
+			return -EINVAL;
+		}
+	}
+
+	if (peak_count > 1U) {
+		result->interval_count = peak_count - 1U;
+	}
+	for (size_t index = 0; index < result->interval_count; ++index) {
+		result->intervals_ms[index] =
+			(float)(peak_indices[index + 1U] - peak_indices[index]) * 1000.0f /
+			(float)ECG_PROCESSOR_SAMPLE_RATE_HZ;
+	}
+	compute_rr_features(result);
+
+	return 0;
+}
+
+int ecg_extract_rr_features_from_intervals(const float *intervals_ms, size_t interval_count,
+					   struct ecg_rr_result *result)
+{
+	if (result == NULL || (interval_count > 0U && intervals_ms == NULL)) {
+		return -EINVAL;
+	}
+	if (interval_count > ECG_PROCESSING_MAX_R_PEAKS - 1U) {
+		return -E2BIG;
+	}
+
+	memset(result, 0, sizeof(*result));
+	for (size_t index = 0; index < interval_count; ++index) {
+		if (!(intervals_ms[index] > 0.0f) || !isfinite(intervals_ms[index])) {
+			return -EINVAL;
+		}
+		result->intervals_ms[index] = intervals_ms[index];
+	}
+	result->interval_count = interval_count;
+	compute_rr_features(result);
 
 	return 0;
 }
 
+#if !defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
 int ecg_prepare_model_inputs(struct ecg_sample_window *window,
 			     struct ecg_processing_workspace *workspace,
 			     struct ecg_processing_result *result)
+{
+	if (window == NULL || workspace == NULL || result == NULL) {
+		return -EINVAL;
+	}
+	if (window->count != ECG_PROCESSOR_WINDOW_SIZE) {
+		return -ENODATA;
+	}
+
+	standardize_ecg_window(window);
+
+	return ecg_prepare_standardized_model_inputs(window, workspace, result);
+}
+
+int ecg_prepare_standardized_model_inputs(struct ecg_sample_window *window,
+					  struct ecg_processing_workspace *workspace,
+					  struct ecg_processing_result *result)
 {
 	int err;
 
@@ -294,9 +1327,12 @@ int ecg_prepare_model_inputs(struct ecg_sample_window *window,
 		return -ENODATA;
 	}
 
-	standardize_ecg_window(window->samples);
-	integrate_squared_derivative(window->samples, workspace);
-	result->r_peak_count = detect_r_peaks(workspace);
+	ecg_qrs_detector_reset(&workspace->qrs);
+	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
+		ecg_qrs_detector_append(&workspace->qrs, window->samples[index]);
+	}
+	result->r_peak_count = ecg_qrs_detector_finish(&workspace->qrs, workspace->r_peak_indices,
+						       ECG_PROCESSING_MAX_R_PEAKS);
 	err = ecg_extract_rr_features(workspace->r_peak_indices, result->r_peak_count,
 				      &result->rr);
 	if (err < 0) {
@@ -305,3 +1341,62 @@ int ecg_prepare_model_inputs(struct ecg_sample_window *window,
 
 	return 0;
 }
+#endif
+
+int ecg_prepare_model_inputs_from_detector(struct ecg_sample_window *window,
+					   struct ecg_qrs_detector *detector,
+					   size_t *peak_indices, int8_t *quantized_ecg,
+					   struct ecg_processing_result *result)
+{
+	int err;
+
+	if (window == NULL || detector == NULL || peak_indices == NULL || result == NULL) {
+		return -EINVAL;
+	}
+	if (window->count != ECG_PROCESSOR_WINDOW_SIZE ||
+	    detector->sample_count != ECG_PROCESSOR_WINDOW_SIZE) {
+		return -ENODATA;
+	}
+
+	/* The detector already integrated every sample during capture. */
+	err = write_ecg_model_input(window, quantized_ecg);
+	if (err < 0) {
+		return err;
+	}
+	result->r_peak_count = ecg_qrs_detector_finish(detector, peak_indices,
+						       ECG_PROCESSING_MAX_R_PEAKS);
+	err = ecg_extract_rr_features(peak_indices, result->r_peak_count, &result->rr);
+	if (err < 0) {
+		return err;
+	}
+
+	return 0;
+}
+
+int ecg_prepare_model_inputs_from_intervals(struct ecg_sample_window *window,
+					    const float *intervals_ms, size_t interval_count,
+					    int8_t *quantized_ecg,
+					    struct ecg_processing_result *result)
+{
+	int err;
+
+	if (window == NULL || result == NULL) {
+		return -EINVAL;
+	}
+	if (window->count != ECG_PROCESSOR_WINDOW_SIZE) {
+		return -ENODATA;
+	}
+
+	/* The front end already located the beats, so only the ECG branch is scaled here. */
+	err = write_ecg_model_input(window, quantized_ecg);
+	if (err < 0) {
+		return err;
+	}
+	result->r_peak_count = interval_count > 0U ? interval_count + 1U : 0U;
+	err = ecg_extract_rr_features_from_intervals(intervals_ms, interval_count, &result->rr);
+	if (err < 0) {
+		return err;
+	}
+
+	return 0;
+}
@@ -5,6 +5,7 @@
 #include "ecg_processing.h"
 
 #include <errno.h>
+#include <string.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
@@ -12,42 +13,428 @@
 
 LOG_MODULE_REGISTER(ecg_processor, CONFIG_LOG_DEFAULT_LEVEL);
 
+#define ECG_WINDOW_HOP_SIZE CONFIG_TINYCARDIA_ECG_WINDOW_HOP_SAMPLES
+
+#if ECG_WINDOW_HOP_SIZE < ECG_PROCESSOR_WINDOW_SIZE
+#define ECG_SLIDING_WINDOWS 1
+#endif
+
+#if defined(ECG_SLIDING_WINDOWS)
+#define WINDOW_HOP_BLOCKS   (ECG_PROCESSOR_WINDOW_SIZE / ECG_WINDOW_HOP_SIZE)
+/* One spare block keeps a completed window intact for a whole hop after it is queued. */
+#define CAPTURE_BLOCK_COUNT (WINDOW_HOP_BLOCKS + 1U)
+/* A window is overwritten a hop after the next one completes, so two cover every live one. */
+#define WINDOW_QUEUE_DEPTH  2U
+
+BUILD_ASSERT(ECG_PROCESSOR_WINDOW_SIZE % ECG_WINDOW_HOP_SIZE == 0U,
+	     "The window hop must divide the 2,560-sample window");
+#else
 #define ECG_WINDOW_SLOT_COUNT 2U
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+#define STREAM_CHUNK_SIZE     CONFIG_TINYCARDIA_ECG_STREAM_CHUNK_SAMPLES
+/* Queued instead of a slot index when the capture slot completes a chunk; at most one waits. */
+#define STREAM_CHUNK_MESSAGE  0xffU
+#define WINDOW_QUEUE_DEPTH    (ECG_WINDOW_SLOT_COUNT + 1U)
+
+BUILD_ASSERT(ECG_PROCESSOR_WINDOW_SIZE % STREAM_CHUNK_SIZE == 0U,
+	     "The stream chunk must divide the 2,560-sample window");
+#else
+#define WINDOW_QUEUE_DEPTH ECG_WINDOW_SLOT_COUNT
+#endif
+#endif
 
 struct ecg_window_slot {
 	struct ecg_sample_window samples;
+#if defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+	float rr_intervals_ms[ECG_PROCESSING_MAX_R_PEAKS - 1U];
+	size_t rr_interval_count;
+#elif defined(ECG_SLIDING_WINDOWS)
+	/* First capture block of the window; samples.stats holds its merged statistics. */
+	uint32_t first_block;
+#else
+	/* Fed as samples are captured, so R-peak detection finishes with the window. */
+	struct ecg_qrs_detector qrs;
+#endif
+	size_t filled_sample_count;
+	size_t fast_recovery_sample_count;
+	size_t lead_off_sample_count;
+	struct ecg_quality_stats quality;
 	uint32_t start_timestamp_ms;
 	uint32_t end_timestamp_ms;
 	uint32_t monitoring_generation;
+#if !defined(ECG_SLIDING_WINDOWS)
 	bool queued;
 	bool processing;
+#endif
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+	/* Changes whenever the slot is reset, so streamed chunks never mix two windows. */
+	uint32_t capture_id;
+#endif
+};
+
+#if defined(ECG_SLIDING_WINDOWS)
+/* Statistics and quality counts for one hop of captured samples. */
+struct ecg_capture_block {
+	struct ecg_running_stats stats;
+	size_t filled_sample_count;
+	size_t fast_recovery_sample_count;
+	size_t lead_off_sample_count;
+	struct ecg_quality_stats quality;
+	uint32_t start_timestamp_ms;
+	uint32_t end_timestamp_ms;
+	uint32_t sequence;
+};
+
+struct ecg_window_ticket {
+	uint32_t first_block;
+	uint32_t monitoring_generation;
 };
 
+/*
+ * Capture ring: block sequence n is stored at index n % CAPTURE_BLOCK_COUNT.
+ * Each completed hop closes a window over the last WINDOW_HOP_BLOCKS blocks,
+ * which the processing thread standardizes straight into prepared_slot.
+ */
+static ecg_sample_t capture_ring[CAPTURE_BLOCK_COUNT][ECG_WINDOW_HOP_SIZE];
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_FILTER)
+/* Filtered copy of capture_ring that feeds R-peak detection. */
+static ecg_sample_t detection_ring[CAPTURE_BLOCK_COUNT][ECG_WINDOW_HOP_SIZE];
+#endif
+static struct ecg_capture_block capture_blocks[CAPTURE_BLOCK_COUNT];
+static uint32_t capture_block_sequence;
+static size_t capture_block_fill;
+static size_t completed_block_run;
+static ecg_sample_t last_sample;
+static size_t skipped_window_count;
+static struct ecg_window_slot prepared_slot;
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+/* Statistics that quantize windows in place of their own. Only the processing thread uses them. */
+static struct ecg_running_stats reference_stats;
+/* Monitoring generation reference_stats belong to; zero before the first window. */
+static uint32_t reference_generation;
+#endif
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+/* Borrowed with ecg_processor_set_workspace(); dead once the window handler runs. */
+static struct ecg_processing_workspace *processing_workspace;
+#else
+static struct ecg_processing_workspace workspace_storage;
+static struct ecg_processing_workspace *const processing_workspace = &workspace_storage;
+#endif
+#else
 static struct ecg_window_slot window_slots[ECG_WINDOW_SLOT_COUNT];
-static struct ecg_processing_workspace processing_workspace;
+static int8_t capture_slot = -1;
+static size_t discarded_sample_count;
+#if !defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+static size_t r_peak_indices[ECG_PROCESSING_MAX_R_PEAKS];
+#endif
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+/* The window whose chunks reach the chunk handler. Only the processing thread uses it. */
+struct ecg_stream_state {
+	uint32_t capture_id;
+	size_t streamed_count;
+	struct ecg_running_stats reference;
+	bool active;
+};
+
+static ecg_chunk_handler_t chunk_handler;
+static void *chunk_handler_data;
+static uint32_t capture_count;
+/* Statistics of the last completed window, which quantize the chunks of the next one. */
+static struct ecg_running_stats completed_window_stats;
+static bool completed_window_stats_valid;
+static bool chunk_message_queued;
+static struct ecg_stream_state stream;
+static ecg_sample_t stream_samples[STREAM_CHUNK_SIZE];
+static int8_t stream_quantized[STREAM_CHUNK_SIZE];
+#endif
+#endif
 static struct ecg_processing_result processing_result;
 
+/*
+ * capture_lock guards the capture state shared with the processing thread and
+ * the control calls. Samples are decoded and analyzed without it: the block or
+ * slot being filled, the quality history, and the detection filter belong to
+ * the acquisition context, and the lock only publishes what it appended.
+ */
 static struct k_spinlock capture_lock;
-static int8_t capture_slot = -1;
 static bool processor_initialized;
 static bool monitoring_enabled;
+static bool lead_off_active;
 static uint32_t monitoring_generation;
-static size_t discarded_sample_count;
+static uint32_t last_sample_timestamp_ms;
 static ecg_window_handler_t prepared_window_handler;
 static void *prepared_window_handler_data;
+static int8_t *model_ecg_input;
+/* Both run across window boundaries and restart whenever captured samples stop being contiguous. */
+static struct ecg_quality_tracker quality_tracker;
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_FILTER)
+static struct ecg_qrs_filter qrs_filter;
+#endif
+/* Advanced by every capture restart; samples analyzed under an older epoch are discarded. */
+static uint32_t capture_epoch;
+/* Epoch of the sample history and the capture target. Only acquisition uses it. */
+static uint32_t acquisition_epoch;
+
+#if defined(ECG_SLIDING_WINDOWS)
+K_MSGQ_DEFINE(window_ready_queue, sizeof(struct ecg_window_ticket), WINDOW_QUEUE_DEPTH, 4);
+#else
+K_MSGQ_DEFINE(window_ready_queue, sizeof(uint8_t), WINDOW_QUEUE_DEPTH, 1);
+#endif
+
+/*
+ * Restart the quality history and detection filter after a discontinuity.
+ * Caller holds the lock. Acquisition applies the restart before its next sample.
+ */
+static inline void restart_sample_history(void)
+{
+	++capture_epoch;
+}
+
+/*
+ * Catch up with a capture restart before analyzing a batch. Returns true when
+ * one happened since the last batch. Acquisition calls this with the lock held.
+ */
+static bool sync_acquisition_epoch(void)
+{
+	if (acquisition_epoch == capture_epoch) {
+		return false;
+	}
+	acquisition_epoch = capture_epoch;
+	ecg_quality_tracker_reset(&quality_tracker);
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_FILTER)
+	ecg_qrs_filter_reset(&qrs_filter);
+#endif
+
+	return true;
+}
+
+/* The value R-peak detection sees for the next captured sample. Only acquisition calls it. */
+static inline ecg_sample_t detection_sample(ecg_sample_t sample)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_FILTER)
+	return ecg_qrs_filter_apply(&qrs_filter, sample);
+#else
+	return sample;
+#endif
+}
+
+#if defined(ECG_SLIDING_WINDOWS)
+static struct ecg_capture_block *block_for_sequence(uint32_t sequence)
+{
+	return &capture_blocks[sequence % CAPTURE_BLOCK_COUNT];
+}
+
+/* True while no block of the window starting at first_block was reused. Caller holds the lock. */
+static bool window_blocks_intact(uint32_t first_block)
+{
+	for (uint32_t block = 0U; block < WINDOW_HOP_BLOCKS; ++block) {
+		if (block_for_sequence(first_block + block)->sequence != first_block + block) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Make the next window wait for a full window of new samples. Caller holds the lock. */
+static void restart_capture(void)
+{
+	capture_block_fill = 0U;
+	completed_block_run = 0U;
+	restart_sample_history();
+}
+
+/*
+ * Take the queued window's metadata and merged block statistics into
+ * prepared_slot. Returns false for a window from an earlier monitoring
+ * session or one already overwritten by acquisition.
+ */
+static bool claim_window(const struct ecg_window_ticket *ticket)
+{
+	struct ecg_window_slot *slot = &prepared_slot;
+	bool current;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&capture_lock);
+	current = monitoring_enabled && ticket->monitoring_generation == monitoring_generation;
+	if (current && !window_blocks_intact(ticket->first_block)) {
+		++skipped_window_count;
+		current = false;
+	}
+	if (current) {
+		/* The samples themselves are copied in by copy_window_inputs(). */
+		slot->samples.count = ECG_PROCESSOR_WINDOW_SIZE;
+		ecg_running_stats_reset(&slot->samples.stats);
+		slot->first_block = ticket->first_block;
+		slot->filled_sample_count = 0U;
+		slot->fast_recovery_sample_count = 0U;
+		slot->lead_off_sample_count = 0U;
+		ecg_quality_stats_reset(&slot->quality);
+		for (uint32_t index = 0U; index < WINDOW_HOP_BLOCKS; ++index) {
+			const struct ecg_capture_block *block =
+				block_for_sequence(ticket->first_block + index);
+
+			ecg_running_stats_merge(&slot->samples.stats, &block->stats);
+			slot->filled_sample_count += block->filled_sample_count;
+			slot->fast_recovery_sample_count += block->fast_recovery_sample_count;
+			slot->lead_off_sample_count += block->lead_off_sample_count;
+			ecg_quality_stats_merge(&slot->quality, &block->quality);
+			if (index == 0U) {
+				slot->start_timestamp_ms = block->start_timestamp_ms;
+			}
+			slot->end_timestamp_ms = block->end_timestamp_ms;
+		}
+		slot->monitoring_generation = ticket->monitoring_generation;
+	}
+	k_spin_unlock(&capture_lock, key);
+
+	return current;
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+/*
+ * Statistics to quantize the window with: the reference window's while its own
+ * stay within the tolerance of them, so the samples consecutive windows share
+ * quantize to the same values; otherwise its own, which become the reference.
+ */
+static const struct ecg_running_stats *quantization_stats(const struct ecg_window_slot *slot)
+{
+	if (reference_generation != slot->monitoring_generation ||
+	    !ecg_running_stats_within(&slot->samples.stats, &reference_stats,
+				      CONFIG_TINYCARDIA_ECG_STREAM_STATS_TOLERANCE_PERMILLE)) {
+		reference_stats = slot->samples.stats;
+		reference_generation = slot->monitoring_generation;
+	}
+
+	return &reference_stats;
+}
+#endif
+
+/*
+ * Standardize the window's ring blocks into one contiguous buffer in a single
+ * pass, or quantize them straight into quantized_ecg while feeding the
+ * detector. Acquisition never waits for this copy; a block reused while it ran
+ * is detected afterwards and the window is skipped.
+ */
+static int copy_window_inputs(struct ecg_window_slot *slot, int8_t *quantized_ecg,
+			      struct ecg_processing_workspace *workspace)
+{
+	const struct ecg_running_stats *stats = &slot->samples.stats;
+	bool intact;
+	k_spinlock_key_t key;
+
+	if (quantized_ecg == NULL && IS_ENABLED(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)) {
+		/* Q15 windows are only ever standardized into the INT8 model input. */
+		return -ENOTSUP;
+	}
+	if (workspace == NULL) {
+		return -ENOMEM;
+	}
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+	if (quantized_ecg != NULL) {
+		stats = quantization_stats(slot);
+	}
+#endif
+	ecg_qrs_detector_reset(&workspace->qrs);
+	for (uint32_t block = 0U; block < WINDOW_HOP_BLOCKS; ++block) {
+		uint32_t ring_index = (slot->first_block + block) % CAPTURE_BLOCK_COUNT;
+		const ecg_sample_t *samples = capture_ring[ring_index];
+		const ecg_sample_t *detection_samples = samples;
+		size_t offset = block * ECG_WINDOW_HOP_SIZE;
+
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_FILTER)
+		detection_samples = detection_ring[ring_index];
+#endif
+#if !defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+		if (quantized_ecg == NULL) {
+			ecg_running_stats_standardize(&slot->samples.stats, samples,
+						      &slot->samples.samples[offset],
+						      ECG_WINDOW_HOP_SIZE);
+		}
+#endif
+		if (quantized_ecg != NULL) {
+			ecg_running_stats_quantize(stats, samples, &quantized_ecg[offset],
+						   ECG_WINDOW_HOP_SIZE);
+		}
+		/* Peaks do not depend on offset or scale, so detection needs no standardizing. */
+		for (size_t index = 0U; index < ECG_WINDOW_HOP_SIZE; ++index) {
+			ecg_qrs_detector_append(&workspace->qrs, detection_samples[index]);
+		}
+	}
+
+	key = k_spin_lock(&capture_lock);
+	intact = window_blocks_intact(slot->first_block);
+	if (!intact) {
+		++skipped_window_count;
+	}
+	k_spin_unlock(&capture_lock, key);
+
+	return intact ? 0 : -ESTALE;
+}
+
+/* Finish detection over the samples copy_window_inputs() fed from the ring. */
+static int finish_window_detection(struct ecg_processing_workspace *workspace)
+{
+	processing_result.r_peak_count = ecg_qrs_detector_finish(
+		&workspace->qrs, workspace->r_peak_indices, ECG_PROCESSING_MAX_R_PEAKS);
+
+	return ecg_extract_rr_features(workspace->r_peak_indices, processing_result.r_peak_count,
+				       &processing_result.rr);
+}
+
+static uint32_t window_start_sample(const struct ecg_window_slot *slot)
+{
+	return slot->first_block * ECG_WINDOW_HOP_SIZE;
+}
+
+/* Copy the window out of the ring and detect its R peaks over the copy. */
+static int prepare_model_inputs(struct ecg_window_slot *slot, int8_t *quantized_ecg)
+{
+	struct ecg_processing_workspace *workspace;
+	k_spinlock_key_t key;
+	int err;
+
+	key = k_spin_lock(&capture_lock);
+	workspace = processing_workspace;
+	k_spin_unlock(&capture_lock, key);
+
+	err = copy_window_inputs(slot, quantized_ecg, workspace);
+	if (err < 0) {
+		return err;
+	}
 
-K_MSGQ_DEFINE(window_ready_queue, sizeof(uint8_t), ECG_WINDOW_SLOT_COUNT, 1);
+	return finish_window_detection(workspace);
+}
 
+/* Overlapping windows are never streamed. */
+static bool window_streamed(const struct ecg_window_slot *slot)
+{
+	ARG_UNUSED(slot);
+	return false;
+}
+#else
 static void reset_slot(uint8_t slot_index)
 {
 	struct ecg_window_slot *slot = &window_slots[slot_index];
 
 	ecg_sample_window_reset(&slot->samples);
+#if defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+	slot->rr_interval_count = 0U;
+#else
+	ecg_qrs_detector_reset(&slot->qrs);
+#endif
+	slot->filled_sample_count = 0U;
+	slot->fast_recovery_sample_count = 0U;
+	slot->lead_off_sample_count = 0U;
+	ecg_quality_stats_reset(&slot->quality);
 	slot->start_timestamp_ms = 0U;
 	slot->end_timestamp_ms = 0U;
 	slot->monitoring_generation = 0U;
 	slot->queued = false;
 	slot->processing = false;
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+	slot->capture_id = ++capture_count;
+#endif
 }
 
 static int find_available_slot(void)
@@ -61,33 +448,271 @@ static int find_available_slot(void)
 	return -1;
 }
 
+/*
+ * The slot acquisition appends to, reset first when capture restarted since
+ * its last sample, or NULL while none is free. Acquisition calls this with
+ * the lock held.
+ */
+static struct ecg_window_slot *acquisition_slot(void)
+{
+	if (capture_slot < 0) {
+		return NULL;
+	}
+	if (sync_acquisition_epoch()) {
+		reset_slot((uint8_t)capture_slot);
+	}
+
+	return &window_slots[capture_slot];
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+/*
+ * Quantize the complete chunks of slot that were not streamed yet with the
+ * reference statistics and pass them to the chunk handler. A slot reset since
+ * its last chunk holds a new window, which starts again at offset 0.
+ */
+static void stream_window_chunks(const struct ecg_window_slot *slot)
+{
+	while (true) {
+		ecg_chunk_handler_t handler;
+		void *handler_data;
+		size_t offset;
+		k_spinlock_key_t key;
+
+		key = k_spin_lock(&capture_lock);
+		handler = chunk_handler;
+		handler_data = chunk_handler_data;
+		if (slot->capture_id != stream.capture_id) {
+			stream.capture_id = slot->capture_id;
+			stream.streamed_count = 0U;
+			stream.reference = completed_window_stats;
+			stream.active = completed_window_stats_valid && handler != NULL;
+		} else if (handler == NULL) {
+			stream.active = false;
+		}
+		offset = stream.streamed_count;
+		if (!stream.active || slot->samples.count - offset < STREAM_CHUNK_SIZE) {
+			k_spin_unlock(&capture_lock, key);
+			return;
+		}
+		/* Acquisition may restart the slot once the lock is released, so copy the chunk. */
+		memcpy(stream_samples, &slot->samples.samples[offset], sizeof(stream_samples));
+		k_spin_unlock(&capture_lock, key);
+
+		ecg_running_stats_quantize(&stream.reference, stream_samples, stream_quantized,
+					   STREAM_CHUNK_SIZE);
+		handler(stream_quantized, offset, STREAM_CHUNK_SIZE, handler_data);
+		stream.streamed_count = offset + STREAM_CHUNK_SIZE;
+	}
+}
+
+/* Stream the capture slot unless a completed window still has to finish its own stream. */
+static void stream_capture_chunks(void)
+{
+	bool window_queued = false;
+	k_spinlock_key_t key;
+	int8_t slot_index;
+
+	key = k_spin_lock(&capture_lock);
+	/* After a restart the slot holds old samples until acquisition resets it. */
+	slot_index = acquisition_epoch == capture_epoch ? capture_slot : -1;
+	for (uint8_t index = 0U; index < ECG_WINDOW_SLOT_COUNT; ++index) {
+		window_queued = window_queued || window_slots[index].queued;
+	}
+	k_spin_unlock(&capture_lock, key);
+
+	if (slot_index >= 0 && !window_queued) {
+		stream_window_chunks(&window_slots[slot_index]);
+	}
+}
+
+/*
+ * Track the stream after acquisition publishes samples from first_count on.
+ * Returns true when a chunk completed and the processing thread should wake.
+ * Caller holds the lock.
+ */
+static bool stream_capture_progress(const struct ecg_window_slot *slot, size_t first_count)
+{
+	if (slot->samples.count == ECG_PROCESSOR_WINDOW_SIZE) {
+		completed_window_stats = slot->samples.stats;
+		completed_window_stats_valid = true;
+		return false;
+	}
+	if (chunk_handler == NULL || chunk_message_queued ||
+	    slot->samples.count / STREAM_CHUNK_SIZE == first_count / STREAM_CHUNK_SIZE) {
+		return false;
+	}
+	chunk_message_queued = true;
+
+	return true;
+}
+
+/* True when every chunk of the window went out with statistics close to its own. */
+static bool window_streamed(const struct ecg_window_slot *slot)
+{
+	return stream.active && stream.capture_id == slot->capture_id &&
+	       stream.streamed_count == ECG_PROCESSOR_WINDOW_SIZE &&
+	       ecg_running_stats_within(&slot->samples.stats, &stream.reference,
+					CONFIG_TINYCARDIA_ECG_STREAM_STATS_TOLERANCE_PERMILLE);
+}
+#else
+static bool stream_capture_progress(const struct ecg_window_slot *slot, size_t first_count)
+{
+	ARG_UNUSED(slot);
+	ARG_UNUSED(first_count);
+	return false;
+}
+
+static bool window_streamed(const struct ecg_window_slot *slot)
+{
+	ARG_UNUSED(slot);
+	return false;
+}
+#endif
+
+static uint32_t window_start_sample(const struct ecg_window_slot *slot)
+{
+	ARG_UNUSED(slot);
+	return 0U;
+}
+
+/* Feed one captured sample to the slot's detector, unless the front end supplies RR. */
+static void detect_slot_sample(struct ecg_window_slot *slot, ecg_sample_t sample)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+	ARG_UNUSED(slot);
+	ARG_UNUSED(sample);
+#else
+	ecg_qrs_detector_append(&slot->qrs, detection_sample(sample));
+#endif
+}
+
+/*
+ * Finish the stream and the model inputs of a completed slot, whose R peaks
+ * were detected while it was captured or come from the front end.
+ */
+static int prepare_model_inputs(struct ecg_window_slot *slot, int8_t *quantized_ecg)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+	/* Before float samples are standardized in place. Usually only the last chunk is left. */
+	stream_window_chunks(slot);
+#endif
+#if defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+	return ecg_prepare_model_inputs_from_intervals(&slot->samples, slot->rr_intervals_ms,
+						       slot->rr_interval_count, quantized_ecg,
+						       &processing_result);
+#else
+	return ecg_prepare_model_inputs_from_detector(&slot->samples, &slot->qrs, r_peak_indices,
+						      quantized_ecg, &processing_result);
+#endif
+}
+#endif
+
 static int prepare_window(struct ecg_window_slot *slot,
 			  struct ecg_prepared_window *window)
 {
+	int8_t *quantized_ecg;
 	uint32_t start_cycles;
+	k_spinlock_key_t key;
 	int err;
 
+	window->sample_count = slot->samples.count;
+	window->filled_sample_count = slot->filled_sample_count;
+	window->fast_recovery_sample_count = slot->fast_recovery_sample_count;
+	window->lead_off_sample_count = slot->lead_off_sample_count;
+	window->start_timestamp_ms = slot->start_timestamp_ms;
+	window->end_timestamp_ms = slot->end_timestamp_ms;
+	window->streamed = false;
+	window->start_sample = window_start_sample(slot);
+	ecg_quality_stats_evaluate(&slot->quality, &window->quality);
+	window->usable = slot->fast_recovery_sample_count == 0U &&
+			 slot->lead_off_sample_count == 0U &&
+			 window->quality.level != ECG_SIGNAL_QUALITY_UNUSABLE;
+	if (!window->usable) {
+		/*
+		 * Known-bad input, including a railed, flat, or noise-dominated
+		 * window, is not worth R-peak detection or inference.
+		 */
+		window->ecg_samples = NULL;
+		window->ecg_quantized_samples = NULL;
+		window->rr_features = NULL;
+		window->rr_features_unscaled = NULL;
+		window->r_peak_count = 0U;
+		window->rr_features_valid = false;
+		window->preparation_time_us = 0U;
+		return 0;
+	}
+
+	key = k_spin_lock(&capture_lock);
+	quantized_ecg = model_ecg_input;
+	k_spin_unlock(&capture_lock, key);
+
 	start_cycles = k_cycle_get_32();
-	err = ecg_prepare_model_inputs(&slot->samples, &processing_workspace,
-				       &processing_result);
+	err = prepare_model_inputs(slot, quantized_ecg);
 	window->preparation_time_us = (uint32_t)k_cyc_to_us_floor64(
 		(uint32_t)(k_cycle_get_32() - start_cycles));
 	if (err < 0) {
 		return err;
 	}
 
-	window->ecg_samples = slot->samples.samples;
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+	window->ecg_samples = NULL;
+#else
+	window->ecg_samples = quantized_ecg == NULL ? slot->samples.samples : NULL;
+#endif
+	window->ecg_quantized_samples = quantized_ecg;
 	window->rr_features = processing_result.rr.features_standardized;
 	window->rr_features_unscaled = processing_result.rr.features_unscaled;
-	window->sample_count = slot->samples.count;
 	window->r_peak_count = processing_result.r_peak_count;
 	window->rr_features_valid = processing_result.rr.features_valid;
-	window->start_timestamp_ms = slot->start_timestamp_ms;
-	window->end_timestamp_ms = slot->end_timestamp_ms;
+	window->streamed = window_streamed(slot);
 
 	return 0;
 }
 
+#if defined(ECG_SLIDING_WINDOWS)
+static void ecg_processor_thread(void *arg1, void *arg2, void *arg3)
+{
+	struct ecg_prepared_window window;
+
+	ARG_UNUSED(arg1);
+	ARG_UNUSED(arg2);
+	ARG_UNUSED(arg3);
+
+	while (true) {
+		struct ecg_window_ticket ticket;
+		size_t skipped_windows;
+		bool publish_window = false;
+		k_spinlock_key_t key;
+		int err = 0;
+
+		k_msgq_get(&window_ready_queue, &ticket, K_FOREVER);
+
+		if (claim_window(&ticket)) {
+			err = prepare_window(&prepared_slot, &window);
+			key = k_spin_lock(&capture_lock);
+			publish_window = monitoring_enabled &&
+					 ticket.monitoring_generation == monitoring_generation;
+			k_spin_unlock(&capture_lock, key);
+		}
+		if (err < 0 && err != -ESTALE) {
+			LOG_ERR("ECG window preparation failed: %d", err);
+		} else if (err == 0 && publish_window && prepared_window_handler != NULL) {
+			prepared_window_handler(&window, prepared_window_handler_data);
+		}
+
+		key = k_spin_lock(&capture_lock);
+		skipped_windows = skipped_window_count;
+		skipped_window_count = 0U;
+		k_spin_unlock(&capture_lock, key);
+
+		if (skipped_windows > 0U) {
+			LOG_WRN("ECG processing backpressure skipped %u windows",
+				(unsigned int)skipped_windows);
+		}
+	}
+}
+#else
 static void ecg_processor_thread(void *arg1, void *arg2, void *arg3)
 {
 	struct ecg_prepared_window window;
@@ -106,6 +731,15 @@ static void ecg_processor_thread(void *arg1, void *arg2, void *arg3)
 		int err;
 
 		k_msgq_get(&window_ready_queue, &slot_index, K_FOREVER);
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+		if (slot_index == STREAM_CHUNK_MESSAGE) {
+			key = k_spin_lock(&capture_lock);
+			chunk_message_queued = false;
+			k_spin_unlock(&capture_lock, key);
+			stream_capture_chunks();
+			continue;
+		}
+#endif
 
 		key = k_spin_lock(&capture_lock);
 		slot = &window_slots[slot_index];
@@ -132,7 +766,9 @@ static void ecg_processor_thread(void *arg1, void *arg2, void *arg3)
 		key = k_spin_lock(&capture_lock);
 		reset_slot(slot_index);
 		if (monitoring_enabled && capture_slot < 0) {
+			/* Samples were refused meanwhile, so the stream restarts here. */
 			capture_slot = slot_index;
+			restart_sample_history();
 		}
 		discarded_samples = discarded_sample_count;
 		discarded_sample_count = 0U;
@@ -142,8 +778,13 @@ static void ecg_processor_thread(void *arg1, void *arg2, void *arg3)
 			LOG_WRN("ECG capture backpressure dropped %u samples",
 				(unsigned int)discarded_samples);
 		}
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+		/* Chunks of the next window that completed while this one was handled. */
+		stream_capture_chunks();
+#endif
 	}
 }
+#endif
 
 K_THREAD_DEFINE(ecg_processor_thread_id, CONFIG_TINYCARDIA_ECG_THREAD_STACK_SIZE,
 		ecg_processor_thread, NULL, NULL, NULL, CONFIG_TINYCARDIA_ECG_THREAD_PRIORITY, 0,
@@ -161,23 +802,94 @@ int ecg_processor_init(ecg_window_handler_t window_handler, void *user_data)
 
 	prepared_window_handler = window_handler;
 	prepared_window_handler_data = user_data;
+#if defined(ECG_SLIDING_WINDOWS)
+	restart_capture();
+	skipped_window_count = 0U;
+#else
 	for (uint8_t index = 0U; index < ECG_WINDOW_SLOT_COUNT; ++index) {
 		reset_slot(index);
 	}
 	discarded_sample_count = 0U;
+	capture_slot = 0;
+	restart_sample_history();
+#endif
 	monitoring_generation = 1U;
 	monitoring_enabled = true;
-	capture_slot = 0;
 	processor_initialized = true;
 	k_spin_unlock(&capture_lock, key);
 
+	/* Attributes the logged preparation times when comparing kernel builds. */
+	LOG_INF("ECG window passes use %s kernels",
+		IS_ENABLED(CONFIG_TINYCARDIA_ECG_CMSIS_DSP) ? "CMSIS-DSP" : "portable C");
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+	/* The model input departs from the training's per-window z-score by up to this. */
+	LOG_INF("ECG windows quantized with reference statistics within %u/1000 deviation",
+		(unsigned int)CONFIG_TINYCARDIA_ECG_STREAM_STATS_TOLERANCE_PERMILLE);
+#endif
+
+	return 0;
+}
+
+void ecg_processor_set_model_input(int8_t *ecg_input)
+{
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&capture_lock);
+	model_ecg_input = ecg_input;
+	k_spin_unlock(&capture_lock, key);
+}
+
+int ecg_processor_set_workspace(void *memory, size_t size)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+	k_spinlock_key_t key;
+
+	if (memory == NULL ||
+	    (uintptr_t)memory % __alignof__(struct ecg_processing_workspace) != 0U) {
+		return -EINVAL;
+	}
+	if (size < sizeof(struct ecg_processing_workspace)) {
+		return -ENOMEM;
+	}
+
+	key = k_spin_lock(&capture_lock);
+	processing_workspace = memory;
+	k_spin_unlock(&capture_lock, key);
+
+	return 0;
+#else
+	ARG_UNUSED(memory);
+	ARG_UNUSED(size);
+
+	return -ENOTSUP;
+#endif
+}
+
+int ecg_processor_set_chunk_handler(ecg_chunk_handler_t handler, void *user_data)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&capture_lock);
+	chunk_handler = handler;
+	chunk_handler_data = user_data;
+	k_spin_unlock(&capture_lock, key);
+
 	return 0;
+#else
+	ARG_UNUSED(handler);
+	ARG_UNUSED(user_data);
+
+	return -ENOTSUP;
+#endif
 }
 
 int ecg_processor_set_monitoring(bool enabled)
 {
 	k_spinlock_key_t key;
+#if !defined(ECG_SLIDING_WINDOWS)
 	int available_slot;
+#endif
 
 	key = k_spin_lock(&capture_lock);
 	if (!processor_initialized) {
@@ -192,17 +904,32 @@ int ecg_processor_set_monitoring(bool enabled)
 	if (!enabled) {
 		monitoring_enabled = false;
 		++monitoring_generation;
-		capture_slot = -1;
+#if defined(ECG_SLIDING_WINDOWS)
+		restart_capture();
+#else
+		/* Acquisition may still be filling the capture slot; it resets that one itself. */
 		for (uint8_t index = 0U; index < ECG_WINDOW_SLOT_COUNT; ++index) {
-			if (!window_slots[index].processing) {
+			if (window_slots[index].queued) {
 				reset_slot(index);
 			}
 		}
+		capture_slot = -1;
+		restart_sample_history();
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+		chunk_message_queued = false;
+#endif
+#endif
 		k_spin_unlock(&capture_lock, key);
 		k_msgq_purge(&window_ready_queue);
 		return 0;
 	}
 
+#if defined(ECG_SLIDING_WINDOWS)
+	/* The prepared window is a copy, so the ring is always free to restart. */
+	++monitoring_generation;
+	monitoring_enabled = true;
+	restart_capture();
+#else
 	available_slot = find_available_slot();
 	if (available_slot < 0) {
 		k_spin_unlock(&capture_lock, key);
@@ -210,73 +937,405 @@ int ecg_processor_set_monitoring(bool enabled)
 	}
 	++monitoring_generation;
 	monitoring_enabled = true;
-	reset_slot((uint8_t)available_slot);
 	capture_slot = (int8_t)available_slot;
 	discarded_sample_count = 0U;
+	restart_sample_history();
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+	/* The signal may have changed completely while monitoring was off. */
+	completed_window_stats_valid = false;
+#endif
+#endif
 	k_spin_unlock(&capture_lock, key);
 
 	return 0;
 }
 
-bool ecg_processor_submit_sample(uint32_t raw_word, uint32_t timestamp_ms)
+static uint32_t sample_timestamp_ms(uint32_t first_timestamp_ms, size_t index)
 {
-	struct ecg_window_slot *slot;
-	enum ecg_window_append_result append_result;
-	uint8_t completed_slot = 0U;
-	bool window_ready = false;
-	bool preserved = true;
-	float sample_mv;
+	return first_timestamp_ms +
+	       (uint32_t)(((uint64_t)index * MSEC_PER_SEC) / ECG_PROCESSOR_SAMPLE_RATE_HZ);
+}
+
+#if defined(ECG_SLIDING_WINDOWS)
+/* Hand a completed window to the processing thread, replacing the oldest if the queue is full. */
+static void queue_completed_window(const struct ecg_window_ticket *ticket)
+{
+	struct ecg_window_ticket oldest;
 	k_spinlock_key_t key;
 
-	sample_mv = ecg_decode_sample_mv(raw_word);
+	if (k_msgq_put(&window_ready_queue, ticket, K_NO_WAIT) == 0) {
+		return;
+	}
+
+	/* The oldest window is the next one acquisition overwrites, so it is the one to lose. */
 	key = k_spin_lock(&capture_lock);
-	if (!monitoring_enabled || capture_slot < 0) {
-		if (monitoring_enabled) {
-			++discarded_sample_count;
+	++skipped_window_count;
+	k_spin_unlock(&capture_lock, key);
+	if (k_msgq_get(&window_ready_queue, &oldest, K_NO_WAIT) != 0 ||
+	    k_msgq_put(&window_ready_queue, ticket, K_NO_WAIT) != 0) {
+		LOG_ERR("ECG processing queue full");
+	}
+}
+
+static void start_capture_block(struct ecg_capture_block *block, uint32_t timestamp_ms)
+{
+	ecg_running_stats_reset(&block->stats);
+	block->filled_sample_count = 0U;
+	block->fast_recovery_sample_count = 0U;
+	block->lead_off_sample_count = 0U;
+	ecg_quality_stats_reset(&block->quality);
+	block->start_timestamp_ms = timestamp_ms;
+	block->end_timestamp_ms = timestamp_ms;
+	/* Marks the previous contents as gone before any of them is overwritten. */
+	block->sequence = capture_block_sequence;
+}
+
+/*
+ * Append raw_words, or count copies of fill_sample when raw_words is NULL. Every
+ * completed hop closes a window over the last WINDOW_HOP_BLOCKS blocks; samples
+ * are never refused, because the processing thread works on its own copy.
+ */
+static size_t append_samples(const uint32_t *raw_words, ecg_sample_t fill_sample, size_t count,
+			     uint32_t first_timestamp_ms)
+{
+	size_t index = 0U;
+
+	while (index < count) {
+		struct ecg_capture_block *block;
+		struct ecg_window_ticket ticket;
+		bool window_completed = false;
+		ecg_sample_t *block_samples;
+		ecg_sample_t sample = last_sample;
+		uint32_t timestamp_ms = last_sample_timestamp_ms;
+		uint32_t ring_index;
+		uint32_t epoch;
+		size_t fill;
+		bool lead_off;
+		k_spinlock_key_t key;
+
+		key = k_spin_lock(&capture_lock);
+		if (!monitoring_enabled) {
+			k_spin_unlock(&capture_lock, key);
+			break;
+		}
+		(void)sync_acquisition_epoch();
+		epoch = acquisition_epoch;
+		fill = capture_block_fill;
+		lead_off = lead_off_active;
+		ring_index = capture_block_sequence % CAPTURE_BLOCK_COUNT;
+		block = block_for_sequence(capture_block_sequence);
+		if (fill == 0U) {
+			start_capture_block(block, sample_timestamp_ms(first_timestamp_ms, index));
 		}
 		k_spin_unlock(&capture_lock, key);
-		return false;
+
+		/* Fill the current block until the batch ends or the hop completes. */
+		block_samples = capture_ring[ring_index];
+		while (index < count && fill < ECG_WINDOW_HOP_SIZE) {
+			int32_t raw_sample = quality_tracker.last_sample;
+
+			timestamp_ms = sample_timestamp_ms(first_timestamp_ms, index);
+			sample = fill_sample;
+			if (raw_words != NULL) {
+				sample = ecg_decode_sample(raw_words[index]);
+				raw_sample = ecg_decode_raw_sample(raw_words[index]);
+				if (ecg_sample_is_fast_recovery(raw_words[index])) {
+					++block->fast_recovery_sample_count;
+				}
+			} else {
+				++block->filled_sample_count;
+			}
+			ecg_quality_stats_add(&block->quality, &quality_tracker, raw_sample);
+			if (lead_off) {
+				++block->lead_off_sample_count;
+			}
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_FILTER)
+			detection_ring[ring_index][fill] = detection_sample(sample);
+#endif
+			block_samples[fill++] = sample;
+			ecg_running_stats_add(&block->stats, sample);
+			block->end_timestamp_ms = timestamp_ms;
+			++index;
+		}
+
+		key = k_spin_lock(&capture_lock);
+		if (capture_epoch != epoch) {
+			/* Capture restarted meanwhile, so these samples belong to no window. */
+			k_spin_unlock(&capture_lock, key);
+			continue;
+		}
+		capture_block_fill = fill;
+		last_sample_timestamp_ms = timestamp_ms;
+		last_sample = sample;
+		if (capture_block_fill == ECG_WINDOW_HOP_SIZE) {
+			capture_block_fill = 0U;
+			++capture_block_sequence;
+			completed_block_run = MIN(completed_block_run + 1U, WINDOW_HOP_BLOCKS);
+			if (completed_block_run == WINDOW_HOP_BLOCKS) {
+				ticket.first_block = capture_block_sequence - WINDOW_HOP_BLOCKS;
+				ticket.monitoring_generation = monitoring_generation;
+				window_completed = true;
+			}
+		}
+		k_spin_unlock(&capture_lock, key);
+
+		if (window_completed) {
+			queue_completed_window(&ticket);
+		}
 	}
 
-	completed_slot = (uint8_t)capture_slot;
-	slot = &window_slots[completed_slot];
-	if (slot->samples.count == 0U) {
-		slot->start_timestamp_ms = timestamp_ms;
+	return index;
+}
+#else
+/* Hand a completed slot to the processing thread, discarding it if the queue is full. */
+static bool queue_completed_window(uint8_t completed_slot)
+{
+	k_spinlock_key_t key;
+
+	if (k_msgq_put(&window_ready_queue, &completed_slot, K_NO_WAIT) == 0) {
+		return true;
 	}
-	append_result = ecg_sample_window_append(&slot->samples, sample_mv);
-	if (append_result == ECG_WINDOW_COMPLETED) {
-		int next_slot;
 
-		slot->end_timestamp_ms = timestamp_ms;
-		slot->monitoring_generation = monitoring_generation;
-		slot->queued = true;
-		next_slot = find_available_slot();
-		if (next_slot >= 0) {
-			reset_slot((uint8_t)next_slot);
-			capture_slot = (int8_t)next_slot;
-		} else {
-			capture_slot = -1;
+	key = k_spin_lock(&capture_lock);
+	if (window_slots[completed_slot].queued) {
+		reset_slot(completed_slot);
+		if (monitoring_enabled && capture_slot < 0) {
+			capture_slot = completed_slot;
+			restart_sample_history();
 		}
-		window_ready = true;
 	}
+	++discarded_sample_count;
 	k_spin_unlock(&capture_lock, key);
+	LOG_ERR("ECG processing queue full");
+
+	return false;
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+/* Wake the processing thread for a new chunk; a full queue leaves it to the next catch-up. */
+static void queue_stream_chunk(void)
+{
+	uint8_t message = STREAM_CHUNK_MESSAGE;
+	k_spinlock_key_t key;
+
+	if (k_msgq_put(&window_ready_queue, &message, K_NO_WAIT) != 0) {
+		key = k_spin_lock(&capture_lock);
+		chunk_message_queued = false;
+		k_spin_unlock(&capture_lock, key);
+	}
+}
+#else
+static void queue_stream_chunk(void)
+{
+}
+#endif
+
+/*
+ * Append raw_words, or count copies of fill_sample when raw_words is NULL.
+ * Other threads never modify the capture slot; a restart only moves the
+ * capture epoch, and the slot is reset here before its next sample.
+ */
+static size_t append_samples(const uint32_t *raw_words, ecg_sample_t fill_sample, size_t count,
+			     uint32_t first_timestamp_ms)
+{
+	size_t preserved_count = 0U;
+	size_t index = 0U;
+
+	while (index < count) {
+		struct ecg_window_slot *slot;
+		enum ecg_window_append_result append_result = ECG_WINDOW_SAMPLE_STORED;
+		uint32_t timestamp_ms = last_sample_timestamp_ms;
+		uint8_t completed_slot;
+		size_t first_count;
+		size_t sample_count;
+		uint32_t epoch;
+		bool lead_off;
+		bool chunk_completed;
+		k_spinlock_key_t key;
 
-	if (window_ready &&
-	    k_msgq_put(&window_ready_queue, &completed_slot, K_NO_WAIT) < 0) {
 		key = k_spin_lock(&capture_lock);
-		if (window_slots[completed_slot].queued) {
-			reset_slot(completed_slot);
-			if (monitoring_enabled && capture_slot < 0) {
-				capture_slot = completed_slot;
+		slot = monitoring_enabled ? acquisition_slot() : NULL;
+		if (slot == NULL) {
+			if (monitoring_enabled && raw_words != NULL) {
+				discarded_sample_count += count - index;
 			}
+			k_spin_unlock(&capture_lock, key);
+			break;
 		}
-		++discarded_sample_count;
+		epoch = acquisition_epoch;
+		lead_off = lead_off_active;
+		completed_slot = (uint8_t)capture_slot;
+		first_count = slot->samples.count;
 		k_spin_unlock(&capture_lock, key);
-		preserved = false;
-		LOG_ERR("ECG processing queue full");
+
+		/* Fill the current slot until the batch ends or the window completes. */
+		sample_count = first_count;
+		while (index < count && sample_count < ECG_PROCESSOR_WINDOW_SIZE) {
+			ecg_sample_t sample = fill_sample;
+			int32_t raw_sample = quality_tracker.last_sample;
+
+			timestamp_ms = sample_timestamp_ms(first_timestamp_ms, index);
+			if (sample_count == 0U) {
+				slot->start_timestamp_ms = timestamp_ms;
+			}
+			if (raw_words != NULL) {
+				sample = ecg_decode_sample(raw_words[index]);
+				raw_sample = ecg_decode_raw_sample(raw_words[index]);
+				if (ecg_sample_is_fast_recovery(raw_words[index])) {
+					++slot->fast_recovery_sample_count;
+				}
+			} else {
+				++slot->filled_sample_count;
+			}
+			ecg_quality_stats_add(&slot->quality, &quality_tracker, raw_sample);
+			/* Beyond samples.count, so the chunk stream cannot see it yet. */
+			slot->samples.samples[sample_count++] = sample;
+			ecg_running_stats_add(&slot->samples.stats, sample);
+			detect_slot_sample(slot, sample);
+			if (lead_off) {
+				++slot->lead_off_sample_count;
+			}
+			++index;
+		}
+
+		key = k_spin_lock(&capture_lock);
+		if (capture_epoch != epoch) {
+			/* Capture restarted meanwhile, so these samples belong to no window. */
+			k_spin_unlock(&capture_lock, key);
+			continue;
+		}
+		slot->samples.count = sample_count;
+		preserved_count += sample_count - first_count;
+		last_sample_timestamp_ms = timestamp_ms;
+		if (sample_count == ECG_PROCESSOR_WINDOW_SIZE) {
+			append_result = ECG_WINDOW_COMPLETED;
+			slot->end_timestamp_ms = timestamp_ms;
+		}
+		chunk_completed = stream_capture_progress(slot, first_count);
+		if (append_result == ECG_WINDOW_COMPLETED) {
+			int next_slot;
+
+			slot->monitoring_generation = monitoring_generation;
+			slot->queued = true;
+			next_slot = find_available_slot();
+			if (next_slot >= 0) {
+				reset_slot((uint8_t)next_slot);
+				capture_slot = (int8_t)next_slot;
+			} else {
+				capture_slot = -1;
+			}
+		}
+		k_spin_unlock(&capture_lock, key);
+
+		if (chunk_completed) {
+			queue_stream_chunk();
+		}
+		if (append_result == ECG_WINDOW_COMPLETED &&
+		    !queue_completed_window(completed_slot)) {
+			--preserved_count;
+		}
 	}
 
-	return preserved;
+	return preserved_count;
+}
+#endif
+
+size_t ecg_processor_submit_samples(const uint32_t *raw_words, size_t count,
+				    uint32_t first_timestamp_ms)
+{
+	return append_samples(raw_words, 0, count, first_timestamp_ms);
+}
+
+bool ecg_processor_submit_gap(uint32_t missing_samples)
+{
+#if !defined(ECG_SLIDING_WINDOWS)
+	struct ecg_window_slot *slot;
+#endif
+	uint32_t first_timestamp_ms;
+	k_spinlock_key_t key;
+	ecg_sample_t fill_sample;
+
+	key = k_spin_lock(&capture_lock);
+#if defined(ECG_SLIDING_WINDOWS)
+	if (missing_samples == 0U || !monitoring_enabled ||
+	    (completed_block_run == 0U && capture_block_fill == 0U)) {
+		/* Nothing has been captured since the last restart, so nothing is shifted. */
+		k_spin_unlock(&capture_lock, key);
+		return true;
+	}
+	if (missing_samples > CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES) {
+		/* Every window overlapping the gap would be shifted, so start over. */
+		restart_capture();
+		k_spin_unlock(&capture_lock, key);
+		LOG_WRN("ECG gap of %u samples restarted window capture",
+			(unsigned int)missing_samples);
+		return false;
+	}
+	fill_sample = last_sample;
+#else
+	slot = missing_samples > 0U && monitoring_enabled ? acquisition_slot() : NULL;
+	if (slot == NULL || slot->samples.count == 0U) {
+		/* The gap falls between windows, so no captured window is shifted. */
+		k_spin_unlock(&capture_lock, key);
+		return true;
+	}
+
+	if (missing_samples > CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES) {
+		size_t restarted_count = slot->samples.count;
+
+		reset_slot((uint8_t)capture_slot);
+		restart_sample_history();
+		k_spin_unlock(&capture_lock, key);
+		LOG_WRN("ECG gap of %u samples restarted a window after %u samples",
+			(unsigned int)missing_samples, (unsigned int)restarted_count);
+		return false;
+	}
+	fill_sample = slot->samples.samples[slot->samples.count - 1U];
+#endif
+	first_timestamp_ms = sample_timestamp_ms(last_sample_timestamp_ms, 1U);
+	k_spin_unlock(&capture_lock, key);
+
+	/* Gaps come from the same context as the samples, so nothing interleaves here. */
+	(void)append_samples(NULL, fill_sample, missing_samples, first_timestamp_ms);
+
+	return true;
+}
+
+bool ecg_processor_submit_sample(uint32_t raw_word, uint32_t timestamp_ms)
+{
+	return ecg_processor_submit_samples(&raw_word, 1U, timestamp_ms) == 1U;
+}
+
+void ecg_processor_set_lead_off(bool lead_off)
+{
+	k_spinlock_key_t key = k_spin_lock(&capture_lock);
+
+	lead_off_active = lead_off;
+	k_spin_unlock(&capture_lock, key);
+}
+
+bool ecg_processor_submit_rr_interval(float interval_ms)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+	struct ecg_window_slot *slot;
+	bool stored = false;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&capture_lock);
+	slot = monitoring_enabled ? acquisition_slot() : NULL;
+	if (slot != NULL) {
+		if (slot->rr_interval_count < ARRAY_SIZE(slot->rr_intervals_ms)) {
+			slot->rr_intervals_ms[slot->rr_interval_count++] = interval_ms;
+			stored = true;
+		}
+	}
+	k_spin_unlock(&capture_lock, key);
+
+	return stored;
+#else
+	ARG_UNUSED(interval_ms);
+	return false;
+#endif
 }
 
 void ecg_processor_sample_handler(uint32_t raw_word, void *user_data)
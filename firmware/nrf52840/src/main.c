@@ -48,13 +48,30 @@ static void prepared_window_handler(const struct ecg_prepared_window *window,
 	uint64_t window_start_ms;
 	int32_t window_start_offset_ms;
 	uint32_t model_start_cycles;
+	uint32_t reused_samples = 0U;
 	uint32_t model_time_us;
 	int err;
 
 	ARG_UNUSED(user_data);
 
-	LOG_INF("ECG window prepared: %u samples, %u R peaks, RR features %s",
+	if (!window->usable) {
+		LOG_WRN("ECG window rejected: %u fast-recovery and %u lead-off samples, "
+			"SQI %u (%u saturated, %u flat, noise %u permille, drift %u uV)",
+			(unsigned int)window->fast_recovery_sample_count,
+			(unsigned int)window->lead_off_sample_count,
+			(unsigned int)window->quality.level,
+			(unsigned int)window->quality.saturated_sample_count,
+			(unsigned int)window->quality.longest_flat_sample_count,
+			(unsigned int)window->quality.noise_permille,
+			(unsigned int)window->quality.baseline_drift_uv);
+		return;
+	}
+
+	LOG_INF("ECG window prepared: %u samples (%u gap-filled), SQI %u, "
+		"%u R peaks, RR features %s",
 		(unsigned int)window->sample_count,
+		(unsigned int)window->filled_sample_count,
+		(unsigned int)window->quality.level,
 		(unsigned int)window->r_peak_count,
 		window->rr_features_valid ? "ready" : "insufficient R peaks");
 
@@ -67,7 +84,7 @@ static void prepared_window_handler(const struct ecg_prepared_window *window,
 	window_start_ms = (uint64_t)((int64_t)now_ms +
 		(int64_t)window_start_offset_ms);
 	if (!tinycardia_inference_window_is_eligible(
-		window->rr_features_valid, quality.current,
+		window->rr_features_valid, window->quality.level, quality.current,
 		window_start_ms, quality.good_since_ms)) {
 		LOG_WRN("Inference skipped: RR valid %u, signal quality %u",
 			(unsigned int)window->rr_features_valid,
@@ -76,9 +93,37 @@ static void prepared_window_handler(const struct ecg_prepared_window *window,
 	}
 
 	model_start_cycles = k_cycle_get_32();
-	err = tinycardia_model_infer(window->ecg_samples, window->sample_count,
-				     window->rr_features,
-				     ECG_PROCESSOR_RR_FEATURE_COUNT, &result);
+#if defined(CONFIG_TINYCARDIA_MODEL_STREAMING)
+	if (window->streamed) {
+		/* The convolutions already ran on the chunks as they were captured. */
+		err = tinycardia_model_stream_finish(window->rr_features,
+						     ECG_PROCESSOR_RR_FEATURE_COUNT, &result);
+		if (err < 0) {
+			LOG_WRN("Streamed inference failed (%d), invoking the whole window", err);
+			err = tinycardia_model_infer_quantized(
+				window->rr_features, ECG_PROCESSOR_RR_FEATURE_COUNT, &result);
+		}
+	} else
+#elif defined(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE)
+	if (window->ecg_quantized_samples != NULL) {
+		/* Activations of the samples shared with the previous window are kept. */
+		err = tinycardia_model_infer_window(window->start_sample, window->rr_features,
+						    ECG_PROCESSOR_RR_FEATURE_COUNT, &result);
+		if (err > 0) {
+			reused_samples = (uint32_t)err;
+			err = 0;
+		}
+	} else
+#endif
+	if (window->ecg_quantized_samples != NULL) {
+		/* Preprocessing already quantized the ECG window into the input tensor. */
+		err = tinycardia_model_infer_quantized(window->rr_features,
+						       ECG_PROCESSOR_RR_FEATURE_COUNT, &result);
+	} else {
+		err = tinycardia_model_infer(window->ecg_samples, window->sample_count,
+					     window->rr_features,
+					     ECG_PROCESSOR_RR_FEATURE_COUNT, &result);
+	}
 	if (err < 0) {
 		LOG_ERR("AFib inference failed: %d", err);
 		tinycardia_ble_status_set_error(true);
@@ -89,31 +134,62 @@ static void prepared_window_handler(const struct ecg_prepared_window *window,
 
 	err = tinycardia_ble_inference_publish(
 		window->end_timestamp_ms, result.classification,
-		TINYCARDIA_SIGNAL_QUALITY_GOOD, result.confidence);
+		tinycardia_inference_reported_quality(window->quality.level), result.confidence);
 	if (err < 0) {
 		LOG_ERR("BLE inference publication failed: %d", err);
 		return;
 	}
 
-	LOG_INF("Inference accepted: class %u, confidence %u, prep %u us, invoke %u us, total %u us",
+	LOG_INF("Inference accepted: class %u, confidence %u, streamed %u, reused %u, "
+		"prep %u us, invoke %u us, total %u us",
 		(unsigned int)result.classification,
 		(unsigned int)result.confidence,
+		(unsigned int)window->streamed,
+		(unsigned int)reused_samples,
 		(unsigned int)window->preparation_time_us,
 		(unsigned int)result.invoke_time_us,
 		(unsigned int)(window->preparation_time_us + model_time_us));
 }
 
-static void live_ecg_sample_handler(uint32_t raw_word, uint32_t timestamp_ms,
-				    void *user_data)
+#if defined(CONFIG_TINYCARDIA_MODEL_STREAMING)
+static void ecg_chunk_handler(const int8_t *quantized_samples, size_t offset, size_t count,
+			      void *user_data)
+{
+	int err;
+
+	ARG_UNUSED(user_data);
+	err = tinycardia_model_stream_append(quantized_samples, offset, count);
+	if (err < 0) {
+		/* The window's stream is then incomplete, so it is invoked whole. */
+		LOG_ERR("Streaming ECG chunk at %u failed: %d", (unsigned int)offset, err);
+	}
+}
+#endif
+
+static void live_ecg_block_handler(const uint32_t *words, size_t count,
+				   uint32_t first_timestamp_ms, void *user_data)
 {
-	bool processing_preserved;
+	size_t preserved_count;
 
 	ARG_UNUSED(user_data);
-	processing_preserved = ecg_processor_submit_sample(raw_word, timestamp_ms);
-	tinycardia_ble_ecg_sample(ecg_decode_raw_sample(raw_word), timestamp_ms,
-				    processing_preserved);
+	preserved_count = ecg_processor_submit_samples(words, count, first_timestamp_ms);
+	/* Only the number of analysis losses matters to samples_dropped accounting. */
+	for (size_t index = 0; index < count; ++index) {
+		tinycardia_ble_ecg_sample(ecg_decode_raw_sample(words[index]),
+					  max30003_block_timestamp_ms(first_timestamp_ms, index),
+					  index < preserved_count);
+	}
 }
 
+#if defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+static void rr_interval_handler(float interval_ms, uint32_t timestamp_ms, void *user_data)
+{
+	ARG_UNUSED(timestamp_ms);
+	ARG_UNUSED(user_data);
+	(void)ecg_processor_submit_rr_interval(interval_ms);
+}
+#endif
+
 static void lead_status_handler(enum max30003_lead_status status, void *user_data)
 {
 	enum tinycardia_lead_status protocol_status;
@@ -146,13 +222,18 @@ static void lead_status_handler(enum max30003_lead_status status, void *user_dat
 		break;
 	}
 
+	/* On the work-queue path this runs before the samples of the same FIFO service. */
+	ecg_processor_set_lead_off(protocol_status != TINYCARDIA_LEAD_STATUS_GOOD &&
+				   protocol_status != TINYCARDIA_LEAD_STATUS_UNKNOWN);
+
 	(void)tinycardia_ble_status_set_lead(protocol_status);
 }
 
-static void dropped_sample_handler(uint32_t minimum_dropped, void *user_data)
+static void dropped_sample_handler(uint32_t dropped_samples, void *user_data)
 {
 	ARG_UNUSED(user_data);
-	tinycardia_ble_record_dropped_samples(minimum_dropped);
+	tinycardia_ble_record_dropped_samples(dropped_samples);
+	(void)ecg_processor_submit_gap(dropped_samples);
 }
 
 static int set_monitoring(bool enabled, void *user_data)
@@ -197,6 +278,10 @@ static const struct tinycardia_ble_callbacks ble_callbacks = {
 
 int main(void)
 {
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+	void *scratch;
+	size_t scratch_size = 0U;
+#endif
 	int err;
 
 	err = power_control_wait_for_on();
@@ -220,6 +305,20 @@ int main(void)
 		printk("AFib model initialization failed (err %d)\n", err);
 		return 0;
 	}
+	ecg_processor_set_model_input(tinycardia_model_ecg_input());
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+	scratch = tinycardia_model_scratch(&scratch_size);
+	err = ecg_processor_set_workspace(scratch, scratch_size);
+	if (err < 0) {
+		printk("ECG workspace does not fit the %u-byte arena scratch (err %d)\n",
+		       (unsigned int)scratch_size, err);
+		return 0;
+	}
+#endif
+
+#if defined(CONFIG_TINYCARDIA_MODEL_STREAMING)
+	(void)ecg_processor_set_chunk_handler(ecg_chunk_handler, NULL);
+#endif
 
 	err = ecg_processor_init(prepared_window_handler, NULL);
 	if (err < 0) {
@@ -227,7 +326,11 @@ int main(void)
 		return 0;
 	}
 
-	err = max30003_init(live_ecg_sample_handler, NULL);
+	max30003_set_sample_block_handler(live_ecg_block_handler, NULL);
+#if defined(CONFIG_TINYCARDIA_ECG_RR_SOURCE_MAX30003)
+	max30003_set_rr_interval_handler(rr_interval_handler, NULL);
+#endif
+	err = max30003_init(NULL, NULL);
 	if (err < 0) {
 		printk("MAX30003 initialization failed (err %d)\n", err);
 		return 0;
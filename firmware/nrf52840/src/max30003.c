@@ -1,5 +1,7 @@
 #include "max30003.h"
 
+#include "max30003_dma.h"
+
 #include <errno.h>
 
 #include <zephyr/devicetree.h>
@@ -18,6 +20,7 @@ LOG_MODULE_REGISTER(max30003, CONFIG_LOG_DEFAULT_LEVEL);
 
 #define MAX30003_REG_STATUS     0x01
 #define MAX30003_REG_EN_INT     0x02
+#define MAX30003_REG_MNGR_INT   0x04
 #define MAX30003_REG_MNGR_DYN   0x05
 #define MAX30003_REG_SW_RST     0x08
 #define MAX30003_REG_SYNCH      0x09
@@ -28,9 +31,13 @@ LOG_MODULE_REGISTER(max30003, CONFIG_LOG_DEFAULT_LEVEL);
 #define MAX30003_REG_CNFG_ECG   0x15
 #define MAX30003_REG_CNFG_RTOR  0x1d
 #define MAX30003_REG_CNFG_RTOR2 0x1e
+#define MAX30003_REG_ECG_BURST  0x20
 #define MAX30003_REG_ECG_FIFO   0x21
+#define MAX30003_REG_RTOR       0x25
 
 #define MAX30003_STATUS_EINT   BIT(23)
+#define MAX30003_STATUS_EOVF   BIT(22)
+#define MAX30003_STATUS_RRINT  BIT(10)
 #define MAX30003_STATUS_PLLINT BIT(8)
 #define MAX30003_STATUS_LDOFF_N (BIT(0) | BIT(1))
 #define MAX30003_STATUS_LDOFF_P (BIT(2) | BIT(3))
@@ -44,17 +51,38 @@ LOG_MODULE_REGISTER(max30003, CONFIG_LOG_DEFAULT_LEVEL);
 #define MAX30003_FIFO_ETAG_FAST       1
 #define MAX30003_FIFO_ETAG_VALID_LAST 2
 #define MAX30003_FIFO_ETAG_FAST_LAST  3
+#define MAX30003_FIFO_ETAG_EMPTY      6
 #define MAX30003_FIFO_ETAG_OVF        7
 #define MAX30003_FIFO_MAX_READS       33
+#define MAX30003_FIFO_WORD_SIZE       3U
+#define MAX30003_FIFO_DEPTH           32U
 #define MAX30003_PLL_LOCK_TIMEOUT_MS  100
-#define MAX30003_SAMPLE_RATE_HZ        256U
+
+/* RTOR counts the latest R-to-R interval in 1/128 s ticks at FMSTR = 32768 Hz. */
+#define MAX30003_RTOR_INTERVAL_MASK GENMASK(23, 10)
+#define MAX30003_RTOR_TICK_HZ       128U
+
+/* EINT asserts once EFIT + 1 samples are unread; the other fields keep reset values. */
+#define MAX30003_MNGR_INT_EFIT_MASK   GENMASK(23, 19)
+#define MAX30003_MNGR_INT_RESET_VALUE 0x7f0004U
+#define MAX30003_MNGR_INT_VALUE(samples)                                                  \
+	((MAX30003_MNGR_INT_RESET_VALUE & ~MAX30003_MNGR_INT_EFIT_MASK) |                  \
+	 FIELD_PREP(MAX30003_MNGR_INT_EFIT_MASK, (samples) - 1U))
 
 /* Values retained from the validated STM32 configuration. */
 #define MAX30003_CNFG_GEN_VALUE  0x081213
 #define MAX30003_CNFG_GEN_EN_ECG BIT(19)
+#define MAX30003_CNFG_GEN_STOPPED_VALUE (MAX30003_CNFG_GEN_VALUE & ~MAX30003_CNFG_GEN_EN_ECG)
 #define MAX30003_CNFG_ECG_VALUE  0x425000
 #define MAX30003_CNFG_RTOR_VALUE 0x038100
 #define MAX30003_EN_INT_VALUE    0x800003
+#define MAX30003_EN_INT_EN_RRINT BIT(10)
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_RTOR)
+#define MAX30003_EN_INT_CONFIG (MAX30003_EN_INT_VALUE | MAX30003_EN_INT_EN_RRINT)
+#else
+#define MAX30003_EN_INT_CONFIG MAX30003_EN_INT_VALUE
+#endif
 
 struct max30003_register_info {
 	const char *name;
@@ -67,10 +95,16 @@ struct max30003_register_config {
 	uint32_t value;
 };
 
+struct max30003_register_write {
+	uint8_t address;
+	uint32_t value;
+};
+
 static const struct max30003_register_info register_table[] = {
 	{ "INFO", MAX30003_REG_INFO },
 	{ "STATUS", MAX30003_REG_STATUS },
 	{ "EN_INT", MAX30003_REG_EN_INT },
+	{ "MNGR_INT", MAX30003_REG_MNGR_INT },
 	{ "MNGR_DYN", MAX30003_REG_MNGR_DYN },
 	{ "SW_RST", MAX30003_REG_SW_RST },
 	{ "SYNCH", MAX30003_REG_SYNCH },
@@ -80,41 +114,98 @@ static const struct max30003_register_info register_table[] = {
 	{ "CNFG_ECG", MAX30003_REG_CNFG_ECG },
 	{ "CNFG_RTOR", MAX30003_REG_CNFG_RTOR },
 	{ "CNFG_RTOR2", MAX30003_REG_CNFG_RTOR2 },
+	{ "RTOR", MAX30003_REG_RTOR },
 };
 
 static const struct max30003_register_config register_config[] = {
 	{ "CNFG_GEN", MAX30003_REG_CNFG_GEN, MAX30003_CNFG_GEN_VALUE },
 	{ "CNFG_ECG", MAX30003_REG_CNFG_ECG, MAX30003_CNFG_ECG_VALUE },
 	{ "CNFG_RTOR", MAX30003_REG_CNFG_RTOR, MAX30003_CNFG_RTOR_VALUE },
-	{ "EN_INT", MAX30003_REG_EN_INT, MAX30003_EN_INT_VALUE },
+	{ "EN_INT", MAX30003_REG_EN_INT, MAX30003_EN_INT_CONFIG },
+	{ "MNGR_INT", MAX30003_REG_MNGR_INT,
+	  MAX30003_MNGR_INT_VALUE(CONFIG_TINYCARDIA_MAX30003_FIFO_INTERRUPT_SAMPLES) },
 	{ "MNGR_DYN", MAX30003_REG_MNGR_DYN, 0 },
 	{ "CNFG_EMUX", MAX30003_REG_CNFG_EMUX, 0 },
 };
 
+/* Monitoring transitions, each applied as one batch by write_registers(). */
+static const struct max30003_register_write monitoring_start_writes[] = {
+	{ MAX30003_REG_CNFG_GEN, MAX30003_CNFG_GEN_VALUE },
+	/* SYNCH restarts recording and also empties the FIFO. */
+	{ MAX30003_REG_SYNCH, 0 },
+};
+
+static const struct max30003_register_write monitoring_stop_writes[] = {
+	{ MAX30003_REG_CNFG_GEN, MAX30003_CNFG_GEN_STOPPED_VALUE },
+	{ MAX30003_REG_FIFO_RST, 0 },
+};
+
 static const struct spi_dt_spec max30003_spi = SPI_DT_SPEC_INST_GET(
 	0, SPI_OP_MODE_MASTER | SPI_TRANSFER_MSB | SPI_WORD_SET(8));
 static const struct gpio_dt_spec max30003_int1 =
 	GPIO_DT_SPEC_INST_GET(0, int_gpios);
 
-static struct gpio_callback int1_callback;
+#if defined(CONFIG_TINYCARDIA_MAX30003_DEDICATED_WORK_QUEUE)
+/* FIFO service must never wait behind unrelated system work-queue items. */
+static struct k_work_q acquisition_work_queue;
+K_THREAD_STACK_DEFINE(acquisition_work_queue_stack,
+		      CONFIG_TINYCARDIA_MAX30003_THREAD_STACK_SIZE);
+#define MAX30003_WORK_QUEUE (&acquisition_work_queue)
+#else
+#define MAX30003_WORK_QUEUE (&k_sys_work_q)
+#endif
 static struct k_work fifo_work;
 static struct k_work_delayable sample_watchdog_work;
+/* Cycle count of the interrupt behind the queued FIFO service; zero when none. */
+static atomic_t fifo_service_request_cycles;
+static struct max30003_fifo_service_stats fifo_service_stats;
 static max30003_sample_handler_t sample_callback;
 static void *sample_callback_data;
+static max30003_sample_block_handler_t sample_block_callback;
+static void *sample_block_callback_data;
+/* Samples of the FIFO service in progress, delivered together by flush_sample_block(). */
+static uint32_t sample_block[MAX30003_FIFO_MAX_READS];
+static size_t sample_block_count;
+static uint32_t sample_block_first_index;
+static atomic_t fifo_interrupt_samples =
+	ATOMIC_INIT(CONFIG_TINYCARDIA_MAX30003_FIFO_INTERRUPT_SAMPLES);
 static uint32_t delivered_sample_count;
 static uint32_t timestamp_sample_index;
 static uint64_t acquisition_epoch_ms;
+/*
+ * The sample clock predicts which FIFO index the MAX30003 acquires next from
+ * the free-running system tick counter (the RTC on the nRF52). Sample
+ * sample_clock_next_index - 1 was acquired at sample_clock_anchor_ticks.
+ */
+static uint32_t sample_clock_next_index;
+static int64_t sample_clock_anchor_ticks;
 static atomic_t monitoring_enabled;
 static max30003_lead_status_handler_t lead_status_callback;
 static void *lead_status_callback_data;
 static max30003_drop_handler_t drop_callback;
 static void *drop_callback_data;
+static max30003_rr_interval_handler_t rr_interval_callback;
+static void *rr_interval_callback_data;
+/* The first RTOR value after SYNCH measures from the restart, not from a beat. */
+static bool rr_interval_primed;
 static uint32_t pending_dropped_samples;
 static enum max30003_lead_status current_lead_status =
 	MAX30003_LEAD_STATUS_UNKNOWN;
+/*
+ * Last value written to each register_config entry, valid per bit of
+ * register_shadow_valid. Command strobes (SW_RST, SYNCH, FIFO_RST) are never
+ * cached; SW_RST returns every register to an unknown state.
+ */
+static uint32_t register_shadow[ARRAY_SIZE(register_config)];
+static uint32_t register_shadow_valid;
 
 K_MUTEX_DEFINE(max30003_lock);
 
+BUILD_ASSERT(ARRAY_SIZE(register_config) <= 32U, "register_shadow_valid is a 32-bit mask");
+
+BUILD_ASSERT(CONFIG_TINYCARDIA_MAX30003_FIFO_INTERRUPT_SAMPLES <= MAX30003_FIFO_DEPTH,
+	     "The FIFO interrupt threshold cannot exceed the FIFO depth");
+
 static enum max30003_lead_status lead_status_from_register(uint32_t status)
 {
 	bool negative_off = (status & MAX30003_STATUS_LDOFF_N) != 0U;
@@ -150,7 +241,7 @@ static void update_lead_status(enum max30003_lead_status status)
 	}
 }
 
-static void report_dropped_samples(uint32_t minimum_dropped)
+static void report_dropped_samples(uint32_t dropped_samples)
 {
 	max30003_drop_handler_t callback;
 	void *callback_data;
@@ -159,16 +250,52 @@ static void report_dropped_samples(uint32_t minimum_dropped)
 	callback = drop_callback;
 	callback_data = drop_callback_data;
 	if (callback == NULL) {
-		pending_dropped_samples += minimum_dropped;
+		pending_dropped_samples += dropped_samples;
 	}
 	k_mutex_unlock(&max30003_lock);
 
 	if (callback != NULL) {
-		callback(minimum_dropped, callback_data);
+		callback(dropped_samples, callback_data);
 	}
 }
 
-int max30003_write_register(uint8_t reg, uint32_t value)
+static void suspend_capture(void)
+{
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+	/* Register traffic borrows SPIM and chip select from armed DMA capture. */
+	max30003_dma_pause();
+#endif
+}
+
+static void resume_capture(void)
+{
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+	max30003_dma_resume();
+#endif
+}
+
+static int shadow_index(uint8_t reg)
+{
+	for (size_t index = 0; index < ARRAY_SIZE(register_config); ++index) {
+		if (register_config[index].address == reg) {
+			return (int)index;
+		}
+	}
+
+	return -1;
+}
+
+/* Whether the device is known to hold value; the caller holds max30003_lock. */
+static bool shadow_matches(uint8_t reg, uint32_t value)
+{
+	int shadow = shadow_index(reg);
+
+	return shadow >= 0 && (register_shadow_valid & BIT(shadow)) != 0U &&
+	       register_shadow[shadow] == value;
+}
+
+/* One CSB-framed register write; the caller holds max30003_lock with capture suspended. */
+static int transfer_register_write(uint8_t reg, uint32_t value)
 {
 	uint8_t tx_data[4] = {
 		(uint8_t)(reg << 1),
@@ -184,16 +311,73 @@ int max30003_write_register(uint8_t reg, uint32_t value)
 		.buffers = &tx_buf,
 		.count = 1,
 	};
-	int err;
+
+	return spi_write_dt(&max30003_spi, &tx);
+}
+
+/*
+ * Apply writes in order under one lock and one capture pause, skipping
+ * configuration registers whose shadow already holds the value. The MAX30003
+ * needs CSB to frame each 32-bit access, so every write remains its own SPI
+ * transaction. Stops at the first failure, leaving that register unknown.
+ */
+static int write_registers(const struct max30003_register_write *writes, size_t count)
+{
+	int err = 0;
 
 	k_mutex_lock(&max30003_lock, K_FOREVER);
-	err = spi_write_dt(&max30003_spi, &tx);
+	suspend_capture();
+	for (size_t index = 0; index < count; ++index) {
+		int shadow = shadow_index(writes[index].address);
+
+		if (shadow_matches(writes[index].address, writes[index].value)) {
+			continue;
+		}
+		err = transfer_register_write(writes[index].address, writes[index].value);
+		if (shadow >= 0) {
+			WRITE_BIT(register_shadow_valid, shadow, err == 0);
+			register_shadow[shadow] = writes[index].value;
+		} else if (writes[index].address == MAX30003_REG_SW_RST) {
+			register_shadow_valid = 0U;
+		}
+		if (err < 0) {
+			break;
+		}
+	}
+	resume_capture();
 	k_mutex_unlock(&max30003_lock);
 
 	return err;
 }
 
-int max30003_read_register(uint8_t reg, uint32_t *value)
+static int write_register_cached(uint8_t reg, uint32_t value)
+{
+	const struct max30003_register_write write = { reg, value };
+
+	return write_registers(&write, 1U);
+}
+
+/* Forget what the device holds in reg, so the next write reaches it. */
+static void invalidate_shadow(uint8_t reg)
+{
+	int shadow = shadow_index(reg);
+
+	if (shadow >= 0) {
+		k_mutex_lock(&max30003_lock, K_FOREVER);
+		WRITE_BIT(register_shadow_valid, shadow, 0);
+		k_mutex_unlock(&max30003_lock);
+	}
+}
+
+int max30003_write_register(uint8_t reg, uint32_t value)
+{
+	/* Explicit writes always reach the device, then refresh the shadow. */
+	invalidate_shadow(reg);
+	return write_register_cached(reg, value);
+}
+
+/* One CSB-framed register read; the caller holds max30003_lock with capture suspended. */
+static int transfer_register_read(uint8_t reg, uint32_t *value)
 {
 	uint8_t tx_data[4] = { (uint8_t)((reg << 1) | 1U), 0xff, 0xff, 0xff };
 	uint8_t rx_data[4] = { 0 };
@@ -215,13 +399,7 @@ int max30003_read_register(uint8_t reg, uint32_t *value)
 	};
 	int err;
 
-	if (value == NULL) {
-		return -EINVAL;
-	}
-
-	k_mutex_lock(&max30003_lock, K_FOREVER);
 	err = spi_transceive_dt(&max30003_spi, &tx, &rx);
-	k_mutex_unlock(&max30003_lock);
 	if (err < 0) {
 		return err;
 	}
@@ -233,6 +411,23 @@ int max30003_read_register(uint8_t reg, uint32_t *value)
 	return 0;
 }
 
+int max30003_read_register(uint8_t reg, uint32_t *value)
+{
+	int err;
+
+	if (value == NULL) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	suspend_capture();
+	err = transfer_register_read(reg, value);
+	resume_capture();
+	k_mutex_unlock(&max30003_lock);
+
+	return err;
+}
+
 int max30003_sanity_check(uint32_t *info)
 {
 	uint32_t value;
@@ -277,16 +472,18 @@ static int reset_and_check_identity(uint32_t *info)
 
 static int write_and_verify_registers(void)
 {
+	struct max30003_register_write writes[ARRAY_SIZE(register_config)];
 	uint32_t actual;
 	int err;
 
 	for (size_t index = 0; index < ARRAY_SIZE(register_config); ++index) {
-		err = max30003_write_register(register_config[index].address,
-					       register_config[index].value);
-		if (err < 0) {
-			LOG_ERR("%s write failed: %d", register_config[index].name, err);
-			return err;
-		}
+		writes[index].address = register_config[index].address;
+		writes[index].value = register_config[index].value;
+	}
+	err = write_registers(writes, ARRAY_SIZE(writes));
+	if (err < 0) {
+		LOG_ERR("Configuration write failed: %d", err);
+		return err;
 	}
 
 	for (size_t index = 0; index < ARRAY_SIZE(register_config); ++index) {
@@ -296,6 +493,7 @@ static int write_and_verify_registers(void)
 			return err;
 		}
 		if (actual != register_config[index].value) {
+			invalidate_shadow(register_config[index].address);
 			LOG_ERR("%s readback mismatch: wrote 0x%06x, read 0x%06x",
 				register_config[index].name, register_config[index].value,
 				actual);
@@ -344,67 +542,532 @@ static int configure_registers(void)
 	return max30003_write_register(MAX30003_REG_SYNCH, 0);
 }
 
+static uint32_t sample_timestamp_ms(uint32_t sample_index)
+{
+	return (uint32_t)(acquisition_epoch_ms +
+		((uint64_t)sample_index * MSEC_PER_SEC) / MAX30003_SAMPLE_RATE_HZ);
+}
+
+static void anchor_sample_clock(uint32_t next_index, int64_t ticks)
+{
+	sample_clock_next_index = next_index;
+	sample_clock_anchor_ticks = ticks;
+}
+
+/* Index of the first sample the MAX30003 will acquire after now_ticks. */
+static uint32_t predicted_sample_index(int64_t now_ticks)
+{
+	uint64_t elapsed_ticks = now_ticks > sample_clock_anchor_ticks ?
+		(uint64_t)(now_ticks - sample_clock_anchor_ticks) : 0U;
+
+	return sample_clock_next_index +
+	       (uint32_t)((elapsed_ticks * MAX30003_SAMPLE_RATE_HZ) /
+			  CONFIG_SYS_CLOCK_TICKS_PER_SEC);
+}
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_RTOR)
+
+/* Forward the interval behind a STATUS RRINT; reading STATUS already cleared it. */
+static void report_rr_interval(uint32_t status)
+{
+	max30003_rr_interval_handler_t callback;
+	void *callback_data;
+	uint32_t rtor;
+	int err;
+
+	if ((status & MAX30003_STATUS_RRINT) == 0U) {
+		return;
+	}
+	err = max30003_read_register(MAX30003_REG_RTOR, &rtor);
+	if (err < 0) {
+		LOG_ERR("RTOR read failed: %d", err);
+		return;
+	}
+	if (!rr_interval_primed) {
+		rr_interval_primed = true;
+		return;
+	}
+
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	callback = rr_interval_callback;
+	callback_data = rr_interval_callback_data;
+	k_mutex_unlock(&max30003_lock);
+
+	if (callback != NULL) {
+		callback((float)FIELD_GET(MAX30003_RTOR_INTERVAL_MASK, rtor) * 1000.0f /
+				 (float)MAX30003_RTOR_TICK_HZ,
+			 sample_timestamp_ms(timestamp_sample_index), callback_data);
+	}
+}
+
+#else
+
+static void report_rr_interval(uint32_t status)
+{
+	ARG_UNUSED(status);
+}
+
+#endif /* CONFIG_TINYCARDIA_MAX30003_RTOR */
+
+/* Hand the samples collected since the last flush to the application. */
+static void flush_sample_block(void)
+{
+	max30003_sample_block_handler_t block_callback;
+	void *block_callback_data;
+	size_t count = sample_block_count;
+
+	if (count == 0U) {
+		return;
+	}
+	sample_block_count = 0U;
+
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	block_callback = sample_block_callback;
+	block_callback_data = sample_block_callback_data;
+	k_mutex_unlock(&max30003_lock);
+
+	if (block_callback != NULL) {
+		block_callback(sample_block, count, sample_timestamp_ms(sample_block_first_index),
+			       block_callback_data);
+		return;
+	}
+	if (sample_callback == NULL) {
+		return;
+	}
+	for (size_t index = 0; index < count; ++index) {
+		sample_callback(sample_block[index],
+				sample_timestamp_ms(sample_block_first_index + (uint32_t)index),
+				sample_callback_data);
+	}
+}
+
+/*
+ * Everything acquired before a FIFO reset at reset_ticks that followed an
+ * overflow is gone, including the full FIFO that overflowed. The next sample
+ * keeps its place on the timeline, so timestamps stay continuous across the gap.
+ */
+static void account_fifo_overflow(int64_t reset_ticks)
+{
+	uint32_t dropped = predicted_sample_index(reset_ticks) - timestamp_sample_index;
+
+	if ((int32_t)dropped < (int32_t)(MAX30003_FIFO_DEPTH + 1U)) {
+		/* Only a clock anchored late by interrupt latency can predict less. */
+		dropped = MAX30003_FIFO_DEPTH + 1U;
+	}
+	LOG_WRN("ECG FIFO overflow; reset after losing %u samples", (unsigned int)dropped);
+	timestamp_sample_index += dropped;
+	report_dropped_samples(dropped);
+}
+
+/*
+ * Collect one FIFO word; returns true while more samples may follow it. An
+ * overflow tag ends the batch like any other non-sample tag; the caller
+ * recovers from it.
+ */
+static bool process_fifo_word(uint32_t fifo_word)
+{
+	uint32_t etag = FIELD_GET(MAX30003_FIFO_ETAG_MASK, fifo_word);
+
+	if (etag > MAX30003_FIFO_ETAG_FAST_LAST) {
+		return false;
+	}
+
+	if (sample_block_count == ARRAY_SIZE(sample_block)) {
+		flush_sample_block();
+	}
+	if (sample_block_count == 0U) {
+		sample_block_first_index = timestamp_sample_index;
+	}
+	sample_block[sample_block_count++] = fifo_word;
+	++timestamp_sample_index;
+	++delivered_sample_count;
+
+	return etag != MAX30003_FIFO_ETAG_VALID_LAST && etag != MAX30003_FIFO_ETAG_FAST_LAST;
+}
+
+/* Queue FIFO service from an interrupt, remembering when service was requested. */
+static void request_fifo_service(void)
+{
+	uint32_t now_cycles = k_cycle_get_32();
+
+	(void)atomic_cas(&fifo_service_request_cycles, 0, (atomic_val_t)MAX(now_cycles, 1U));
+	(void)k_work_submit_to_queue(MAX30003_WORK_QUEUE, &fifo_work);
+}
+
+/* Measure how long the request waited for the acquisition work queue. */
+static void record_fifo_service_latency(void)
+{
+	uint32_t request_cycles = (uint32_t)atomic_set(&fifo_service_request_cycles, 0);
+	uint32_t latency_us;
+
+	if (request_cycles == 0U) {
+		return;
+	}
+	latency_us = k_cyc_to_us_ceil32(k_cycle_get_32() - request_cycles);
+
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	fifo_service_stats.last_latency_us = latency_us;
+	fifo_service_stats.max_latency_us = MAX(fifo_service_stats.max_latency_us, latency_us);
+	++fifo_service_stats.services;
+	k_mutex_unlock(&max30003_lock);
+}
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+
+/* The last burst delivered left the FIFO empty, so the next edge is a full batch. */
+static bool burst_fifo_emptied;
+
+static void dma_burst_handler(const uint32_t *words, size_t word_count, int64_t edge_ticks)
+{
+	uint32_t etag = MAX30003_FIFO_ETAG_VALID;
+
+	/*
+	 * INT1 asserts the moment the threshold sample after an empty FIFO is
+	 * acquired, so a timed edge pins the last sample of this burst.
+	 */
+	if (burst_fifo_emptied && edge_ticks >= 0) {
+		anchor_sample_clock(timestamp_sample_index + (uint32_t)word_count, edge_ticks);
+	}
+	for (size_t index = 0; index < word_count; ++index) {
+		etag = FIELD_GET(MAX30003_FIFO_ETAG_MASK, words[index]);
+		/*
+		 * Each burst is independent; a tag only ends the rest of its own burst.
+		 * Overflow tags are left to the STATUS read of the FIFO service.
+		 */
+		if (!process_fifo_word(words[index])) {
+			break;
+		}
+	}
+	flush_sample_block();
+	burst_fifo_emptied = etag == MAX30003_FIFO_ETAG_VALID_LAST ||
+			     etag == MAX30003_FIFO_ETAG_FAST_LAST ||
+			     etag == MAX30003_FIFO_ETAG_EMPTY;
+}
+
+static void dma_ready_handler(void)
+{
+	request_fifo_service();
+}
+
+/*
+ * Read STATUS in one capture pause and note the ring position it was read at.
+ * An overflow holds INT1 active, so the FIFO is reset before capture resumes;
+ * resuming first would start a burst of overflow tags.
+ */
+static int read_status_at_ring_position(uint32_t *status, uint32_t *position,
+					int64_t *reset_ticks)
+{
+	int err;
+
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	suspend_capture();
+	*position = max30003_dma_position();
+	err = transfer_register_read(MAX30003_REG_STATUS, status);
+	if (err == 0 && (*status & MAX30003_STATUS_EOVF) != 0U) {
+		err = transfer_register_write(MAX30003_REG_FIFO_RST, 0);
+		*reset_ticks = k_uptime_ticks();
+	}
+	resume_capture();
+	k_mutex_unlock(&max30003_lock);
+
+	return err;
+}
+
 static void fifo_work_handler(struct k_work *work)
 {
-	uint32_t status;
-	uint32_t fifo_word;
-	uint32_t etag;
+	uint32_t overrun_words;
+	uint32_t position;
+	uint32_t status = 0U;
+	int64_t reset_ticks = 0;
 	int err;
 
 	ARG_UNUSED(work);
+	record_fifo_service_latency();
 	if (!atomic_get(&monitoring_enabled)) {
 		return;
 	}
 
+	err = read_status_at_ring_position(&status, &position, &reset_ticks);
+
+	/* Overwritten bursts are older than every burst still in the ring. */
+	overrun_words = max30003_dma_take_overrun_words();
+	if (overrun_words > 0U) {
+		LOG_WRN("DMA capture ring overrun; %u FIFO words lost",
+			(unsigned int)overrun_words);
+		timestamp_sample_index += overrun_words;
+		report_dropped_samples(overrun_words);
+		burst_fifo_emptied = false;
+	}
+	max30003_dma_drain(dma_burst_handler, position);
+	if (err < 0) {
+		LOG_ERR("STATUS read or FIFO reset failed: %d", err);
+		return;
+	}
+
+	/* Every wake reads STATUS, so lead-off and overflow need no polling. */
+	update_lead_status(lead_status_from_register(status));
+	report_rr_interval(status);
+	if ((status & MAX30003_STATUS_EOVF) != 0U) {
+		/* Every burst captured before the reset was delivered above. */
+		account_fifo_overflow(reset_ticks);
+		burst_fifo_emptied = true;
+	}
+}
+
+static int fifo_service_init(void)
+{
+	return max30003_dma_init(dma_ready_handler,
+				 (uint8_t)((MAX30003_REG_ECG_BURST << 1) | 1U),
+				 CONFIG_TINYCARDIA_MAX30003_FIFO_INTERRUPT_SAMPLES);
+}
+
+static int fifo_service_start(void)
+{
+	int err;
+
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	err = max30003_dma_start();
+	k_mutex_unlock(&max30003_lock);
+
+	return err;
+}
+
+static int fifo_service_stop(void)
+{
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	max30003_dma_stop();
+	k_mutex_unlock(&max30003_lock);
+
+	return 0;
+}
+
+#else
+
+/* Burst buffers are used only by the serialized FIFO work item. */
+static uint8_t fifo_burst_data[MAX30003_FIFO_MAX_READS * MAX30003_FIFO_WORD_SIZE];
+static uint32_t fifo_burst_words[MAX30003_FIFO_MAX_READS];
+static struct gpio_callback int1_callback;
+/* Low 32 bits of the tick count at the latest INT1 edge, written by the ISR. */
+static atomic_t int1_edge_ticks;
+/* The FIFO was left empty at fifo_emptied_ticks, with no INT1 edge serviced since. */
+static bool fifo_emptied;
+static int64_t fifo_emptied_ticks;
+
+/*
+ * Read word_count FIFO words in one chip-select cycle. The command byte is sent
+ * once; every following 24-bit word is clocked out of the ECG FIFO.
+ */
+static int read_fifo_burst(uint32_t *words, size_t word_count)
+{
+	uint8_t command = (uint8_t)((MAX30003_REG_ECG_BURST << 1) | 1U);
+	const struct spi_buf tx_buf = {
+		.buf = &command,
+		.len = sizeof(command),
+	};
+	const struct spi_buf rx_bufs[] = {
+		{
+			.buf = NULL,
+			.len = sizeof(command),
+		},
+		{
+			.buf = fifo_burst_data,
+			.len = word_count * MAX30003_FIFO_WORD_SIZE,
+		},
+	};
+	const struct spi_buf_set tx = {
+		.buffers = &tx_buf,
+		.count = 1,
+	};
+	const struct spi_buf_set rx = {
+		.buffers = rx_bufs,
+		.count = ARRAY_SIZE(rx_bufs),
+	};
+	int err;
+
+	if (words == NULL || word_count == 0U || word_count > ARRAY_SIZE(fifo_burst_words)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	err = spi_transceive_dt(&max30003_spi, &tx, &rx);
+	k_mutex_unlock(&max30003_lock);
+	if (err < 0) {
+		return err;
+	}
+
+	for (size_t index = 0; index < word_count; ++index) {
+		const uint8_t *word = &fifo_burst_data[index * MAX30003_FIFO_WORD_SIZE];
+
+		words[index] = ((uint32_t)word[0] << 16) | ((uint32_t)word[1] << 8) |
+			       (uint32_t)word[2];
+	}
+
+	return 0;
+}
+
+/* Reset the FIFO after an overflow tag and account for what was lost. */
+static void recover_fifo_overflow(void)
+{
+	int err;
+
+	flush_sample_block();
+	err = max30003_write_register(MAX30003_REG_FIFO_RST, 0);
+	if (err < 0) {
+		LOG_ERR("ECG FIFO reset failed: %d", err);
+	}
+	account_fifo_overflow(k_uptime_ticks());
+}
+
+/* Process one serviced word, noting when the service leaves the FIFO empty. */
+static bool service_fifo_word(uint32_t fifo_word)
+{
+	if (FIELD_GET(MAX30003_FIFO_ETAG_MASK, fifo_word) == MAX30003_FIFO_ETAG_OVF) {
+		recover_fifo_overflow();
+	} else if (process_fifo_word(fifo_word)) {
+		return true;
+	}
+
+	/* An end tag, an empty read, or the reset after an overflow all end here. */
+	fifo_emptied = true;
+	fifo_emptied_ticks = k_uptime_ticks();
+	return false;
+}
+
+/*
+ * INT1 asserts the moment the threshold sample after an empty FIFO is acquired,
+ * so the edge time pins that sample on the tick timeline to within ISR latency.
+ * A pending RRINT shares INT1 and may have produced the edge instead.
+ */
+static void anchor_sample_clock_to_edge(size_t threshold, uint32_t status)
+{
+	int64_t now_ticks = k_uptime_ticks();
+	int64_t edge_ticks = now_ticks -
+		(int64_t)(uint32_t)((uint32_t)now_ticks - (uint32_t)atomic_get(&int1_edge_ticks));
+
+	if (fifo_emptied && edge_ticks > fifo_emptied_ticks &&
+	    (status & MAX30003_STATUS_RRINT) == 0U) {
+		anchor_sample_clock(timestamp_sample_index + (uint32_t)threshold, edge_ticks);
+	}
+	fifo_emptied = false;
+}
+
+static void drain_fifo(void)
+{
+	uint32_t status;
+	uint32_t fifo_word;
+	size_t read_count = (size_t)atomic_get(&fifo_interrupt_samples);
+	int err;
+
 	err = max30003_read_register(MAX30003_REG_STATUS, &status);
 	if (err < 0) {
 		LOG_ERR("STATUS read failed: %d", err);
 		return;
 	}
+	/* The DC lead-off bits ride on every FIFO service, so transitions need no polling. */
+	update_lead_status(lead_status_from_register(status));
+	report_rr_interval(status);
 	if ((status & MAX30003_STATUS_EINT) == 0U) {
 		return;
 	}
+	anchor_sample_clock_to_edge(read_count, status);
 
-	for (size_t index = 0; index < MAX30003_FIFO_MAX_READS; ++index) {
-		err = max30003_read_register(MAX30003_REG_ECG_FIFO, &fifo_word);
-		if (err < 0) {
-			LOG_ERR("ECG FIFO read failed: %d", err);
+	/* EINT guarantees at least the threshold count, so one burst drains the batch. */
+	err = read_fifo_burst(fifo_burst_words, read_count);
+	if (err < 0) {
+		LOG_ERR("ECG FIFO burst read failed: %d", err);
+		return;
+	}
+	for (size_t index = 0; index < read_count; ++index) {
+		if (!service_fifo_word(fifo_burst_words[index])) {
 			return;
 		}
+	}
 
-		etag = FIELD_GET(MAX30003_FIFO_ETAG_MASK, fifo_word);
-		if (etag == MAX30003_FIFO_ETAG_OVF) {
-			LOG_WRN("ECG FIFO overflow; resetting FIFO");
-			err = max30003_write_register(MAX30003_REG_FIFO_RST, 0);
-			if (err < 0) {
-				LOG_ERR("ECG FIFO reset failed: %d", err);
-			}
-			/* The exact loss is unavailable; preserve honest future timestamps. */
-			timestamp_sample_index = 0U;
-			acquisition_epoch_ms = (uint64_t)k_uptime_get();
-			report_dropped_samples(1U);
+	/* Samples that arrived while the work item was delayed follow individually. */
+	for (; read_count < MAX30003_FIFO_MAX_READS; ++read_count) {
+		err = max30003_read_register(MAX30003_REG_ECG_FIFO, &fifo_word);
+		if (err < 0) {
+			LOG_ERR("ECG FIFO read failed: %d", err);
 			return;
 		}
-		if (etag > MAX30003_FIFO_ETAG_FAST_LAST) {
+		if (!service_fifo_word(fifo_word)) {
 			return;
 		}
+	}
 
-		if (sample_callback != NULL) {
-			uint32_t timestamp_ms = (uint32_t)(acquisition_epoch_ms +
-				((uint64_t)timestamp_sample_index * MSEC_PER_SEC) /
-				MAX30003_SAMPLE_RATE_HZ);
+	LOG_WRN("ECG FIFO did not produce an end tag");
+}
 
-			sample_callback(fifo_word, timestamp_ms, sample_callback_data);
-		}
-		++timestamp_sample_index;
-		++delivered_sample_count;
-		if (etag == MAX30003_FIFO_ETAG_VALID_LAST ||
-		    etag == MAX30003_FIFO_ETAG_FAST_LAST) {
-			return;
-		}
+static void fifo_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+	record_fifo_service_latency();
+	if (!atomic_get(&monitoring_enabled)) {
+		return;
 	}
 
-	LOG_WRN("ECG FIFO did not produce an end tag");
+	drain_fifo();
+	flush_sample_block();
+}
+
+static void int1_handler(const struct device *port, struct gpio_callback *callback,
+			 gpio_port_pins_t pins)
+{
+	ARG_UNUSED(port);
+	ARG_UNUSED(callback);
+	ARG_UNUSED(pins);
+
+	(void)atomic_set(&int1_edge_ticks, (atomic_val_t)(uint32_t)k_uptime_ticks());
+	request_fifo_service();
+}
+
+static int fifo_service_init(void)
+{
+	gpio_init_callback(&int1_callback, int1_handler, BIT(max30003_int1.pin));
+	return gpio_add_callback(max30003_int1.port, &int1_callback);
+}
+
+static int fifo_service_start(void)
+{
+	int err;
+
+	err = gpio_pin_interrupt_configure_dt(&max30003_int1, GPIO_INT_EDGE_TO_ACTIVE);
+	if (err < 0) {
+		return err;
+	}
+
+	/* Service an interrupt that was already asserted before the edge was enabled. */
+	err = gpio_pin_get_dt(&max30003_int1);
+	if (err > 0) {
+		(void)k_work_submit_to_queue(MAX30003_WORK_QUEUE, &fifo_work);
+	} else if (err < 0) {
+		return err;
+	}
+
+	return 0;
+}
+
+static int fifo_service_stop(void)
+{
+	return gpio_pin_interrupt_configure_dt(&max30003_int1, GPIO_INT_DISABLE);
+}
+
+#endif /* CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA */
+
+/* Restart sample indices and the sample clock at a SYNCH, which also empties the FIFO. */
+static void restart_sample_timeline(void)
+{
+	int64_t now_ticks = k_uptime_ticks();
+
+	timestamp_sample_index = 0U;
+	acquisition_epoch_ms = (uint64_t)k_ticks_to_ms_floor64(now_ticks);
+	anchor_sample_clock(0U, now_ticks);
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+	burst_fifo_emptied = true;
+#else
+	fifo_emptied = true;
+	fifo_emptied_ticks = now_ticks;
+#endif
 }
 
 static void sample_watchdog_handler(struct k_work *work)
@@ -424,6 +1087,11 @@ static void sample_watchdog_handler(struct k_work *work)
 		LOG_ERR("MAX30003 health-check STATUS read failed: %d", err);
 	} else {
 		update_lead_status(lead_status_from_register(status));
+		report_rr_interval(status);
+		if ((status & MAX30003_STATUS_EOVF) != 0U) {
+			/* An overflow holds INT1 active, so no further edge requests service. */
+			(void)k_work_submit_to_queue(MAX30003_WORK_QUEUE, &fifo_work);
+		}
 	}
 
 	if (delivered_sample_count == previous_sample_count) {
@@ -435,7 +1103,7 @@ static void sample_watchdog_handler(struct k_work *work)
 		} else if ((status & MAX30003_STATUS_EINT) != 0U) {
 			LOG_WRN("ECG FIFO is ready but no samples arrived; STATUS=0x%06x, INT1 active=%d; polling once",
 				status, int1_active);
-			(void)k_work_submit(&fifo_work);
+			(void)k_work_submit_to_queue(MAX30003_WORK_QUEUE, &fifo_work);
 		} else {
 			LOG_WRN("No ECG samples in %u ms; STATUS=0x%06x, INT1 active=%d",
 				CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS, status,
@@ -444,18 +1112,8 @@ static void sample_watchdog_handler(struct k_work *work)
 	}
 
 	previous_sample_count = delivered_sample_count;
-	(void)k_work_reschedule(&sample_watchdog_work,
-				K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS));
-}
-
-static void int1_handler(const struct device *port, struct gpio_callback *callback,
-			 gpio_port_pins_t pins)
-{
-	ARG_UNUSED(port);
-	ARG_UNUSED(callback);
-	ARG_UNUSED(pins);
-
-	(void)k_work_submit(&fifo_work);
+	(void)k_work_reschedule_for_queue(MAX30003_WORK_QUEUE, &sample_watchdog_work,
+					  K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS));
 }
 
 int max30003_init(max30003_sample_handler_t handler, void *user_data)
@@ -472,10 +1130,17 @@ int max30003_init(max30003_sample_handler_t handler, void *user_data)
 
 	sample_callback = handler;
 	sample_callback_data = user_data;
+	sample_block_count = 0U;
 	delivered_sample_count = 0;
-	timestamp_sample_index = 0U;
-	acquisition_epoch_ms = (uint64_t)k_uptime_get();
+	restart_sample_timeline();
 	atomic_set(&monitoring_enabled, 1);
+#if defined(CONFIG_TINYCARDIA_MAX30003_DEDICATED_WORK_QUEUE)
+	k_work_queue_init(&acquisition_work_queue);
+	k_work_queue_start(&acquisition_work_queue, acquisition_work_queue_stack,
+			   K_THREAD_STACK_SIZEOF(acquisition_work_queue_stack),
+			   CONFIG_TINYCARDIA_MAX30003_THREAD_PRIORITY, NULL);
+	(void)k_thread_name_set(k_work_queue_thread_get(&acquisition_work_queue), "max30003");
+#endif
 	k_work_init(&fifo_work, fifo_work_handler);
 	k_work_init_delayable(&sample_watchdog_work, sample_watchdog_handler);
 
@@ -500,29 +1165,18 @@ int max30003_init(max30003_sample_handler_t handler, void *user_data)
 		return err;
 	}
 	LOG_INF("MAX30003 register readback passed; ECG configured for 256 sps");
-	timestamp_sample_index = 0U;
-	acquisition_epoch_ms = (uint64_t)k_uptime_get();
+	restart_sample_timeline();
 
-	gpio_init_callback(&int1_callback, int1_handler, BIT(max30003_int1.pin));
-	err = gpio_add_callback(max30003_int1.port, &int1_callback);
+	err = fifo_service_init();
 	if (err < 0) {
 		return err;
 	}
-	err = gpio_pin_interrupt_configure_dt(&max30003_int1,
-					      GPIO_INT_EDGE_TO_ACTIVE);
+	err = fifo_service_start();
 	if (err < 0) {
 		return err;
 	}
-
-	/* Service an interrupt that was already asserted before the edge was enabled. */
-	err = gpio_pin_get_dt(&max30003_int1);
-	if (err > 0) {
-		(void)k_work_submit(&fifo_work);
-	} else if (err < 0) {
-		return err;
-	}
-	(void)k_work_schedule(&sample_watchdog_work,
-			      K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS));
+	(void)k_work_schedule_for_queue(MAX30003_WORK_QUEUE, &sample_watchdog_work,
+					K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS));
 
 	return 0;
 }
@@ -531,10 +1185,7 @@ int max30003_set_monitoring(bool enabled)
 {
 	struct k_work_sync fifo_sync;
 	struct k_work_sync watchdog_sync;
-	uint32_t cnfg_gen = enabled ? MAX30003_CNFG_GEN_VALUE :
-		(MAX30003_CNFG_GEN_VALUE & ~MAX30003_CNFG_GEN_EN_ECG);
 	int err;
-	int first_err = 0;
 
 	if ((atomic_get(&monitoring_enabled) != 0) == enabled) {
 		return 0;
@@ -542,101 +1193,66 @@ int max30003_set_monitoring(bool enabled)
 
 	if (!enabled) {
 		int transition_err;
-		int rollback_err = 0;
+		int rollback_err;
 
 		atomic_clear(&monitoring_enabled);
-		err = gpio_pin_interrupt_configure_dt(&max30003_int1, GPIO_INT_DISABLE);
-		if (err < 0 && first_err == 0) {
-			first_err = err;
-		}
+		transition_err = fifo_service_stop();
 		(void)k_work_cancel_sync(&fifo_work, &fifo_sync);
 		(void)k_work_cancel_delayable_sync(&sample_watchdog_work, &watchdog_sync);
-		err = max30003_write_register(MAX30003_REG_CNFG_GEN, cnfg_gen);
-		if (err < 0 && first_err == 0) {
-			first_err = err;
-		}
-		err = max30003_write_register(MAX30003_REG_FIFO_RST, 0);
-		if (err < 0 && first_err == 0) {
-			first_err = err;
+		err = write_registers(monitoring_stop_writes, ARRAY_SIZE(monitoring_stop_writes));
+		if (err < 0 && transition_err == 0) {
+			transition_err = err;
 		}
 		update_lead_status(MAX30003_LEAD_STATUS_UNKNOWN);
-		if (first_err == 0) {
+		if (transition_err == 0) {
 			return 0;
 		}
 
 		/* Restore the previous ON state so callers never observe a half-stop. */
-		transition_err = first_err;
-		rollback_err = max30003_write_register(MAX30003_REG_CNFG_GEN,
-						     MAX30003_CNFG_GEN_VALUE);
-		if (rollback_err == 0) {
-			rollback_err = max30003_write_register(MAX30003_REG_FIFO_RST, 0);
-		}
-		if (rollback_err == 0) {
-			rollback_err = max30003_write_register(MAX30003_REG_SYNCH, 0);
-		}
+		rollback_err = write_registers(monitoring_start_writes,
+					       ARRAY_SIZE(monitoring_start_writes));
 		if (rollback_err == 0) {
-			timestamp_sample_index = 0U;
-			acquisition_epoch_ms = (uint64_t)k_uptime_get();
+			restart_sample_timeline();
+			rr_interval_primed = false;
 			atomic_set(&monitoring_enabled, 1);
-			rollback_err = gpio_pin_interrupt_configure_dt(
-				&max30003_int1, GPIO_INT_EDGE_TO_ACTIVE);
+			rollback_err = fifo_service_start();
 		}
 		if (rollback_err == 0) {
-			(void)k_work_schedule(&sample_watchdog_work,
+			(void)k_work_schedule_for_queue(
+				MAX30003_WORK_QUEUE, &sample_watchdog_work,
 				K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS));
 		} else {
 			atomic_clear(&monitoring_enabled);
-			(void)gpio_pin_interrupt_configure_dt(&max30003_int1,
-						      GPIO_INT_DISABLE);
-			(void)max30003_write_register(MAX30003_REG_CNFG_GEN,
-				MAX30003_CNFG_GEN_VALUE & ~MAX30003_CNFG_GEN_EN_ECG);
+			(void)fifo_service_stop();
+			(void)write_register_cached(MAX30003_REG_CNFG_GEN,
+						    MAX30003_CNFG_GEN_STOPPED_VALUE);
 			LOG_ERR("MAX30003 stop rollback failed: %d", rollback_err);
 		}
 		return transition_err;
 	}
 
-	err = max30003_write_register(MAX30003_REG_CNFG_GEN, cnfg_gen);
+	err = write_registers(monitoring_start_writes, ARRAY_SIZE(monitoring_start_writes));
 	if (err < 0) {
+		(void)write_register_cached(MAX30003_REG_CNFG_GEN,
+					    MAX30003_CNFG_GEN_STOPPED_VALUE);
 		return err;
 	}
-	err = max30003_write_register(MAX30003_REG_FIFO_RST, 0);
-	if (err < 0) {
-		goto enable_failed;
-	}
-	err = max30003_write_register(MAX30003_REG_SYNCH, 0);
-	if (err < 0) {
-		goto enable_failed;
-	}
 
-	timestamp_sample_index = 0U;
-	acquisition_epoch_ms = (uint64_t)k_uptime_get();
+	restart_sample_timeline();
+	rr_interval_primed = false;
 	atomic_set(&monitoring_enabled, 1);
-	err = gpio_pin_interrupt_configure_dt(&max30003_int1, GPIO_INT_EDGE_TO_ACTIVE);
+	err = fifo_service_start();
 	if (err < 0) {
 		atomic_clear(&monitoring_enabled);
-		(void)max30003_write_register(MAX30003_REG_CNFG_GEN,
-			MAX30003_CNFG_GEN_VALUE & ~MAX30003_CNFG_GEN_EN_ECG);
-		return err;
-	}
-	err = gpio_pin_get_dt(&max30003_int1);
-	if (err > 0) {
-		(void)k_work_submit(&fifo_work);
-	} else if (err < 0) {
-		atomic_clear(&monitoring_enabled);
-		(void)gpio_pin_interrupt_configure_dt(&max30003_int1, GPIO_INT_DISABLE);
-		(void)max30003_write_register(MAX30003_REG_CNFG_GEN,
-			MAX30003_CNFG_GEN_VALUE & ~MAX30003_CNFG_GEN_EN_ECG);
+		(void)fifo_service_stop();
+		(void)write_register_cached(MAX30003_REG_CNFG_GEN,
+					    MAX30003_CNFG_GEN_STOPPED_VALUE);
 		return err;
 	}
-	(void)k_work_schedule(&sample_watchdog_work,
-			      K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS));
+	(void)k_work_schedule_for_queue(MAX30003_WORK_QUEUE, &sample_watchdog_work,
+					K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS));
 
 	return 0;
-
-enable_failed:
-	(void)max30003_write_register(MAX30003_REG_CNFG_GEN,
-		MAX30003_CNFG_GEN_VALUE & ~MAX30003_CNFG_GEN_EN_ECG);
-	return err;
 }
 
 bool max30003_is_monitoring(void)
@@ -676,6 +1292,84 @@ void max30003_set_drop_handler(max30003_drop_handler_t handler, void *user_data)
 	}
 }
 
+void max30003_set_rr_interval_handler(max30003_rr_interval_handler_t handler,
+				      void *user_data)
+{
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	rr_interval_callback = handler;
+	rr_interval_callback_data = user_data;
+	k_mutex_unlock(&max30003_lock);
+}
+
+void max30003_set_sample_block_handler(max30003_sample_block_handler_t handler,
+				       void *user_data)
+{
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	sample_block_callback = handler;
+	sample_block_callback_data = user_data;
+	k_mutex_unlock(&max30003_lock);
+}
+
+void max30003_get_fifo_service_stats(struct max30003_fifo_service_stats *stats)
+{
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	*stats = fifo_service_stats;
+	k_mutex_unlock(&max30003_lock);
+}
+
+void max30003_reset_fifo_service_stats(void)
+{
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	fifo_service_stats = (struct max30003_fifo_service_stats){ 0 };
+	k_mutex_unlock(&max30003_lock);
+}
+
+int max30003_set_fifo_threshold(uint8_t samples)
+{
+	uint32_t value = MAX30003_MNGR_INT_VALUE((uint32_t)samples);
+	uint32_t actual;
+	bool unchanged;
+	int err;
+
+	if (samples == 0U || samples > MAX30003_FIFO_DEPTH) {
+		return -EINVAL;
+	}
+	if (IS_ENABLED(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)) {
+		return -ENOTSUP;
+	}
+
+	/* The shadow was verified against the device when it was written. */
+	k_mutex_lock(&max30003_lock, K_FOREVER);
+	unchanged = shadow_matches(MAX30003_REG_MNGR_INT, value);
+	k_mutex_unlock(&max30003_lock);
+	if (unchanged) {
+		return 0;
+	}
+
+	err = write_register_cached(MAX30003_REG_MNGR_INT, value);
+	if (err < 0) {
+		return err;
+	}
+	err = max30003_read_register(MAX30003_REG_MNGR_INT, &actual);
+	if (err < 0) {
+		return err;
+	}
+	if (actual != value) {
+		invalidate_shadow(MAX30003_REG_MNGR_INT);
+		LOG_ERR("MNGR_INT readback mismatch: wrote 0x%06x, read 0x%06x", value, actual);
+		return -EIO;
+	}
+	atomic_set(&fifo_interrupt_samples, samples);
+
+	/* A lower threshold may already be met, leaving no new INT1 edge to wait for. */
+	if (atomic_get(&monitoring_enabled) && gpio_pin_get_dt(&max30003_int1) > 0) {
+		(void)k_work_submit_to_queue(MAX30003_WORK_QUEUE, &fifo_work);
+	}
+	LOG_INF("ECG FIFO interrupt threshold set to %u samples", (unsigned int)samples);
+
+	return 0;
+}
+
 int max30003_dump_registers(void)
 {
 	uint32_t value;
@@ -0,0 +1,277 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "max30003_dma.h"
+#include "max30003_dma_ring.h"
+
+#include <errno.h>
+
+#include <hal/nrf_gpio.h>
+#include <hal/nrf_gpiote.h>
+#include <hal/nrf_spim.h>
+#include <hal/nrf_timer.h>
+#include <nrfx_gpiote.h>
+#include <nrfx_ppi.h>
+#include <soc.h>
+
+#include <zephyr/devicetree.h>
+#include <zephyr/irq.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(max30003_dma, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define DT_DRV_COMPAT maxim_max30003
+
+#define MAX30003_DMA_NODE     DT_DRV_INST(0)
+#define MAX30003_DMA_BUS_NODE DT_BUS(MAX30003_DMA_NODE)
+#define MAX30003_DMA_SPIM     ((NRF_SPIM_Type *)DT_REG_ADDR(MAX30003_DMA_BUS_NODE))
+#define MAX30003_DMA_CS_PIN   NRF_DT_GPIOS_TO_PSEL(MAX30003_DMA_BUS_NODE, cs_gpios)
+#define MAX30003_DMA_INT1_PIN NRF_DT_GPIOS_TO_PSEL(MAX30003_DMA_NODE, int_gpios)
+
+/* TIMER3 is reserved for burst counting; the radio stack uses TIMER0. */
+#define MAX30003_DMA_TIMER              NRF_TIMER3
+#define MAX30003_DMA_TIMER_IRQN         TIMER3_IRQn
+#define MAX30003_DMA_TIMER_IRQ_PRIORITY 2
+
+/* Longest burst at the devicetree SPI clock, plus margin for PPI/CS latency. */
+#define MAX30003_DMA_BURST_TIME_US                                                         \
+	((MAX30003_DMA_MAX_RECORD_SIZE * 8U * USEC_PER_SEC) /                               \
+		 DT_PROP(MAX30003_DMA_NODE, spi_max_frequency) +                            \
+	 10U)
+
+static const nrfx_gpiote_t gpiote = NRFX_GPIOTE_INSTANCE(0);
+
+static uint8_t burst_command;
+static max30003_dma_ready_handler_t ready_callback;
+static uint8_t int1_channel;
+static uint8_t cs_channel;
+static nrf_ppi_channel_t trigger_channel;
+static nrf_ppi_channel_t complete_channel;
+static uint32_t paused_burst_count;
+/* The pending half completion was not started by an edge or was not serviced at once. */
+static bool half_end_untimed;
+static int64_t burst_transfer_ticks;
+static bool armed;
+static bool initialized;
+
+static void capture_timer_isr(const void *arg)
+{
+	uint8_t active_half;
+
+	ARG_UNUSED(arg);
+	nrf_timer_event_clear(MAX30003_DMA_TIMER, NRF_TIMER_EVENT_COMPARE0);
+	active_half = max30003_dma_ring_complete_half(
+		half_end_untimed ? -1 : k_uptime_ticks() - burst_transfer_ticks);
+	half_end_untimed = false;
+
+	/* The next INT1 edge is one FIFO batch away, so re-pointing here is never late. */
+	nrf_spim_rx_buffer_set(MAX30003_DMA_SPIM, max30003_dma_ring_burst(active_half, 0U),
+			       max30003_dma_ring_record_size());
+
+	if (ready_callback != NULL) {
+		ready_callback();
+	}
+}
+
+static void arm_spim(uint8_t *rx_address)
+{
+	NRF_SPIM_Type *spim = MAX30003_DMA_SPIM;
+
+	/* Zephyr's SPI driver enables END for its own transfers; bursts need no IRQ. */
+	nrf_spim_int_disable(spim, NRF_SPIM_INT_END_MASK);
+	nrf_spim_event_clear(spim, NRF_SPIM_EVENT_END);
+	nrf_spim_orc_set(spim, 0xff);
+	nrf_spim_tx_buffer_set(spim, &burst_command, sizeof(burst_command));
+	nrf_spim_tx_list_disable(spim);
+	nrf_spim_rx_buffer_set(spim, rx_address, max30003_dma_ring_record_size());
+	nrf_spim_rx_list_enable(spim);
+	nrf_spim_enable(spim);
+}
+
+static void start_burst_if_int1_active(void)
+{
+	/* An already-active INT1 will not produce the edge that starts a burst. */
+	if (nrf_gpio_pin_read(MAX30003_DMA_INT1_PIN) == 0U) {
+		/* The edge came while paused, so a half this burst completes is untimed. */
+		if (paused_burst_count + 1U == MAX30003_DMA_BURSTS_PER_HALF) {
+			half_end_untimed = true;
+		}
+		nrf_gpiote_task_trigger(NRF_GPIOTE, nrf_gpiote_clr_task_get(cs_channel));
+		nrf_spim_task_trigger(MAX30003_DMA_SPIM, NRF_SPIM_TASK_START);
+	}
+}
+
+int max30003_dma_init(max30003_dma_ready_handler_t ready_handler, uint8_t command,
+		      size_t burst_words)
+{
+	uint32_t int1_event;
+	uint32_t cs_clear_task;
+	uint32_t cs_set_task;
+
+	if (ready_handler == NULL || burst_words == 0U ||
+	    burst_words > MAX30003_DMA_MAX_BURST_WORDS) {
+		return -EINVAL;
+	}
+	if (initialized) {
+		return -EALREADY;
+	}
+
+	if (nrfx_gpiote_channel_alloc(&gpiote, &int1_channel) != NRFX_SUCCESS ||
+	    nrfx_gpiote_channel_alloc(&gpiote, &cs_channel) != NRFX_SUCCESS ||
+	    nrfx_ppi_channel_alloc(&trigger_channel) != NRFX_SUCCESS ||
+	    nrfx_ppi_channel_alloc(&complete_channel) != NRFX_SUCCESS) {
+		LOG_ERR("No free GPIOTE or PPI channel for DMA capture");
+		return -EBUSY;
+	}
+
+	ready_callback = ready_handler;
+	burst_command = command;
+	max30003_dma_ring_init(burst_words);
+	/* The completion interrupt follows the INT1 edge by one burst transfer. */
+	burst_transfer_ticks = (int64_t)k_us_to_ticks_floor64(
+		(max30003_dma_ring_record_size() * 8U * USEC_PER_SEC) /
+		DT_PROP(MAX30003_DMA_NODE, spi_max_frequency));
+
+	nrf_gpiote_event_configure(NRF_GPIOTE, int1_channel, MAX30003_DMA_INT1_PIN,
+				   NRF_GPIOTE_POLARITY_HITOLO);
+	nrf_gpiote_event_enable(NRF_GPIOTE, int1_channel);
+	nrf_gpiote_task_configure(NRF_GPIOTE, cs_channel, MAX30003_DMA_CS_PIN,
+				  NRF_GPIOTE_POLARITY_TOGGLE, NRF_GPIOTE_INITIAL_VALUE_HIGH);
+	/* Pause reads chip select back to see whether a burst is in flight. */
+	nrf_gpio_cfg(MAX30003_DMA_CS_PIN, NRF_GPIO_PIN_DIR_OUTPUT, NRF_GPIO_PIN_INPUT_CONNECT,
+		     NRF_GPIO_PIN_NOPULL, NRF_GPIO_PIN_S0S1, NRF_GPIO_PIN_NOSENSE);
+
+	/* INT1 falling edge: assert CS and start SPIM. END: release CS and count. */
+	int1_event = nrf_gpiote_event_address_get(NRF_GPIOTE,
+						  nrf_gpiote_in_event_get(int1_channel));
+	cs_clear_task = nrf_gpiote_task_address_get(NRF_GPIOTE,
+						    nrf_gpiote_clr_task_get(cs_channel));
+	cs_set_task = nrf_gpiote_task_address_get(NRF_GPIOTE,
+						  nrf_gpiote_set_task_get(cs_channel));
+	if (nrfx_ppi_channel_assign(trigger_channel, int1_event, cs_clear_task) !=
+		    NRFX_SUCCESS ||
+	    nrfx_ppi_channel_fork_assign(trigger_channel,
+					 nrf_spim_task_address_get(MAX30003_DMA_SPIM,
+								   NRF_SPIM_TASK_START)) !=
+		    NRFX_SUCCESS ||
+	    nrfx_ppi_channel_assign(complete_channel,
+				    nrf_spim_event_address_get(MAX30003_DMA_SPIM,
+							       NRF_SPIM_EVENT_END),
+				    cs_set_task) != NRFX_SUCCESS ||
+	    nrfx_ppi_channel_fork_assign(complete_channel,
+					 nrf_timer_task_address_get(MAX30003_DMA_TIMER,
+								    NRF_TIMER_TASK_COUNT)) !=
+		    NRFX_SUCCESS ||
+	    nrfx_ppi_channel_enable(complete_channel) != NRFX_SUCCESS) {
+		LOG_ERR("DMA capture PPI configuration failed");
+		return -EIO;
+	}
+
+	nrf_timer_mode_set(MAX30003_DMA_TIMER, NRF_TIMER_MODE_LOW_POWER_COUNTER);
+	nrf_timer_bit_width_set(MAX30003_DMA_TIMER, NRF_TIMER_BIT_WIDTH_16);
+	nrf_timer_cc_set(MAX30003_DMA_TIMER, NRF_TIMER_CC_CHANNEL0, MAX30003_DMA_BURSTS_PER_HALF);
+	nrf_timer_shorts_enable(MAX30003_DMA_TIMER, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK);
+	nrf_timer_int_enable(MAX30003_DMA_TIMER, NRF_TIMER_INT_COMPARE0_MASK);
+	IRQ_CONNECT(MAX30003_DMA_TIMER_IRQN, MAX30003_DMA_TIMER_IRQ_PRIORITY, capture_timer_isr,
+		    NULL, 0);
+
+	initialized = true;
+	LOG_INF("DMA capture ready: %u-word bursts, CPU wake every %u bursts",
+		(unsigned int)burst_words, (unsigned int)MAX30003_DMA_BURSTS_PER_HALF);
+
+	return 0;
+}
+
+int max30003_dma_start(void)
+{
+	if (!initialized) {
+		return -EACCES;
+	}
+	if (armed) {
+		return 0;
+	}
+
+	max30003_dma_ring_reset();
+	paused_burst_count = 0U;
+	half_end_untimed = false;
+	nrf_timer_task_trigger(MAX30003_DMA_TIMER, NRF_TIMER_TASK_CLEAR);
+	nrf_timer_event_clear(MAX30003_DMA_TIMER, NRF_TIMER_EVENT_COMPARE0);
+	nrf_timer_task_trigger(MAX30003_DMA_TIMER, NRF_TIMER_TASK_START);
+	armed = true;
+	max30003_dma_resume();
+
+	return 0;
+}
+
+void max30003_dma_stop(void)
+{
+	if (!armed) {
+		return;
+	}
+
+	max30003_dma_pause();
+	armed = false;
+	nrf_timer_task_trigger(MAX30003_DMA_TIMER, NRF_TIMER_TASK_STOP);
+	max30003_dma_ring_discard();
+}
+
+void max30003_dma_pause(void)
+{
+	if (!armed) {
+		return;
+	}
+
+	irq_disable(MAX30003_DMA_TIMER_IRQN);
+	(void)nrfx_ppi_channel_disable(trigger_channel);
+	/* A burst INT1 already started holds chip select low until it finishes. */
+	for (uint32_t waited_us = 0U; waited_us < MAX30003_DMA_BURST_TIME_US; ++waited_us) {
+		if (nrf_gpio_pin_read(MAX30003_DMA_CS_PIN) != 0U) {
+			break;
+		}
+		k_busy_wait(1U);
+	}
+	nrf_timer_task_trigger(MAX30003_DMA_TIMER, NRF_TIMER_TASK_CAPTURE1);
+	paused_burst_count = nrf_timer_cc_get(MAX30003_DMA_TIMER, NRF_TIMER_CC_CHANNEL1);
+	/* The interrupt of a half completed before the pause runs only on resume. */
+	if (nrf_timer_event_check(MAX30003_DMA_TIMER, NRF_TIMER_EVENT_COMPARE0)) {
+		half_end_untimed = true;
+	}
+	nrf_gpiote_task_disable(NRF_GPIOTE, cs_channel);
+}
+
+void max30003_dma_resume(void)
+{
+	if (!armed) {
+		return;
+	}
+
+	/* A pending COMPARE0 ISR re-points the ring once the IRQ is enabled again. */
+	arm_spim(max30003_dma_ring_burst(max30003_dma_ring_active_half(), paused_burst_count));
+	nrf_gpiote_task_enable(NRF_GPIOTE, cs_channel);
+	(void)nrfx_ppi_channel_enable(trigger_channel);
+	irq_enable(MAX30003_DMA_TIMER_IRQN);
+	start_burst_if_int1_active();
+}
+
+uint32_t max30003_dma_position(void)
+{
+	uint32_t burst = paused_burst_count;
+
+	/* COMPARE0 cleared the count of a just-filled half whose ISR is still pending. */
+	if (nrf_timer_event_check(MAX30003_DMA_TIMER, NRF_TIMER_EVENT_COMPARE0)) {
+		burst = MAX30003_DMA_BURSTS_PER_HALF;
+	}
+
+	return max30003_dma_ring_position(burst);
+}
+
+uint32_t max30003_dma_take_overrun_words(void)
+{
+	return max30003_dma_ring_take_overrun_words();
+}
+
+void max30003_dma_drain(max30003_dma_burst_handler_t handler, uint32_t position)
+{
+	max30003_dma_ring_drain(handler, position);
+}
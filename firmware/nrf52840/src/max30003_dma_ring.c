@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "max30003_dma_ring.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+/* A position names a half and a burst count of 0..BURSTS_PER_HALF within it. */
+#define MAX30003_DMA_POSITION_STRIDE (MAX30003_DMA_BURSTS_PER_HALF + 1U)
+
+/* EasyDMA ArrayList: each burst lands one record after the previous one. */
+static uint8_t burst_ring[MAX30003_DMA_RING_HALVES][MAX30003_DMA_BURSTS_PER_HALF]
+			 [MAX30003_DMA_MAX_RECORD_SIZE] __aligned(4);
+static uint32_t burst_words[MAX30003_DMA_MAX_BURST_WORDS];
+static size_t burst_word_count;
+static size_t burst_record_size;
+static uint8_t active_half;
+/* Bursts of each half already delivered by a drain that stopped inside it. */
+static uint32_t delivered_bursts[MAX30003_DMA_RING_HALVES];
+/* INT1 edge of the last burst of each completed half, or -1 when unknown. */
+static int64_t half_edge_ticks[MAX30003_DMA_RING_HALVES];
+static atomic_t ready_halves;
+static atomic_t overrun_words;
+
+void max30003_dma_ring_init(size_t burst_words)
+{
+	burst_word_count = burst_words;
+	burst_record_size = MAX30003_DMA_COMMAND_SIZE + burst_words * MAX30003_DMA_WORD_SIZE;
+}
+
+size_t max30003_dma_ring_record_size(void)
+{
+	return burst_record_size;
+}
+
+void max30003_dma_ring_reset(void)
+{
+	atomic_clear(&ready_halves);
+	atomic_clear(&overrun_words);
+	active_half = 0U;
+	memset(delivered_bursts, 0, sizeof(delivered_bursts));
+}
+
+void max30003_dma_ring_discard(void)
+{
+	atomic_clear(&ready_halves);
+}
+
+uint8_t *max30003_dma_ring_burst(uint8_t half, uint32_t burst)
+{
+	return &burst_ring[0][0][0] +
+	       ((size_t)half * MAX30003_DMA_BURSTS_PER_HALF + burst) * burst_record_size;
+}
+
+uint8_t max30003_dma_ring_active_half(void)
+{
+	return active_half;
+}
+
+uint8_t max30003_dma_ring_complete_half(int64_t edge_ticks)
+{
+	uint8_t completed_half = active_half;
+
+	half_edge_ticks[completed_half] = edge_ticks;
+	active_half = (uint8_t)((active_half + 1U) % MAX30003_DMA_RING_HALVES);
+	if (atomic_test_and_clear_bit(&ready_halves, active_half)) {
+		(void)atomic_add(&overrun_words,
+				 (atomic_val_t)((MAX30003_DMA_BURSTS_PER_HALF -
+						 delivered_bursts[active_half]) *
+						burst_word_count));
+		delivered_bursts[active_half] = 0U;
+	}
+	atomic_set_bit(&ready_halves, completed_half);
+
+	return active_half;
+}
+
+uint32_t max30003_dma_ring_position(uint32_t burst)
+{
+	return (uint32_t)active_half * MAX30003_DMA_POSITION_STRIDE + burst;
+}
+
+uint32_t max30003_dma_ring_take_overrun_words(void)
+{
+	return (uint32_t)atomic_clear(&overrun_words);
+}
+
+/* Deliver the bursts of half from the last one delivered up to end. */
+static void deliver_bursts(uint8_t half, uint32_t end, bool completed,
+			   max30003_dma_burst_handler_t handler)
+{
+	for (uint32_t burst = delivered_bursts[half]; burst < end; ++burst) {
+		const uint8_t *record =
+			max30003_dma_ring_burst(half, burst) + MAX30003_DMA_COMMAND_SIZE;
+
+		for (size_t index = 0U; index < burst_word_count; ++index) {
+			const uint8_t *word = &record[index * MAX30003_DMA_WORD_SIZE];
+
+			burst_words[index] = ((uint32_t)word[0] << 16) |
+					     ((uint32_t)word[1] << 8) | (uint32_t)word[2];
+		}
+		if (handler != NULL) {
+			handler(burst_words, burst_word_count,
+				completed && burst + 1U == MAX30003_DMA_BURSTS_PER_HALF ?
+					half_edge_ticks[half] : -1);
+		}
+	}
+	delivered_bursts[half] = MAX(delivered_bursts[half], end);
+}
+
+void max30003_dma_ring_drain(max30003_dma_burst_handler_t handler, uint32_t position)
+{
+	uint8_t half = (uint8_t)(position / MAX30003_DMA_POSITION_STRIDE);
+	/* The other half is older when complete. */
+	uint8_t older_half = (uint8_t)((half + 1U) % MAX30003_DMA_RING_HALVES);
+
+	if (atomic_test_and_clear_bit(&ready_halves, older_half)) {
+		deliver_bursts(older_half, MAX30003_DMA_BURSTS_PER_HALF, true, handler);
+		delivered_bursts[older_half] = 0U;
+	}
+	/* A half that completed after the pause stays ready for the rest of its bursts. */
+	deliver_bursts(half, position % MAX30003_DMA_POSITION_STRIDE, false, handler);
+}
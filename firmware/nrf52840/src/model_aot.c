@@ -0,0 +1,675 @@
+// SPDX-License-Identifier: MIT
+
+#include "model_inference.h"
+
+#include "model_aot.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_REGISTER(tinycardia_model, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define SELF_TEST_OUTPUT_TOLERANCE 1
+
+static const int8_t zero_input_expected_output[] = {-49, 49};
+
+static bool initialized;
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+static struct tinycardia_model_profile profile;
+#endif
+
+#if defined(CONFIG_TINYCARDIA_MODEL_AOT_FRONT_END)
+/* Front-end input columns each stage has received and conv output columns it has computed. */
+struct stream_progress {
+	int32_t received;
+	int32_t computed;
+};
+
+static struct stream_progress stream_progress[TINYCARDIA_AOT_MAX_STREAM_STAGES];
+static size_t streamed_sample_count;
+#endif
+#if defined(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE)
+/* Sample offset of the window whose activations the stage buffers hold. */
+static uint32_t cached_window_start;
+static bool cached_window_valid;
+#endif
+
+/*
+ * Run the generated operators from first on in graph order; RESHAPE and
+ * EXPAND_DIMS cost nothing.
+ */
+static int invoke_operators(size_t first, bool profiled)
+{
+	for (size_t index = first; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		const struct tinycardia_aot_operator *op = &tinycardia_aot_operators[index];
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+		uint32_t start_cycles = k_cycle_get_32();
+#endif
+		int err = op->invoke == NULL ? 0 : op->invoke();
+
+		if (err < 0) {
+			LOG_ERR("AOT operator %u (%s) failed: %d", (unsigned int)index, op->name,
+				err);
+			return -EIO;
+		}
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+		if (profiled) {
+			profile.operators[index].cycles += k_cycle_get_32() - start_cycles;
+		}
+#endif
+	}
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	if (profiled) {
+		++profile.invocations;
+	}
+#else
+	ARG_UNUSED(profiled);
+#endif
+
+	return 0;
+}
+
+static int run_startup_self_test(void)
+{
+	int err;
+
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_RR_COUNT; ++index) {
+		tinycardia_aot_rr_input[index] = TINYCARDIA_MODEL_RR_ZERO_POINT;
+	}
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+		tinycardia_aot_ecg_input[index] = TINYCARDIA_MODEL_ECG_ZERO_POINT;
+	}
+	err = invoke_operators(0U, false);
+	if (err < 0) {
+		LOG_ERR("AOT startup self-test failed");
+		return err;
+	}
+
+	for (size_t index = 0U; index < ARRAY_SIZE(zero_input_expected_output); ++index) {
+		int difference = (int)tinycardia_aot_output[index] -
+				 (int)zero_input_expected_output[index];
+
+		if (difference < -SELF_TEST_OUTPUT_TOLERANCE ||
+		    difference > SELF_TEST_OUTPUT_TOLERANCE) {
+			LOG_ERR("AOT startup self-test mismatch at %u: expected %d, got %d",
+				(unsigned int)index, (int)zero_input_expected_output[index],
+				(int)tinycardia_aot_output[index]);
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+static void log_profile(void)
+{
+	uint64_t total_cycles = 0U;
+
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		total_cycles += profile.operators[index].cycles;
+	}
+	if (profile.invocations == 0U || total_cycles == 0U) {
+		return;
+	}
+
+	LOG_INF("Model profile over %u inferences: %u us per invoke",
+		(unsigned int)profile.invocations,
+		(unsigned int)k_cyc_to_us_floor64(total_cycles / profile.invocations));
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		const struct tinycardia_model_operator_profile *op = &profile.operators[index];
+		uint64_t permille = (op->cycles * 1000U) / total_cycles;
+
+		LOG_INF("  op %2u %-16s %7u us %3u.%u%%", (unsigned int)index, op->name,
+			(unsigned int)k_cyc_to_us_floor64(op->cycles / profile.invocations),
+			(unsigned int)(permille / 10U), (unsigned int)(permille % 10U));
+	}
+}
+#endif
+
+static uint16_t probability_to_confidence(float probability)
+{
+	if (probability < 0.0f) {
+		probability = 0.0f;
+	} else if (probability > 1.0f) {
+		probability = 1.0f;
+	}
+
+	return (uint16_t)lroundf(probability * 10000.0f);
+}
+
+static int quantize_rr_features(const float *rr_features, size_t rr_count)
+{
+	if (rr_count != TINYCARDIA_MODEL_RR_COUNT) {
+		return -EMSGSIZE;
+	}
+
+	for (size_t index = 0U; index < rr_count; ++index) {
+		tinycardia_aot_rr_input[index] =
+			tinycardia_model_quantize(rr_features[index], TINYCARDIA_MODEL_RR_SCALE,
+						  TINYCARDIA_MODEL_RR_ZERO_POINT);
+	}
+
+	return 0;
+}
+
+static void read_result(uint64_t elapsed_cycles, struct tinycardia_model_result *result)
+{
+	size_t selected_index;
+	float selected_probability;
+
+	result->quantized_probabilities[0] = tinycardia_aot_output[0];
+	result->quantized_probabilities[1] = tinycardia_aot_output[1];
+	selected_index = tinycardia_aot_output[1] > tinycardia_aot_output[0] ? 1U : 0U;
+	selected_probability = tinycardia_model_dequantize(tinycardia_aot_output[selected_index],
+							   TINYCARDIA_MODEL_OUTPUT_SCALE,
+							   TINYCARDIA_MODEL_OUTPUT_ZERO_POINT);
+
+	/* Notebook LabelEncoder classes_: [atrial fibrillation, sinus normal]. */
+	result->classification = selected_index == 0U ? TINYCARDIA_CLASSIFICATION_AFIB
+						      : TINYCARDIA_CLASSIFICATION_NORMAL;
+	result->confidence = probability_to_confidence(selected_probability);
+	result->invoke_time_us = (uint32_t)k_cyc_to_us_floor64(elapsed_cycles);
+}
+
+#if defined(CONFIG_TINYCARDIA_MODEL_AOT_FRONT_END)
+/* Restart the front end for a new window with only the SAME padding in the stage inputs. */
+static void stream_start(void)
+{
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+
+	for (size_t index = 0U; index < stream->stage_count; ++index) {
+		const struct tinycardia_aot_stage *stage = &stream->stages[index];
+		const struct tinycardia_aot_conv *conv = stage->conv;
+		int32_t right_padding = conv->kernel_width - 1 - conv->padding_width;
+
+		/* The input zero point adds nothing to an accumulator, exactly like padding. */
+		memset(stage->input, -conv->input_offset,
+		       (size_t)(conv->padding_width * conv->input_channels));
+		memset(&stage->input[(conv->padding_width + conv->input_width) *
+				     conv->input_channels],
+		       -conv->input_offset, (size_t)(right_padding * conv->input_channels));
+		stream_progress[index] = (struct stream_progress){0};
+	}
+	streamed_sample_count = 0U;
+#if defined(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE)
+	cached_window_valid = false;
+#endif
+}
+
+/* Where stage index stores its output column: the next stage's padded input, or the output. */
+static int8_t *stream_destination(size_t index, int32_t column)
+{
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+	const struct tinycardia_aot_conv *next;
+
+	if (index + 1U == stream->stage_count) {
+		return &stream->output[column * stream->stages[index].conv->output_channels];
+	}
+	next = stream->stages[index + 1U].conv;
+
+	return &stream->stages[index + 1U]
+			.input[(next->padding_width + column) * next->input_channels];
+}
+
+/* Compute conv output columns [first, first + count) of one stage, pool them, and pass them on. */
+static int stream_band(size_t index, int32_t first, int32_t count)
+{
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+	const struct tinycardia_aot_stage *stage = &stream->stages[index];
+	struct tinycardia_aot_conv conv = *stage->conv;
+	struct tinycardia_aot_pool pool;
+	int err;
+
+	/* Padding is stored in the stage input, so every band is a VALID convolution. */
+	conv.input_width = count + conv.kernel_width - 1;
+	conv.output_width = count;
+	conv.padding_width = 0;
+	if (tinycardia_aot_conv_scratch_size(&conv) > stream->scratch_size) {
+		return -ENOMEM;
+	}
+	err = tinycardia_aot_conv_s8(&conv, &stage->input[first * conv.input_channels],
+				     stage->pool != NULL ? stream->band
+							 : stream_destination(index, first),
+				     stream->scratch, stream->scratch_size);
+	if (err == 0 && stage->pool != NULL) {
+		pool = *stage->pool;
+		pool.input_width = count;
+		pool.output_width = count / pool.stride_width;
+		err = tinycardia_aot_max_pool_s8(&pool, stream->band,
+						 stream_destination(index,
+								    first / pool.stride_width));
+	}
+
+	return err;
+}
+
+/* Compute conv output columns [first, end) of one stage in bands. */
+static int stream_columns(size_t index, int32_t first, int32_t end)
+{
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+
+	while (first < end) {
+		int32_t count = MIN(end - first, stream->band_columns);
+		int err = stream_band(index, first, count);
+
+		if (err < 0) {
+			return err;
+		}
+		first += count;
+	}
+
+	return 0;
+}
+
+/*
+ * Compute every front-end column whose inputs have arrived. Until the window
+ * is complete, the first stage holds back the columns that read its right
+ * padding, so they are left for tinycardia_model_stream_finish().
+ */
+static int stream_advance(bool window_complete)
+{
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+
+	for (size_t index = 0U; index < stream->stage_count; ++index) {
+		const struct tinycardia_aot_stage *stage = &stream->stages[index];
+		const struct tinycardia_aot_conv *conv = stage->conv;
+		struct stream_progress *progress = &stream_progress[index];
+		int32_t step = stage->pool != NULL ? stage->pool->stride_width : 1;
+		int32_t ready = conv->output_width;
+
+		if (progress->received < conv->input_width || (index == 0U && !window_complete)) {
+			/* Output column n reads input columns up to n plus the right padding. */
+			ready = progress->received - (conv->kernel_width - 1 - conv->padding_width);
+			ready = ready < 0 ? 0 : ready - ready % step;
+		}
+		if (progress->computed < ready) {
+			int err = stream_columns(index, progress->computed, ready);
+
+			if (err < 0) {
+				return err;
+			}
+			if (index + 1U < stream->stage_count) {
+				stream_progress[index + 1U].received +=
+					(ready - progress->computed) / step;
+			}
+			progress->computed = ready;
+		}
+	}
+
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE)
+/* Whole front end of a window, which then becomes the cached one. */
+static int stream_window(const int8_t *ecg)
+{
+	const struct tinycardia_aot_conv *conv = tinycardia_aot_stream.stages[0].conv;
+
+	stream_start();
+	memcpy(&tinycardia_aot_stream.stages[0].input[conv->padding_width], ecg,
+	       TINYCARDIA_MODEL_ECG_COUNT);
+	stream_progress[0].received = TINYCARDIA_MODEL_ECG_COUNT;
+
+	return stream_advance(true);
+}
+
+/*
+ * Move every stage buffer and the front-end output left by the columns that
+ * shift samples cover, then recompute only the conv columns that read samples
+ * new to the window, the SAME padding at either end of it, or columns that
+ * changed in the stage before. The other columns are the previous window's.
+ */
+static int stream_slide(const int8_t *ecg, int32_t shift)
+{
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+	const struct tinycardia_aot_conv *last = stream->stages[stream->stage_count - 1U].conv;
+	int32_t column_shift = shift;
+	/* Input columns that changed: [0, left_changed) and [right_changed, width). */
+	int32_t left_changed = 0;
+	int32_t right_changed = TINYCARDIA_MODEL_ECG_COUNT - shift;
+
+	for (size_t index = 0U; index < stream->stage_count; ++index) {
+		const struct tinycardia_aot_stage *stage = &stream->stages[index];
+		const struct tinycardia_aot_conv *conv = stage->conv;
+		int8_t *columns = &stage->input[conv->padding_width * conv->input_channels];
+
+		memmove(columns, &columns[column_shift * conv->input_channels],
+			(size_t)((conv->input_width - column_shift) * conv->input_channels));
+		if (stage->pool != NULL) {
+			column_shift /= stage->pool->stride_width;
+		}
+	}
+	memmove(stream->output, &stream->output[column_shift * last->output_channels],
+		stream->output_size - (size_t)(column_shift * last->output_channels));
+	memcpy(&stream->stages[0].input[stream->stages[0].conv->padding_width + right_changed],
+	       &ecg[right_changed], (size_t)shift);
+
+	for (size_t index = 0U; index < stream->stage_count; ++index) {
+		const struct tinycardia_aot_stage *stage = &stream->stages[index];
+		const struct tinycardia_aot_conv *conv = stage->conv;
+		int32_t step = stage->pool != NULL ? stage->pool->stride_width : 1;
+		int32_t left = conv->padding_width + left_changed;
+		int32_t right = right_changed - (conv->kernel_width - 1 - conv->padding_width);
+		int err;
+
+		/* Whole pooling windows only, so a pooled column is either kept or recomputed. */
+		left = MIN((left + step - 1) / step * step, conv->output_width);
+		right = right < 0 ? 0 : right / step * step;
+		if (left >= right) {
+			left = conv->output_width;
+			right = conv->output_width;
+		}
+		err = stream_columns(index, 0, left);
+		if (err == 0) {
+			err = stream_columns(index, right, conv->output_width);
+		}
+		if (err < 0) {
+			return err;
+		}
+		left_changed = left / step;
+		right_changed = right / step;
+	}
+
+	return 0;
+}
+#endif
+
+int tinycardia_model_init(void)
+{
+	int err;
+
+	if (initialized) {
+		return -EALREADY;
+	}
+
+	err = tinycardia_aot_prepare();
+	if (err < 0) {
+		LOG_ERR("AOT kernel scratch exceeds the planned arena space");
+		return err;
+	}
+	err = run_startup_self_test();
+	if (err < 0) {
+		return err;
+	}
+
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		profile.operators[index].name = tinycardia_aot_operators[index].name;
+	}
+#endif
+	initialized = true;
+	LOG_INF("AFib model ready: ahead-of-time graph, arena %u bytes, CMSIS-NN %s, "
+		"streaming %s, window reuse %s",
+		(unsigned int)tinycardia_aot_arena_size,
+		IS_ENABLED(CONFIG_TINYCARDIA_MODEL_AOT_CMSIS_NN) ? "enabled" : "disabled",
+		IS_ENABLED(CONFIG_TINYCARDIA_MODEL_STREAMING) ? "enabled" : "disabled",
+		IS_ENABLED(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE) ? "enabled" : "disabled");
+
+	return 0;
+}
+
+int8_t *tinycardia_model_ecg_input(void)
+{
+	if (!initialized) {
+		return NULL;
+	}
+
+	return tinycardia_aot_ecg_input;
+}
+
+/* The inputs live outside the arena, so the whole arena is free between inferences. */
+void *tinycardia_model_scratch(size_t *size)
+{
+	if (size == NULL || !initialized) {
+		return NULL;
+	}
+
+	*size = tinycardia_aot_arena_size;
+	return tinycardia_aot_arena;
+}
+
+int tinycardia_model_infer(const float *ecg, size_t ecg_count, const float *rr_features,
+			   size_t rr_count, struct tinycardia_model_result *result)
+{
+	if (!initialized) {
+		return -EACCES;
+	}
+	if (ecg == NULL || rr_features == NULL || result == NULL) {
+		return -EINVAL;
+	}
+	if (ecg_count != TINYCARDIA_MODEL_ECG_COUNT || rr_count != TINYCARDIA_MODEL_RR_COUNT) {
+		return -EMSGSIZE;
+	}
+
+	for (size_t index = 0U; index < ecg_count; ++index) {
+		tinycardia_aot_ecg_input[index] = tinycardia_model_quantize(
+			ecg[index], TINYCARDIA_MODEL_ECG_SCALE, TINYCARDIA_MODEL_ECG_ZERO_POINT);
+	}
+
+	return tinycardia_model_infer_quantized(rr_features, rr_count, result);
+}
+
+int tinycardia_model_infer_quantized(const float *rr_features, size_t rr_count,
+				     struct tinycardia_model_result *result)
+{
+	uint64_t start_cycles;
+	uint64_t elapsed_cycles;
+	int err;
+
+	if (!initialized) {
+		return -EACCES;
+	}
+	if (rr_features == NULL || result == NULL) {
+		return -EINVAL;
+	}
+	err = quantize_rr_features(rr_features, rr_count);
+	if (err < 0) {
+		return err;
+	}
+
+	start_cycles = k_cycle_get_64();
+	err = invoke_operators(0U, true);
+	if (err < 0) {
+		return err;
+	}
+	elapsed_cycles = k_cycle_get_64() - start_cycles;
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	if (CONFIG_TINYCARDIA_MODEL_PROFILE_LOG_INTERVAL > 0 &&
+	    profile.invocations % CONFIG_TINYCARDIA_MODEL_PROFILE_LOG_INTERVAL == 0U) {
+		log_profile();
+	}
+#endif
+
+	read_result(elapsed_cycles, result);
+
+	return 0;
+}
+
+int tinycardia_model_stream_append(const int8_t *ecg, size_t offset, size_t count)
+{
+#if defined(CONFIG_TINYCARDIA_MODEL_STREAMING)
+	const struct tinycardia_aot_stage *stage = &tinycardia_aot_stream.stages[0];
+	int err;
+
+	if (!initialized) {
+		return -EACCES;
+	}
+	if (ecg == NULL) {
+		return -EINVAL;
+	}
+	if (offset == 0U) {
+		stream_start();
+	}
+	if (offset != streamed_sample_count || count > TINYCARDIA_MODEL_ECG_COUNT - offset) {
+		return -EINVAL;
+	}
+
+	/* The ECG input has one channel, so samples are the first stage's columns. */
+	memcpy(&stage->input[stage->conv->padding_width + (int32_t)offset], ecg, count);
+	streamed_sample_count += count;
+	stream_progress[0].received = (int32_t)streamed_sample_count;
+	err = stream_advance(false);
+	if (err < 0) {
+		LOG_ERR("Streamed front end failed: %d", err);
+		streamed_sample_count = 0U;
+		return -EIO;
+	}
+
+	return 0;
+#else
+	ARG_UNUSED(ecg);
+	ARG_UNUSED(offset);
+	ARG_UNUSED(count);
+
+	return -ENOTSUP;
+#endif
+}
+
+int tinycardia_model_stream_finish(const float *rr_features, size_t rr_count,
+				   struct tinycardia_model_result *result)
+{
+#if defined(CONFIG_TINYCARDIA_MODEL_STREAMING)
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+	uint64_t start_cycles;
+	int err;
+
+	if (!initialized) {
+		return -EACCES;
+	}
+	if (rr_features == NULL || result == NULL) {
+		return -EINVAL;
+	}
+	if (streamed_sample_count != TINYCARDIA_MODEL_ECG_COUNT) {
+		return -ENODATA;
+	}
+	err = quantize_rr_features(rr_features, rr_count);
+	if (err < 0) {
+		return err;
+	}
+
+	start_cycles = k_cycle_get_64();
+	streamed_sample_count = 0U;
+	err = stream_advance(true);
+	if (err < 0) {
+		LOG_ERR("Streamed front end failed: %d", err);
+		return -EIO;
+	}
+	memcpy(stream->tail_input, stream->output, stream->output_size);
+	/* Only part of the graph runs here, so it stays out of the per-operator profile. */
+	err = invoke_operators(stream->tail_operator, false);
+	if (err < 0) {
+		return err;
+	}
+
+	read_result(k_cycle_get_64() - start_cycles, result);
+
+	return 0;
+#else
+	ARG_UNUSED(rr_features);
+	ARG_UNUSED(rr_count);
+	ARG_UNUSED(result);
+
+	return -ENOTSUP;
+#endif
+}
+
+int tinycardia_model_infer_window(uint32_t start_sample, const float *rr_features,
+				  size_t rr_count, struct tinycardia_model_result *result)
+{
+#if defined(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE)
+	const struct tinycardia_aot_stream *stream = &tinycardia_aot_stream;
+	const struct tinycardia_aot_stage *first = &stream->stages[0];
+	const int8_t *cached = &first->input[first->conv->padding_width];
+	uint32_t shift = start_sample - cached_window_start;
+	uint32_t alignment = 1U;
+	size_t reused = 0U;
+	uint64_t start_cycles;
+	int err;
+
+	if (!initialized) {
+		return -EACCES;
+	}
+	if (rr_features == NULL || result == NULL) {
+		return -EINVAL;
+	}
+	err = quantize_rr_features(rr_features, rr_count);
+	if (err < 0) {
+		return err;
+	}
+
+	for (size_t index = 0U; index < stream->stage_count; ++index) {
+		if (stream->stages[index].pool != NULL) {
+			alignment *= (uint32_t)stream->stages[index].pool->stride_width;
+		}
+	}
+
+	start_cycles = k_cycle_get_64();
+	/* Unsigned: a window before the cached one wraps to a shift past the window. */
+	if (cached_window_valid && shift > 0U && shift < TINYCARDIA_MODEL_ECG_COUNT &&
+	    shift % alignment == 0U &&
+	    memcmp(&cached[shift], tinycardia_aot_ecg_input,
+		   TINYCARDIA_MODEL_ECG_COUNT - shift) == 0) {
+		reused = TINYCARDIA_MODEL_ECG_COUNT - shift;
+		err = stream_slide(tinycardia_aot_ecg_input, (int32_t)shift);
+	} else {
+		err = stream_window(tinycardia_aot_ecg_input);
+	}
+	if (err < 0) {
+		LOG_ERR("Front end failed: %d", err);
+		stream_start();
+		return -EIO;
+	}
+	cached_window_start = start_sample;
+	cached_window_valid = true;
+
+	memcpy(stream->tail_input, stream->output, stream->output_size);
+	err = invoke_operators(stream->tail_operator, false);
+	if (err < 0) {
+		return err;
+	}
+
+	read_result(k_cycle_get_64() - start_cycles, result);
+
+	return (int)reused;
+#else
+	ARG_UNUSED(start_sample);
+	ARG_UNUSED(rr_features);
+	ARG_UNUSED(rr_count);
+	ARG_UNUSED(result);
+
+	return -ENOTSUP;
+#endif
+}
+
+int tinycardia_model_get_profile(struct tinycardia_model_profile *out)
+{
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	if (out == NULL) {
+		return -EINVAL;
+	}
+	if (!initialized) {
+		return -EACCES;
+	}
+
+	*out = profile;
+	out->cycles_per_second = (uint32_t)sys_clock_hw_cycles_per_sec();
+	return 0;
+#else
+	ARG_UNUSED(out);
+
+	return -ENOTSUP;
+#endif
+}
+
+size_t tinycardia_model_arena_used_bytes(void)
+{
+	return initialized ? tinycardia_aot_arena_size : 0U;
+}
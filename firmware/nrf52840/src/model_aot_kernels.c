@@ -0,0 +1,432 @@
+// SPDX-License-Identifier: MIT
+
+#include "model_aot.h"
+
+#include <errno.h>
+#include <limits.h>
+
+#if defined(CONFIG_TINYCARDIA_MODEL_AOT_CMSIS_NN)
+#include <arm_nnfunctions.h>
+#endif
+
+/* Integer bits of the softmax sum of exponentials, as in TFLM and CMSIS-NN. */
+#define SOFTMAX_ACCUMULATION_BITS 12
+
+/* gemmlowp fixed-point helpers, with the rounding of the TFLM reference kernels. */
+static int32_t doubling_high_multiply(int32_t a, int32_t b)
+{
+	int64_t product = (int64_t)a * (int64_t)b;
+	int32_t nudge = product >= 0 ? (1 << 30) : (1 - (1 << 30));
+
+	if (a == INT32_MIN && b == INT32_MIN) {
+		return INT32_MAX;
+	}
+
+	return (int32_t)((product + nudge) / (1LL << 31));
+}
+
+static int32_t rounding_divide_by_power_of_two(int32_t value, int32_t exponent)
+{
+	int32_t mask = (int32_t)((1LL << exponent) - 1);
+	int32_t remainder = value & mask;
+	int32_t threshold = (mask >> 1) + (value < 0 ? 1 : 0);
+
+	return (value >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+static int32_t saturating_multiply_by_power_of_two(int32_t value, int32_t exponent)
+{
+	int32_t threshold = (int32_t)((1LL << (31 - exponent)) - 1);
+
+	if (value > threshold) {
+		return INT32_MAX;
+	}
+	if (value < -threshold) {
+		return INT32_MIN;
+	}
+
+	return (int32_t)((uint32_t)value << exponent);
+}
+
+/* tflite::MultiplyByQuantizedMultiplier(), matching CMSIS-NN's arm_nn_requantize(). */
+static int32_t requantize(int32_t value, int32_t multiplier, int32_t shift)
+{
+	int32_t left_shift = shift > 0 ? shift : 0;
+	int32_t right_shift = shift > 0 ? 0 : -shift;
+
+	return rounding_divide_by_power_of_two(
+		doubling_high_multiply(value * (1 << left_shift), multiplier), right_shift);
+}
+
+static int8_t saturate(int32_t value, int32_t minimum, int32_t maximum)
+{
+	if (value < minimum) {
+		value = minimum;
+	} else if (value > maximum) {
+		value = maximum;
+	}
+
+	return (int8_t)value;
+}
+
+int tinycardia_aot_mean_s8(const struct tinycardia_aot_mean *mean, const int8_t *input,
+			   int8_t *output)
+{
+	for (int32_t outer = 0; outer < mean->outer_count; ++outer) {
+		const int8_t *block = &input[outer * mean->reduced_count * mean->inner_count];
+
+		for (int32_t inner = 0; inner < mean->inner_count; ++inner) {
+			int32_t sum = 0;
+
+			for (int32_t index = 0; index < mean->reduced_count; ++index) {
+				sum += block[index * mean->inner_count + inner];
+			}
+			sum -= mean->input_zero_point * mean->reduced_count;
+			*output++ = saturate(requantize(sum, mean->multiplier, mean->shift) +
+						     mean->output_zero_point,
+					     INT8_MIN, INT8_MAX);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * The dense layers are a few thousand multiply-accumulates next to millions
+ * in the convolutions, so they stay portable on every build.
+ */
+int tinycardia_aot_fully_connected_s8(const struct tinycardia_aot_fully_connected *fc,
+				      const int8_t *input, int8_t *output)
+{
+	for (int32_t batch = 0; batch < fc->batches; ++batch) {
+		const int8_t *values = &input[batch * fc->input_count];
+
+		for (int32_t channel = 0; channel < fc->output_count; ++channel) {
+			const int8_t *weights = &fc->weights[channel * fc->input_count];
+			int32_t accumulator = 0;
+
+			for (int32_t index = 0; index < fc->input_count; ++index) {
+				accumulator += weights[index] * (values[index] + fc->input_offset);
+			}
+			accumulator += fc->bias[channel];
+			*output++ = saturate(requantize(accumulator, fc->multipliers[channel],
+							fc->shifts[channel]) +
+						     fc->output_offset,
+					     fc->activation_min, fc->activation_max);
+		}
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_TINYCARDIA_MODEL_AOT_CMSIS_NN)
+struct cmsis_conv {
+	cmsis_nn_conv_params params;
+	cmsis_nn_per_channel_quant_params quantization;
+	cmsis_nn_dims input;
+	cmsis_nn_dims filter;
+	cmsis_nn_dims bias;
+	cmsis_nn_dims output;
+};
+
+static void describe_conv(const struct tinycardia_aot_conv *conv, struct cmsis_conv *cmsis)
+{
+	*cmsis = (struct cmsis_conv){
+		.params = {
+			.input_offset = conv->input_offset,
+			.output_offset = conv->output_offset,
+			.stride = {.w = conv->stride_width, .h = conv->stride_height},
+			.padding = {.w = conv->padding_width, .h = conv->padding_height},
+			.dilation = {.w = 1, .h = 1},
+			.activation = {.min = conv->activation_min, .max = conv->activation_max},
+		},
+		/* CMSIS-NN takes non-const pointers but only reads them. */
+		.quantization = {
+			.multiplier = (int32_t *)conv->multipliers,
+			.shift = (int32_t *)conv->shifts,
+		},
+		.input = {.n = 1, .h = conv->input_height, .w = conv->input_width,
+			  .c = conv->input_channels},
+		.filter = {.n = conv->output_channels, .h = conv->kernel_height,
+			   .w = conv->kernel_width, .c = conv->input_channels},
+		.bias = {.n = 1, .h = 1, .w = 1, .c = conv->output_channels},
+		.output = {.n = 1, .h = conv->output_height, .w = conv->output_width,
+			   .c = conv->output_channels},
+	};
+}
+
+size_t tinycardia_aot_conv_scratch_size(const struct tinycardia_aot_conv *conv)
+{
+	struct cmsis_conv cmsis;
+
+	describe_conv(conv, &cmsis);
+	return (size_t)arm_convolve_wrapper_s8_get_buffer_size(&cmsis.params, &cmsis.input,
+								 &cmsis.filter, &cmsis.output);
+}
+
+int tinycardia_aot_conv_s8(const struct tinycardia_aot_conv *conv, const int8_t *input,
+			   int8_t *output, void *scratch, size_t scratch_size)
+{
+	cmsis_nn_context context = {.buf = scratch, .size = (int32_t)scratch_size};
+	struct cmsis_conv cmsis;
+
+	describe_conv(conv, &cmsis);
+	if (arm_convolve_wrapper_s8(&context, &cmsis.params, &cmsis.quantization, &cmsis.input,
+				    input, &cmsis.filter, conv->weights, &cmsis.bias, conv->bias,
+				    &cmsis.output, output) != ARM_CMSIS_NN_SUCCESS) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int tinycardia_aot_max_pool_s8(const struct tinycardia_aot_pool *pool, const int8_t *input,
+			       int8_t *output)
+{
+	cmsis_nn_context context = {.buf = NULL, .size = 0};
+	cmsis_nn_pool_params params = {
+		.stride = {.w = pool->stride_width, .h = pool->stride_height},
+		.padding = {.w = pool->padding_width, .h = pool->padding_height},
+		.activation = {.min = pool->activation_min, .max = pool->activation_max},
+	};
+	cmsis_nn_dims input_dims = {.n = 1, .h = pool->input_height, .w = pool->input_width,
+				    .c = pool->channels};
+	cmsis_nn_dims filter_dims = {.n = 1, .h = pool->filter_height, .w = pool->filter_width,
+				     .c = 1};
+	cmsis_nn_dims output_dims = {.n = 1, .h = pool->output_height, .w = pool->output_width,
+				     .c = pool->channels};
+
+	if (arm_max_pool_s8(&context, &params, &input_dims, input, &filter_dims, &output_dims,
+			    output) != ARM_CMSIS_NN_SUCCESS) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int tinycardia_aot_softmax_s8(const struct tinycardia_aot_softmax *softmax, const int8_t *input,
+			      int8_t *output)
+{
+	arm_softmax_s8(input, softmax->rows, softmax->row_size, softmax->input_multiplier,
+		       softmax->input_left_shift, softmax->diff_min, output);
+
+	return 0;
+}
+#else
+size_t tinycardia_aot_conv_scratch_size(const struct tinycardia_aot_conv *conv)
+{
+	(void)conv;
+
+	return 0U;
+}
+
+/* One output channel's accumulator at one position; padded input positions are skipped. */
+static int32_t conv_accumulate(const struct tinycardia_aot_conv *conv, const int8_t *input,
+			       int32_t origin_y, int32_t origin_x, int32_t channel)
+{
+	const int8_t *filter = &conv->weights[channel * conv->kernel_height * conv->kernel_width *
+					      conv->input_channels];
+	int32_t accumulator = 0;
+
+	for (int32_t kernel_y = 0; kernel_y < conv->kernel_height; ++kernel_y) {
+		int32_t in_y = origin_y + kernel_y;
+
+		if (in_y < 0 || in_y >= conv->input_height) {
+			continue;
+		}
+		for (int32_t kernel_x = 0; kernel_x < conv->kernel_width; ++kernel_x) {
+			int32_t in_x = origin_x + kernel_x;
+			const int8_t *values;
+			const int8_t *weights;
+
+			if (in_x < 0 || in_x >= conv->input_width) {
+				continue;
+			}
+			values = &input[(in_y * conv->input_width + in_x) *
+					conv->input_channels];
+			weights = &filter[(kernel_y * conv->kernel_width + kernel_x) *
+					  conv->input_channels];
+			for (int32_t index = 0; index < conv->input_channels; ++index) {
+				accumulator +=
+					weights[index] * (values[index] + conv->input_offset);
+			}
+		}
+	}
+
+	return accumulator + conv->bias[channel];
+}
+
+/* reference_integer_ops::ConvPerChannel(). */
+int tinycardia_aot_conv_s8(const struct tinycardia_aot_conv *conv, const int8_t *input,
+			   int8_t *output, void *scratch, size_t scratch_size)
+{
+	(void)scratch;
+	(void)scratch_size;
+
+	for (int32_t out_y = 0; out_y < conv->output_height; ++out_y) {
+		for (int32_t out_x = 0; out_x < conv->output_width; ++out_x) {
+			int32_t origin_y = out_y * conv->stride_height - conv->padding_height;
+			int32_t origin_x = out_x * conv->stride_width - conv->padding_width;
+
+			for (int32_t channel = 0; channel < conv->output_channels; ++channel) {
+				int32_t accumulator =
+					conv_accumulate(conv, input, origin_y, origin_x, channel);
+
+				*output++ = saturate(requantize(accumulator,
+								conv->multipliers[channel],
+								conv->shifts[channel]) +
+							     conv->output_offset,
+						     conv->activation_min, conv->activation_max);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* reference_integer_ops::MaxPool(). */
+int tinycardia_aot_max_pool_s8(const struct tinycardia_aot_pool *pool, const int8_t *input,
+			       int8_t *output)
+{
+	for (int32_t out_y = 0; out_y < pool->output_height; ++out_y) {
+		for (int32_t out_x = 0; out_x < pool->output_width; ++out_x) {
+			int32_t origin_y = out_y * pool->stride_height - pool->padding_height;
+			int32_t origin_x = out_x * pool->stride_width - pool->padding_width;
+
+			for (int32_t channel = 0; channel < pool->channels; ++channel) {
+				int32_t maximum = INT8_MIN;
+
+				for (int32_t filter_y = 0; filter_y < pool->filter_height;
+				     ++filter_y) {
+					int32_t in_y = origin_y + filter_y;
+
+					if (in_y < 0 || in_y >= pool->input_height) {
+						continue;
+					}
+					for (int32_t filter_x = 0; filter_x < pool->filter_width;
+					     ++filter_x) {
+						int32_t in_x = origin_x + filter_x;
+						int32_t value;
+
+						if (in_x < 0 || in_x >= pool->input_width) {
+							continue;
+						}
+						value = input[(in_y * pool->input_width + in_x) *
+								      pool->channels +
+							      channel];
+						if (value > maximum) {
+							maximum = value;
+						}
+					}
+				}
+				*output++ = saturate(maximum, pool->activation_min,
+						     pool->activation_max);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* gemmlowp::exp_on_negative_values() of a Q5.26 value, as Q0.31. */
+static int32_t exp_on_negative_values(int32_t value)
+{
+	static const int32_t barrel_multipliers[] = {
+		1672461947, 1302514674, 790015084, 290630308, 39332535, 720401, 242,
+	};
+	const int32_t quarter = 1 << 24;
+	const int32_t mod_quarter_minus_quarter = (value & (quarter - 1)) - quarter;
+	const int32_t remainder = mod_quarter_minus_quarter - value;
+	/* Taylor expansion of exp() around -1/8 for the remainder in [-1/4, 0). */
+	const int32_t x = mod_quarter_minus_quarter * 32 + (1 << 28);
+	const int32_t x2 = doubling_high_multiply(x, x);
+	const int32_t x3 = doubling_high_multiply(x2, x);
+	const int32_t x4_over_4 =
+		rounding_divide_by_power_of_two(doubling_high_multiply(x2, x2), 2);
+	const int32_t polynomial = rounding_divide_by_power_of_two(
+		doubling_high_multiply(x4_over_4 + x3, 715827883) + x2, 1);
+	int32_t result = 1895147668 + doubling_high_multiply(1895147668, x + polynomial);
+
+	for (size_t index = 0U; index < sizeof(barrel_multipliers) / sizeof(barrel_multipliers[0]);
+	     ++index) {
+		if ((remainder & (1 << (24 + index))) != 0) {
+			result = doubling_high_multiply(result, barrel_multipliers[index]);
+		}
+	}
+
+	return value == 0 ? INT32_MAX : result;
+}
+
+/* gemmlowp::one_over_one_plus_x_for_x_in_0_1() by Newton-Raphson, as Q0.31. */
+static int32_t one_over_one_plus_x(int32_t value)
+{
+	const int64_t sum = (int64_t)value + INT32_MAX;
+	const int32_t half_denominator = (int32_t)((sum + (sum >= 0 ? 1 : -1)) / 2);
+	int32_t x = 1515870810 + doubling_high_multiply(half_denominator, -1010580540);
+
+	for (int iteration = 0; iteration < 3; ++iteration) {
+		int32_t error = (1 << 29) - doubling_high_multiply(half_denominator, x);
+
+		x += saturating_multiply_by_power_of_two(doubling_high_multiply(x, error), 2);
+	}
+
+	return saturating_multiply_by_power_of_two(x, 1);
+}
+
+/* reference_ops::Softmax() for INT8 outputs quantized to 1/256 around -128. */
+int tinycardia_aot_softmax_s8(const struct tinycardia_aot_softmax *softmax, const int8_t *input,
+			      int8_t *output)
+{
+	for (int32_t row = 0; row < softmax->rows; ++row) {
+		const int8_t *values = &input[row * softmax->row_size];
+		int8_t *probabilities = &output[row * softmax->row_size];
+		int32_t maximum = INT8_MIN;
+		int32_t sum = 0;
+		int32_t headroom;
+		int32_t scale;
+		int32_t bits_over_unit;
+
+		for (int32_t index = 0; index < softmax->row_size; ++index) {
+			if (values[index] > maximum) {
+				maximum = values[index];
+			}
+		}
+		for (int32_t index = 0; index < softmax->row_size; ++index) {
+			int32_t difference = values[index] - maximum;
+
+			if (difference >= softmax->diff_min) {
+				sum += rounding_divide_by_power_of_two(
+					exp_on_negative_values(doubling_high_multiply(
+						difference * (1 << softmax->input_left_shift),
+						softmax->input_multiplier)),
+					SOFTMAX_ACCUMULATION_BITS);
+			}
+		}
+
+		headroom = __builtin_clz((uint32_t)sum);
+		scale = one_over_one_plus_x(
+			(int32_t)(((uint32_t)sum << headroom) - (UINT32_C(1) << 31)));
+		bits_over_unit = SOFTMAX_ACCUMULATION_BITS - headroom + 31 - 8;
+		for (int32_t index = 0; index < softmax->row_size; ++index) {
+			int32_t difference = values[index] - maximum;
+			int32_t exponential;
+
+			if (difference < softmax->diff_min) {
+				probabilities[index] = INT8_MIN;
+				continue;
+			}
+			exponential = exp_on_negative_values(doubling_high_multiply(
+				difference * (1 << softmax->input_left_shift),
+				softmax->input_multiplier));
+			probabilities[index] = saturate(
+				rounding_divide_by_power_of_two(
+					doubling_high_multiply(scale, exponential),
+					bits_over_unit) +
+					INT8_MIN,
+				INT8_MIN, INT8_MAX);
+		}
+	}
+
+	return 0;
+}
+#endif
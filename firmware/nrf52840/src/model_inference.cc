@@ -8,8 +8,10 @@
 #include <cstring>
 #include <new>
 
+#include <tensorflow/lite/micro/memory_helpers.h>
 #include <tensorflow/lite/micro/micro_interpreter.h>
 #include <tensorflow/lite/micro/micro_mutable_op_resolver.h>
+#include <tensorflow/lite/micro/micro_profiler_interface.h>
 #include <tensorflow/lite/schema/schema_generated.h>
 
 #include <zephyr/kernel.h>
@@ -24,11 +26,12 @@ namespace
 constexpr char kRrInputName[] = "serving_default_rr_features:0";
 constexpr char kEcgInputName[] = "serving_default_ecg_signal:0";
 constexpr char kOutputName[] = "StatefulPartitionedCall_1:0";
-constexpr size_t kExpectedOperatorInstances = 21U;
+constexpr size_t kExpectedOperatorInstances = TINYCARDIA_MODEL_OPERATOR_COUNT;
 constexpr size_t kOperatorTypeCount = 8U;
 constexpr float kScaleRelativeTolerance = 1.0e-5f;
 constexpr int8_t kZeroInputExpectedOutput[] = {-49, 49};
 constexpr int kSelfTestOutputTolerance = 1;
+constexpr uintptr_t kScratchAlignment = 16U;
 
 alignas(16) uint8_t tensor_arena[CONFIG_TINYCARDIA_MODEL_TENSOR_ARENA_SIZE];
 alignas(tflite::MicroInterpreter) uint8_t interpreter_storage[sizeof(tflite::MicroInterpreter)];
@@ -39,10 +42,81 @@ TfLiteTensor *rr_input;
 TfLiteTensor *ecg_input;
 TfLiteTensor *output;
 size_t arena_used_bytes;
+uint8_t *scratch;
+size_t scratch_size;
 bool initialized;
 
 tflite::MicroMutableOpResolver<kOperatorTypeCount> resolver;
 
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+/*
+ * The interpreter reports one event per operator, in graph order, around each
+ * kernel's Invoke. Events are timed while an inference is recorded and only
+ * added to the totals when the invocation produced exactly one per operator.
+ */
+class OperatorProfiler : public tflite::MicroProfilerInterface
+{
+public:
+	uint32_t BeginEvent(const char *tag) override
+	{
+		uint32_t handle = event_count_++;
+
+		ARG_UNUSED(tag);
+		if (recording_ && handle < kExpectedOperatorInstances) {
+			start_cycles_[handle] = k_cycle_get_32();
+		}
+		return handle;
+	}
+
+	void EndEvent(uint32_t event_handle) override
+	{
+		uint32_t end_cycles = k_cycle_get_32();
+
+		if (recording_ && event_handle < kExpectedOperatorInstances) {
+			elapsed_cycles_[event_handle] = end_cycles - start_cycles_[event_handle];
+		}
+	}
+
+	void StartInvocation()
+	{
+		event_count_ = 0U;
+		recording_ = true;
+	}
+
+	bool FinishInvocation()
+	{
+		recording_ = false;
+		if (event_count_ != kExpectedOperatorInstances) {
+			return false;
+		}
+		for (size_t index = 0U; index < kExpectedOperatorInstances; ++index) {
+			profile_.operators[index].cycles += elapsed_cycles_[index];
+		}
+		++profile_.invocations;
+		return true;
+	}
+
+	void SetOperatorName(size_t index, const char *name)
+	{
+		profile_.operators[index].name = name;
+	}
+
+	const tinycardia_model_profile &profile() const
+	{
+		return profile_;
+	}
+
+private:
+	tinycardia_model_profile profile_ = {};
+	uint32_t start_cycles_[kExpectedOperatorInstances] = {};
+	uint32_t elapsed_cycles_[kExpectedOperatorInstances] = {};
+	uint32_t event_count_ = 0U;
+	bool recording_ = false;
+};
+
+OperatorProfiler operator_profiler;
+#endif
+
 bool scale_matches(float actual, float expected)
 {
 	return std::fabs(actual - expected) <= std::fabs(expected) * kScaleRelativeTolerance;
@@ -277,6 +351,123 @@ int run_startup_self_test(void)
 	return 0;
 }
 
+struct arena_range {
+	uintptr_t start;
+	uintptr_t end;
+};
+
+arena_range tensor_range(const TfLiteTensor *tensor)
+{
+	uintptr_t start = reinterpret_cast<uintptr_t>(tensor->data.raw);
+
+	return {start, start + tensor->bytes};
+}
+
+/*
+ * Every non-constant tensor buffer lies in the arena's non-persistent head,
+ * which the planner reuses within each Invoke(). Between inferences only the
+ * two input tensors hold data there, so keep the largest aligned gap around
+ * them, below the end of the highest tensor buffer, as preprocessing scratch.
+ * Operator scratch buffers are also only live within Invoke().
+ */
+void find_activation_scratch(void)
+{
+	const uintptr_t arena_start = reinterpret_cast<uintptr_t>(tensor_arena);
+	const uintptr_t arena_end = arena_start + sizeof(tensor_arena);
+	const size_t tensor_count = model->subgraphs()->Get(0)->tensors()->size();
+	arena_range live[] = {tensor_range(ecg_input), tensor_range(rr_input)};
+	uintptr_t head_end = arena_start;
+	uintptr_t gap_start = arena_start;
+
+	for (size_t index = 0U; index < tensor_count; ++index) {
+		const TfLiteEvalTensor *tensor = interpreter->GetTensor(static_cast<int>(index));
+		uintptr_t start;
+		size_t bytes;
+
+		if (tensor == nullptr || tensor->data.data == nullptr ||
+		    tflite::TfLiteEvalTensorByteLength(tensor, &bytes) != kTfLiteOk) {
+			continue;
+		}
+		start = reinterpret_cast<uintptr_t>(tensor->data.data);
+		/* Weights and biases stay in the flash FlatBuffer. */
+		if (start >= arena_start && start < arena_end && start + bytes > head_end) {
+			head_end = start + bytes;
+		}
+	}
+
+	if (live[1].start < live[0].start) {
+		arena_range first = live[1];
+
+		live[1] = live[0];
+		live[0] = first;
+	}
+	scratch = nullptr;
+	scratch_size = 0U;
+	for (size_t index = 0U; index <= ARRAY_SIZE(live); ++index) {
+		uintptr_t gap_end = index < ARRAY_SIZE(live) ? live[index].start : head_end;
+		uintptr_t aligned_start = ROUND_UP(gap_start, kScratchAlignment);
+
+		if (gap_end > aligned_start && gap_end - aligned_start > scratch_size) {
+			scratch = reinterpret_cast<uint8_t *>(aligned_start);
+			scratch_size = gap_end - aligned_start;
+		}
+		if (index < ARRAY_SIZE(live) && live[index].end > gap_start) {
+			gap_start = live[index].end;
+		}
+	}
+}
+
+tflite::MicroProfilerInterface *interpreter_profiler(void)
+{
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	return &operator_profiler;
+#else
+	return nullptr;
+#endif
+}
+
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+void name_profiled_operators(void)
+{
+	const auto *operators = model->subgraphs()->Get(0)->operators();
+	const auto *operator_codes = model->operator_codes();
+
+	for (size_t index = 0U; index < kExpectedOperatorInstances; ++index) {
+		const auto *code = operator_codes->Get(operators->Get(index)->opcode_index());
+
+		operator_profiler.SetOperatorName(
+			index, tflite::EnumNameBuiltinOperator(code->builtin_code()));
+	}
+}
+
+void log_profile(const tinycardia_model_profile &profile)
+{
+	uint64_t total_cycles = 0U;
+
+	for (const auto &op : profile.operators) {
+		total_cycles += op.cycles;
+	}
+	if (profile.invocations == 0U || total_cycles == 0U) {
+		return;
+	}
+
+	LOG_INF("Model profile over %u inferences: %u us per Invoke()",
+		static_cast<unsigned int>(profile.invocations),
+		static_cast<unsigned int>(
+			k_cyc_to_us_floor64(total_cycles / profile.invocations)));
+	for (size_t index = 0U; index < kExpectedOperatorInstances; ++index) {
+		const auto &op = profile.operators[index];
+		uint64_t permille = (op.cycles * 1000U) / total_cycles;
+
+		LOG_INF("  op %2u %-16s %7u us %3u.%u%%", static_cast<unsigned int>(index),
+			op.name, static_cast<unsigned int>(
+					 k_cyc_to_us_floor64(op.cycles / profile.invocations)),
+			static_cast<unsigned int>(permille / 10U),
+			static_cast<unsigned int>(permille % 10U));
+	}
+}
+#endif
+
 uint16_t probability_to_confidence(float probability)
 {
 	long confidence;
@@ -323,7 +514,8 @@ extern "C" int tinycardia_model_init(void)
 	}
 
 	interpreter = new (interpreter_storage)
-		tflite::MicroInterpreter(model, resolver, tensor_arena, sizeof(tensor_arena));
+		tflite::MicroInterpreter(model, resolver, tensor_arena, sizeof(tensor_arena),
+					 nullptr, interpreter_profiler());
 	if (interpreter->AllocateTensors() != kTfLiteOk) {
 		LOG_ERR("TFLM tensor allocation failed with %u-byte arena",
 			static_cast<unsigned int>(sizeof(tensor_arena)));
@@ -341,18 +533,63 @@ extern "C" int tinycardia_model_init(void)
 	}
 
 	arena_used_bytes = interpreter->arena_used_bytes();
+	find_activation_scratch();
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	name_profiled_operators();
+#endif
 	initialized = true;
-	LOG_INF("AFib model ready: %u-byte artifact, arena %u/%u bytes, CMSIS-NN %s",
+	LOG_INF("AFib model ready: %u-byte artifact, arena %u/%u bytes, %u scratch, CMSIS-NN %s",
 		static_cast<unsigned int>(tinycardia_model_data_size),
 		static_cast<unsigned int>(arena_used_bytes),
 		static_cast<unsigned int>(sizeof(tensor_arena)),
+		static_cast<unsigned int>(scratch_size),
 		IS_ENABLED(CONFIG_TENSORFLOW_LITE_MICRO_CMSIS_NN_KERNELS) ? "enabled" : "disabled");
 
 	return 0;
 }
 
+extern "C" int8_t *tinycardia_model_ecg_input(void)
+{
+	if (!initialized || interpreter == nullptr) {
+		return nullptr;
+	}
+
+	return ecg_input->data.int8;
+}
+
+extern "C" void *tinycardia_model_scratch(size_t *size)
+{
+	if (size == nullptr || !initialized || interpreter == nullptr) {
+		return nullptr;
+	}
+
+	*size = scratch_size;
+	return scratch;
+}
+
 extern "C" int tinycardia_model_infer(const float *ecg, size_t ecg_count, const float *rr_features,
 				      size_t rr_count, struct tinycardia_model_result *result)
+{
+	if (!initialized || interpreter == nullptr) {
+		return -EACCES;
+	}
+	if (ecg == nullptr || rr_features == nullptr || result == nullptr) {
+		return -EINVAL;
+	}
+	if (ecg_count != TINYCARDIA_MODEL_ECG_COUNT || rr_count != TINYCARDIA_MODEL_RR_COUNT) {
+		return -EMSGSIZE;
+	}
+
+	for (size_t index = 0U; index < ecg_count; ++index) {
+		ecg_input->data.int8[index] = tinycardia_model_quantize(
+			ecg[index], TINYCARDIA_MODEL_ECG_SCALE, TINYCARDIA_MODEL_ECG_ZERO_POINT);
+	}
+
+	return tinycardia_model_infer_quantized(rr_features, rr_count, result);
+}
+
+extern "C" int tinycardia_model_infer_quantized(const float *rr_features, size_t rr_count,
+						struct tinycardia_model_result *result)
 {
 	uint64_t start_cycles;
 	uint64_t elapsed_cycles;
@@ -362,10 +599,10 @@ extern "C" int tinycardia_model_infer(const float *ecg, size_t ecg_count, const
 	if (!initialized || interpreter == nullptr) {
 		return -EACCES;
 	}
-	if (ecg == nullptr || rr_features == nullptr || result == nullptr) {
+	if (rr_features == nullptr || result == nullptr) {
 		return -EINVAL;
 	}
-	if (ecg_count != TINYCARDIA_MODEL_ECG_COUNT || rr_count != TINYCARDIA_MODEL_RR_COUNT) {
+	if (rr_count != TINYCARDIA_MODEL_RR_COUNT) {
 		return -EMSGSIZE;
 	}
 
@@ -374,17 +611,29 @@ extern "C" int tinycardia_model_infer(const float *ecg, size_t ecg_count, const
 			tinycardia_model_quantize(rr_features[index], TINYCARDIA_MODEL_RR_SCALE,
 						  TINYCARDIA_MODEL_RR_ZERO_POINT);
 	}
-	for (size_t index = 0U; index < ecg_count; ++index) {
-		ecg_input->data.int8[index] = tinycardia_model_quantize(
-			ecg[index], TINYCARDIA_MODEL_ECG_SCALE, TINYCARDIA_MODEL_ECG_ZERO_POINT);
-	}
 
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	operator_profiler.StartInvocation();
+#endif
 	start_cycles = k_cycle_get_64();
 	if (interpreter->Invoke() != kTfLiteOk) {
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+		(void)operator_profiler.FinishInvocation();
+#endif
 		LOG_ERR("TFLM Invoke() failed");
 		return -EIO;
 	}
 	elapsed_cycles = k_cycle_get_64() - start_cycles;
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	if (!operator_profiler.FinishInvocation()) {
+		LOG_WRN("Model profile skipped an Invoke() without one event per operator");
+	} else if (CONFIG_TINYCARDIA_MODEL_PROFILE_LOG_INTERVAL > 0 &&
+		   operator_profiler.profile().invocations %
+				   CONFIG_TINYCARDIA_MODEL_PROFILE_LOG_INTERVAL ==
+			   0U) {
+		log_profile(operator_profiler.profile());
+	}
+#endif
 
 	result->quantized_probabilities[0] = output->data.int8[0];
 	result->quantized_probabilities[1] = output->data.int8[1];
@@ -402,6 +651,57 @@ extern "C" int tinycardia_model_infer(const float *ecg, size_t ecg_count, const
 	return 0;
 }
 
+extern "C" int tinycardia_model_get_profile(struct tinycardia_model_profile *profile)
+{
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	if (profile == nullptr) {
+		return -EINVAL;
+	}
+	if (!initialized || interpreter == nullptr) {
+		return -EACCES;
+	}
+
+	*profile = operator_profiler.profile();
+	profile->cycles_per_second = static_cast<uint32_t>(sys_clock_hw_cycles_per_sec());
+	return 0;
+#else
+	ARG_UNUSED(profile);
+
+	return -ENOTSUP;
+#endif
+}
+
+/* The interpreter only runs the whole graph, so streaming needs the ahead-of-time engine. */
+extern "C" int tinycardia_model_stream_append(const int8_t *ecg, size_t offset, size_t count)
+{
+	ARG_UNUSED(ecg);
+	ARG_UNUSED(offset);
+	ARG_UNUSED(count);
+
+	return -ENOTSUP;
+}
+
+extern "C" int tinycardia_model_stream_finish(const float *rr_features, size_t rr_count,
+					      struct tinycardia_model_result *result)
+{
+	ARG_UNUSED(rr_features);
+	ARG_UNUSED(rr_count);
+	ARG_UNUSED(result);
+
+	return -ENOTSUP;
+}
+
+extern "C" int tinycardia_model_infer_window(uint32_t start_sample, const float *rr_features,
+					     size_t rr_count, struct tinycardia_model_result *result)
+{
+	ARG_UNUSED(start_sample);
+	ARG_UNUSED(rr_features);
+	ARG_UNUSED(rr_count);
+	ARG_UNUSED(result);
+
+	return -ENOTSUP;
+}
+
 extern "C" size_t tinycardia_model_arena_used_bytes(void)
 {
 	return arena_used_bytes;
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+
+#include "model_inference.h"
+
+#include <stdint.h>
+
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+static int cmd_model_profile(const struct shell *sh, size_t argc, char **argv)
+{
+	/* Kept off the shell thread's stack. */
+	static struct tinycardia_model_profile profile;
+	uint64_t total_cycles = 0U;
+	uint64_t cycles_per_us;
+	int err;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	/* The ECG thread may add an inference during the copy; totals can be one apart. */
+	err = tinycardia_model_get_profile(&profile);
+	if (err < 0) {
+		shell_error(sh, "Model profile unavailable: %d", err);
+		return err;
+	}
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		total_cycles += profile.operators[index].cycles;
+	}
+	if (profile.invocations == 0U || total_cycles == 0U) {
+		shell_print(sh, "No profiled inferences yet");
+		return 0;
+	}
+
+	cycles_per_us = MAX(profile.cycles_per_second / 1000000U, 1U);
+	shell_print(sh, "Model profile over %u inferences: %u us per invoke",
+		    (unsigned int)profile.invocations,
+		    (unsigned int)(total_cycles / profile.invocations / cycles_per_us));
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		const struct tinycardia_model_operator_profile *op = &profile.operators[index];
+		uint64_t permille = (op->cycles * 1000U) / total_cycles;
+
+		shell_print(sh, "  op %2u %-16s %7u us %3u.%u%%", (unsigned int)index, op->name,
+			    (unsigned int)(op->cycles / profile.invocations / cycles_per_us),
+			    (unsigned int)(permille / 10U), (unsigned int)(permille % 10U));
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(model_commands,
+	SHELL_CMD_ARG(profile, NULL, "Print the per-operator inference profile",
+		      cmd_model_profile, 1, 0),
+	SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(model, &model_commands, "AFib model diagnostics", NULL);
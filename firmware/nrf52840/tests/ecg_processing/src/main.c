@@ -1,10 +1,13 @@
 // SPDX-License-Identifier: MIT
 
 #include "ecg_processing.h"
+#include "model_contract.h"
 
 #include <errno.h>
 #include <math.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <zephyr/ztest.h>
 
@@ -14,6 +17,13 @@
 #define FLOAT_TOLERANCE       1.0e-4f
 #define LARGE_FLOAT_TOLERANCE 2.0e-2f
 
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+/* Q15 rounding of the fixture may move a quantized value by one step. */
+#define QUANTIZED_TOLERANCE 1
+#else
+#define QUANTIZED_TOLERANCE 0
+#endif
+
 struct guarded_window {
 	uint32_t before;
 	struct ecg_sample_window window;
@@ -21,7 +31,9 @@ struct guarded_window {
 };
 
 static struct guarded_window guarded_window;
+#if !defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
 static struct ecg_processing_workspace workspace;
+#endif
 static struct ecg_processing_result processing_result;
 
 static void assert_float_array(const float *actual, const float *expected, size_t count,
@@ -73,6 +85,24 @@ ZTEST(ecg_decode, test_fifo_tag_bits_do_not_change_sample)
 	}
 }
 
+ZTEST(ecg_decode, test_fast_recovery_tags_are_recognized)
+{
+	/* ETAG (bits 5:3): valid, fast, valid last, fast last, empty, overflow. */
+	static const struct {
+		uint32_t tag;
+		bool fast_recovery;
+	} vectors[] = {
+		{ 0x00U, false }, { 0x08U, true }, { 0x10U, false },
+		{ 0x18U, true },  { 0x30U, false }, { 0x38U, false },
+	};
+
+	for (size_t index = 0; index < ARRAY_SIZE(vectors); ++index) {
+		zassert_equal(ecg_sample_is_fast_recovery(0x48d140U | vectors[index].tag),
+			      vectors[index].fast_recovery, "tag vector %u misclassified",
+			      (unsigned int)index);
+	}
+}
+
 ZTEST(ecg_decode, test_counts_to_millivolts_conversion)
 {
 	zassert_within(ecg_decode_sample_mv(0x000040U), 0.0002479553f, 1.0e-9f);
@@ -80,20 +110,45 @@ ZTEST(ecg_decode, test_counts_to_millivolts_conversion)
 	zassert_within(ecg_decode_sample_mv(0x800000U), -32.5f, FLOAT_TOLERANCE);
 }
 
+ZTEST(ecg_decode, test_samples_decode_to_the_configured_type)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+	/* Q15 drops the two least significant bits and keeps the full input range. */
+	zassert_equal(ecg_decode_sample(0x0000c0U), 0);
+	zassert_equal(ecg_decode_sample(0x000100U), 1);
+	zassert_equal(ecg_decode_sample(0x7fffc0U), INT16_MAX);
+	zassert_equal(ecg_decode_sample(0x800000U), INT16_MIN);
+	zassert_equal(ecg_decode_sample(0xffffc0U), -1);
+#else
+	zassert_equal(ecg_decode_sample(0x7fffc0U), ecg_decode_sample_mv(0x7fffc0U));
+	zassert_equal(ecg_decode_sample(0x800000U), ecg_decode_sample_mv(0x800000U));
+#endif
+}
+
 ZTEST(ecg_window, test_partial_window_preserves_exact_sequence)
 {
 	reset_guarded_window();
 
 	for (size_t index = 0; index < 17U; ++index) {
-		zassert_equal(ecg_sample_window_append(&guarded_window.window, (float)index),
+		zassert_equal(ecg_sample_window_append(&guarded_window.window, (ecg_sample_t)index),
 			      ECG_WINDOW_SAMPLE_STORED);
 	}
 
 	zassert_equal(guarded_window.window.count, 17U);
 	for (size_t index = 0; index < guarded_window.window.count; ++index) {
-		zassert_equal(guarded_window.window.samples[index], (float)index,
+		zassert_equal(guarded_window.window.samples[index], (ecg_sample_t)index,
 			      "partial window mismatch at %u", (unsigned int)index);
 	}
+
+	/* Mean and squared deviations of 0..16 are kept as the samples arrive. */
+	zassert_equal(guarded_window.window.stats.count, 17U);
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	zassert_equal(guarded_window.window.stats.sum, 136);
+	zassert_equal(guarded_window.window.stats.sum_squares, 1496U);
+#else
+	zassert_within(guarded_window.window.stats.mean, 8.0f, FLOAT_TOLERANCE);
+	zassert_within(guarded_window.window.stats.m2, 408.0f, FLOAT_TOLERANCE);
+#endif
 	zassert_equal(guarded_window.before, CANARY_BEFORE);
 	zassert_equal(guarded_window.after, CANARY_AFTER);
 }
@@ -107,21 +162,21 @@ ZTEST(ecg_window, test_exact_completion_rejects_out_of_bounds_append)
 			index == ECG_PROCESSOR_WINDOW_SIZE - 1U ? ECG_WINDOW_COMPLETED
 							       : ECG_WINDOW_SAMPLE_STORED;
 
-		zassert_equal(ecg_sample_window_append(&guarded_window.window, (float)index),
+		zassert_equal(ecg_sample_window_append(&guarded_window.window, (ecg_sample_t)index),
 			      expected, "completion state mismatch at %u", (unsigned int)index);
 	}
 
 	zassert_equal(guarded_window.window.count, ECG_PROCESSOR_WINDOW_SIZE);
 	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		zassert_equal(guarded_window.window.samples[index], (float)index,
+		zassert_equal(guarded_window.window.samples[index], (ecg_sample_t)index,
 			      "sample skipped or duplicated at %u", (unsigned int)index);
 	}
 
-	zassert_equal(ecg_sample_window_append(&guarded_window.window, 12345.0f),
+	zassert_equal(ecg_sample_window_append(&guarded_window.window, (ecg_sample_t)12345),
 		      ECG_WINDOW_ALREADY_FULL);
 	zassert_equal(guarded_window.window.count, ECG_PROCESSOR_WINDOW_SIZE);
 	zassert_equal(guarded_window.window.samples[ECG_PROCESSOR_WINDOW_SIZE - 1U],
-		      (float)(ECG_PROCESSOR_WINDOW_SIZE - 1U));
+		      (ecg_sample_t)(ECG_PROCESSOR_WINDOW_SIZE - 1U));
 	zassert_equal(guarded_window.before, CANARY_BEFORE);
 	zassert_equal(guarded_window.after, CANARY_AFTER);
 }
@@ -131,13 +186,14 @@ ZTEST(ecg_window, test_reset_produces_non_overlapping_consecutive_window)
 	reset_guarded_window();
 
 	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		(void)ecg_sample_window_append(&guarded_window.window, (float)index);
+		(void)ecg_sample_window_append(&guarded_window.window, (ecg_sample_t)index);
 	}
 	ecg_sample_window_reset(&guarded_window.window);
 	zassert_equal(guarded_window.window.count, 0U);
+	zassert_equal(guarded_window.window.stats.count, 0U);
 
 	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		float second_window_sample = 10000.0f + (float)index;
+		ecg_sample_t second_window_sample = (ecg_sample_t)(10000U + index);
 		enum ecg_window_append_result expected =
 			index == ECG_PROCESSOR_WINDOW_SIZE - 1U ? ECG_WINDOW_COMPLETED
 							       : ECG_WINDOW_SAMPLE_STORED;
@@ -148,7 +204,7 @@ ZTEST(ecg_window, test_reset_produces_non_overlapping_consecutive_window)
 	}
 
 	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
-		zassert_equal(guarded_window.window.samples[index], 10000.0f + (float)index,
+		zassert_equal(guarded_window.window.samples[index], (ecg_sample_t)(10000U + index),
 			      "stale or overlapping sample at %u", (unsigned int)index);
 	}
 	zassert_equal(guarded_window.before, CANARY_BEFORE);
@@ -206,6 +262,40 @@ ZTEST(ecg_rr, test_insufficient_peaks_report_unavailable_features)
 			   ECG_PROCESSOR_RR_FEATURE_COUNT, 0.0f);
 }
 
+ZTEST(ecg_rr, test_hardware_intervals_match_peak_derived_features)
+{
+	static const size_t peaks[] = { 0U, 256U, 512U, 896U };
+	static const float hardware_intervals[] = { 1000.0f, 1000.0f, 1500.0f };
+	static const float invalid_intervals[] = { 1000.0f, 0.0f, 1500.0f };
+	float too_many_intervals[ECG_PROCESSING_MAX_R_PEAKS];
+	struct ecg_rr_result from_peaks;
+	struct ecg_rr_result from_intervals;
+
+	zassert_ok(ecg_extract_rr_features(peaks, ARRAY_SIZE(peaks), &from_peaks));
+	zassert_ok(ecg_extract_rr_features_from_intervals(
+		hardware_intervals, ARRAY_SIZE(hardware_intervals), &from_intervals));
+	zassert_true(from_intervals.features_valid);
+	zassert_equal(from_intervals.interval_count, from_peaks.interval_count);
+	assert_float_array(from_intervals.features_unscaled, from_peaks.features_unscaled,
+			   ECG_PROCESSOR_RR_FEATURE_COUNT, 0.0f);
+	assert_float_array(from_intervals.features_standardized,
+			   from_peaks.features_standardized, ECG_PROCESSOR_RR_FEATURE_COUNT,
+			   0.0f);
+
+	zassert_ok(ecg_extract_rr_features_from_intervals(hardware_intervals, 1U,
+							  &from_intervals));
+	zassert_false(from_intervals.features_valid);
+	zassert_equal(ecg_extract_rr_features_from_intervals(
+			      invalid_intervals, ARRAY_SIZE(invalid_intervals), &from_intervals),
+		      -EINVAL);
+	for (size_t index = 0; index < ARRAY_SIZE(too_many_intervals); ++index) {
+		too_many_intervals[index] = 1000.0f;
+	}
+	zassert_equal(ecg_extract_rr_features_from_intervals(
+			      too_many_intervals, ARRAY_SIZE(too_many_intervals), &from_intervals),
+		      -E2BIG);
+}
+
 ZTEST(ecg_rr, test_boundary_intervals_and_invalid_peak_lists)
 {
 	static const size_t boundary_peaks[] = { 0U, 1U, 2559U };
@@ -240,18 +330,70 @@ ZTEST(ecg_rr, test_boundary_intervals_and_invalid_peak_lists)
 		      -E2BIG);
 }
 
-ZTEST(ecg_regression, test_deterministic_ecg_golden_model_inputs)
+static const size_t fixture_centers[] = {
+	128U, 384U, 640U, 896U, 1152U, 1408U, 1664U, 1920U, 2176U, 2432U,
+};
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+/* The adaptive detector reports the centre of each pulse. */
+static const size_t fixture_expected_peaks[] = {
+	128U, 384U, 640U, 896U, 1152U, 1408U, 1664U, 1920U, 2176U, 2432U,
+};
+#else
+/* The training detector reports the first threshold crossing of each pulse. */
+static const size_t fixture_expected_peaks[] = {
+	109U, 365U, 621U, 877U, 1133U, 1389U, 1645U, 1901U, 2157U, 2413U,
+};
+#endif
+static const float fixture_shape[] = { 0.25f, 0.75f, 1.0f, 0.75f, 0.25f };
+
+/* One sample of the golden fixture: isolated triangular pulses at 60 bpm. */
+static float fixture_sample(size_t sample_index)
+{
+	for (size_t beat = 0; beat < ARRAY_SIZE(fixture_centers); ++beat) {
+		size_t shape_start = fixture_centers[beat] - 2U;
+
+		if (sample_index >= shape_start &&
+		    sample_index < shape_start + ARRAY_SIZE(fixture_shape)) {
+			return fixture_shape[sample_index - shape_start];
+		}
+	}
+
+	return 0.0f;
+}
+
+/* Fixture millivolts as the configured sample type: Q15 counts in fixed point. */
+static ecg_sample_t fixture_input(float millivolts)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+	return (ecg_sample_t)lroundf(millivolts * 32768.0f / 32.5f);
+#else
+	return millivolts;
+#endif
+}
+
+/* The golden standardized model input for one fixture sample. */
+static float fixture_standardized_sample(size_t sample_index)
 {
-	static const size_t fixture_centers[] = {
-		128U, 384U, 640U, 896U, 1152U, 1408U, 1664U, 1920U, 2176U, 2432U,
-	};
-	static const size_t expected_peaks[] = {
-		109U, 365U, 621U, 877U, 1133U, 1389U, 1645U, 1901U, 2157U, 2413U,
-	};
-	static const float fixture_shape[] = { 0.25f, 0.75f, 1.0f, 0.75f, 0.25f };
 	static const float expected_shape_standardized[] = {
 		2.56175921f, 7.93725393f, 10.62500130f, 7.93725393f, 2.56175921f,
 	};
+	const float expected_baseline_standardized = -0.12598816f;
+
+	for (size_t beat = 0; beat < ARRAY_SIZE(fixture_centers); ++beat) {
+		size_t shape_start = fixture_centers[beat] - 2U;
+
+		if (sample_index >= shape_start &&
+		    sample_index < shape_start + ARRAY_SIZE(fixture_shape)) {
+			return expected_shape_standardized[sample_index - shape_start];
+		}
+	}
+
+	return expected_baseline_standardized;
+}
+
+#if !defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+ZTEST(ecg_regression, test_deterministic_ecg_golden_model_inputs)
+{
 	static const float expected_features[] = {
 		1000.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
 	};
@@ -259,35 +401,25 @@ ZTEST(ecg_regression, test_deterministic_ecg_golden_model_inputs)
 		0.26184893f, -0.72462300f, -0.69026889f, -0.91497965f,
 		-1.46363233f, -0.81666524f, -0.62238771f,
 	};
-	const float expected_baseline_standardized = -0.12598816f;
 
 	reset_guarded_window();
 	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
 	     ++sample_index) {
-		float sample = 0.0f;
-
-		for (size_t beat = 0; beat < ARRAY_SIZE(fixture_centers); ++beat) {
-			size_t shape_start = fixture_centers[beat] - 2U;
-
-			if (sample_index >= shape_start &&
-			    sample_index < shape_start + ARRAY_SIZE(fixture_shape)) {
-				sample = fixture_shape[sample_index - shape_start];
-				break;
-			}
-		}
-		(void)ecg_sample_window_append(&guarded_window.window, sample);
+		(void)ecg_sample_window_append(&guarded_window.window,
+					       fixture_sample(sample_index));
 	}
 
 	zassert_ok(ecg_prepare_model_inputs(&guarded_window.window, &workspace,
 					    &processing_result));
-	zassert_equal(processing_result.r_peak_count, ARRAY_SIZE(expected_peaks));
-	for (size_t index = 0; index < ARRAY_SIZE(expected_peaks); ++index) {
-		zassert_equal(workspace.r_peak_indices[index], expected_peaks[index],
+	zassert_equal(processing_result.r_peak_count, ARRAY_SIZE(fixture_expected_peaks));
+	for (size_t index = 0; index < ARRAY_SIZE(fixture_expected_peaks); ++index) {
+		zassert_equal(workspace.r_peak_indices[index], fixture_expected_peaks[index],
 			      "golden peak mismatch at %u", (unsigned int)index);
 	}
 
 	zassert_true(processing_result.rr.features_valid);
-	zassert_equal(processing_result.rr.interval_count, ARRAY_SIZE(expected_peaks) - 1U);
+	zassert_equal(processing_result.rr.interval_count,
+		      ARRAY_SIZE(fixture_expected_peaks) - 1U);
 	for (size_t index = 0; index < processing_result.rr.interval_count; ++index) {
 		zassert_equal(processing_result.rr.intervals_ms[index], 1000.0f,
 			      "golden RR mismatch at %u", (unsigned int)index);
@@ -300,25 +432,522 @@ ZTEST(ecg_regression, test_deterministic_ecg_golden_model_inputs)
 
 	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
 	     ++sample_index) {
-		float expected = expected_baseline_standardized;
+		zassert_within(guarded_window.window.samples[sample_index],
+			       fixture_standardized_sample(sample_index), FLOAT_TOLERANCE,
+			       "golden ECG model input mismatch at %u", (unsigned int)sample_index);
+	}
+	zassert_equal(guarded_window.before, CANARY_BEFORE);
+	zassert_equal(guarded_window.after, CANARY_AFTER);
+}
 
-		for (size_t beat = 0; beat < ARRAY_SIZE(fixture_centers); ++beat) {
-			size_t shape_start = fixture_centers[beat] - 2U;
+ZTEST(ecg_regression, test_one_pass_standardization_removes_offset_and_gain)
+{
+	/* An electrode offset and front-end gain must not change the model input. */
+	reset_guarded_window();
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		(void)ecg_sample_window_append(&guarded_window.window,
+					       1.5f + 3.2f * fixture_sample(sample_index));
+	}
+	zassert_equal(guarded_window.window.stats.count, ECG_PROCESSOR_WINDOW_SIZE);
 
-			if (sample_index >= shape_start &&
-			    sample_index < shape_start + ARRAY_SIZE(fixture_shape)) {
-				expected = expected_shape_standardized[sample_index - shape_start];
-				break;
-			}
+	zassert_ok(ecg_prepare_model_inputs(&guarded_window.window, &workspace,
+					    &processing_result));
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		zassert_within(guarded_window.window.samples[sample_index],
+			       fixture_standardized_sample(sample_index), FLOAT_TOLERANCE,
+			       "offset ECG model input mismatch at %u", (unsigned int)sample_index);
+	}
+	zassert_equal(processing_result.r_peak_count, ARRAY_SIZE(fixture_expected_peaks));
+	zassert_equal(guarded_window.before, CANARY_BEFORE);
+	zassert_equal(guarded_window.after, CANARY_AFTER);
+}
+#endif
+
+ZTEST(ecg_regression, test_streaming_detector_matches_whole_window_peaks)
+{
+	static struct ecg_qrs_detector detector;
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t peak_count;
+
+	/* Raw, unstandardized millivolts with an offset, fed one sample at a time. */
+	ecg_qrs_detector_reset(&detector);
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		zassert_equal(ecg_qrs_detector_finish(&detector, peaks, ARRAY_SIZE(peaks)), 0U,
+			      "an incomplete window has no peaks");
+		ecg_qrs_detector_append(&detector,
+					fixture_input(1.5f + 3.2f * fixture_sample(sample_index)));
+	}
+
+	/* Integration kept pace with capture; only the right half-window is left. */
+	zassert_equal(detector.integrated_count,
+		      ECG_PROCESSOR_WINDOW_SIZE - (ECG_QRS_INTEGRATION_WINDOW_SAMPLES - 1U) / 2U);
+	peak_count = ecg_qrs_detector_finish(&detector, peaks, ARRAY_SIZE(peaks));
+	zassert_equal(peak_count, ARRAY_SIZE(fixture_expected_peaks));
+	for (size_t index = 0; index < peak_count; ++index) {
+		zassert_equal(peaks[index], fixture_expected_peaks[index],
+			      "streamed peak mismatch at %u", (unsigned int)index);
+	}
+
+	/* Samples past the window are ignored rather than overrunning it. */
+	ecg_qrs_detector_append(&detector, 0.0f);
+	zassert_equal(detector.sample_count, ECG_PROCESSOR_WINDOW_SIZE);
+}
+
+#if !defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+/* Fixture pulses at the given centers and amplitudes, optionally with a slow T wave. */
+static float pulse_train_sample(const size_t *centers, const float *amplitudes,
+				size_t beat_count, float t_wave_slope, size_t sample_index)
+{
+	/* The T wave rises for 20 samples from 48 samples (188 ms) after the R peak. */
+	const size_t t_wave_offset = 48U;
+	const size_t t_wave_half_width = 20U;
+	float value = 0.0f;
+
+	for (size_t beat = 0; beat < beat_count; ++beat) {
+		size_t shape_start = centers[beat] - 2U;
+		size_t t_wave_start = centers[beat] + t_wave_offset;
+
+		if (sample_index >= shape_start &&
+		    sample_index < shape_start + ARRAY_SIZE(fixture_shape)) {
+			value += amplitudes[beat] * fixture_shape[sample_index - shape_start];
+		}
+		if (sample_index >= t_wave_start &&
+		    sample_index < t_wave_start + 2U * t_wave_half_width) {
+			size_t offset = sample_index - t_wave_start;
+			size_t height = offset < t_wave_half_width ? offset + 1U
+								  : 2U * t_wave_half_width - offset;
+
+			value += t_wave_slope * (float)height;
+		}
+	}
+
+	return value;
+}
+
+ZTEST(ecg_regression, test_qrs_filter_removes_baseline_wander_across_windows)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+	/* The band-pass delays the centre of each pulse by a constant five samples. */
+	const size_t filter_delay_samples = 5U;
+#else
+	/* The band-pass delays each threshold crossing by a constant six samples. */
+	const size_t filter_delay_samples = 6U;
+#endif
+	const float wander_step = 2.0f * 3.14159265f * 0.3f / (float)ECG_PROCESSOR_SAMPLE_RATE_HZ;
+	static struct ecg_qrs_detector detector;
+	struct ecg_qrs_filter filter;
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t peak_count;
+
+	/* Two consecutive windows through one filter, with 2 mV of 0.3 Hz baseline wander. */
+	ecg_qrs_filter_reset(&filter);
+	for (size_t window = 0; window < 2U; ++window) {
+		ecg_qrs_detector_reset(&detector);
+		for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+		     ++sample_index) {
+			size_t stream_index = window * ECG_PROCESSOR_WINDOW_SIZE + sample_index;
+			float wander = 2.0f * sinf(wander_step * (float)stream_index);
+			ecg_sample_t sample = fixture_input(1.5f + wander +
+							    3.2f * fixture_sample(sample_index));
+
+			ecg_qrs_detector_append(&detector, ecg_qrs_filter_apply(&filter, sample));
+		}
+
+		peak_count = ecg_qrs_detector_finish(&detector, peaks, ARRAY_SIZE(peaks));
+		zassert_equal(peak_count, ARRAY_SIZE(fixture_expected_peaks),
+			      "filtered peak count mismatch in window %u", (unsigned int)window);
+		for (size_t index = 0; index < peak_count; ++index) {
+			zassert_equal(peaks[index],
+				      fixture_expected_peaks[index] + filter_delay_samples,
+				      "filtered peak mismatch at %u in window %u",
+				      (unsigned int)index, (unsigned int)window);
 		}
-		zassert_within(guarded_window.window.samples[sample_index], expected,
-			       FLOAT_TOLERANCE, "golden ECG model input mismatch at %u",
+	}
+}
+
+ZTEST(ecg_regression, test_qrs_filter_starts_without_a_transient)
+{
+	struct ecg_qrs_filter filter;
+
+	/* A restart on a large offset settles immediately instead of ringing like a QRS. */
+	ecg_qrs_filter_reset(&filter);
+	for (size_t index = 0; index < ECG_PROCESSOR_SAMPLE_RATE_HZ; ++index) {
+		zassert_within((float)ecg_qrs_filter_apply(&filter, fixture_input(25.0f)), 0.0f,
+			       FLOAT_TOLERANCE, "filter transient at %u", (unsigned int)index);
+	}
+}
+
+#if !defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+ZTEST(ecg_regression, test_qrs_filter_keeps_training_detector_rr_intervals)
+{
+	/* Irregular RR intervals of 801-1047 ms with beat amplitudes of 2.4-3.6 mV. */
+	static const size_t intervals[] = { 212U, 247U, 229U, 268U, 205U, 254U, 231U, 240U };
+	static const float beat_amplitudes[] = { 3.2f, 2.4f, 3.6f, 2.8f, 3.0f };
+	static struct ecg_qrs_detector raw_detector;
+	static struct ecg_qrs_detector filtered_detector;
+	struct ecg_qrs_filter filter;
+	size_t centers[ECG_PROCESSING_MAX_R_PEAKS];
+	float amplitudes[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t raw_peaks[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t filtered_peaks[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t raw_count;
+	size_t filtered_count;
+	size_t beat_count = 0U;
+
+	for (size_t center = 100U; center + 100U < ECG_PROCESSOR_WINDOW_SIZE;
+	     center += intervals[beat_count % ARRAY_SIZE(intervals)]) {
+		centers[beat_count] = center;
+		amplitudes[beat_count] = beat_amplitudes[beat_count % ARRAY_SIZE(beat_amplitudes)];
+		++beat_count;
+	}
+
+	/* The same window with an electrode offset, once as trained and once band-passed. */
+	ecg_qrs_detector_reset(&raw_detector);
+	ecg_qrs_detector_reset(&filtered_detector);
+	ecg_qrs_filter_reset(&filter);
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		ecg_sample_t sample = fixture_input(
+			1.5f + pulse_train_sample(centers, amplitudes, beat_count, 0.0f,
+						  sample_index));
+
+		ecg_qrs_detector_append(&raw_detector, sample);
+		ecg_qrs_detector_append(&filtered_detector, ecg_qrs_filter_apply(&filter, sample));
+	}
+	raw_count = ecg_qrs_detector_finish(&raw_detector, raw_peaks, ARRAY_SIZE(raw_peaks));
+	filtered_count = ecg_qrs_detector_finish(&filtered_detector, filtered_peaks,
+						 ARRAY_SIZE(filtered_peaks));
+
+	/*
+	 * Every beat is found either way. The threshold crossing of each beat
+	 * moves with its amplitude in both signals, so each RR interval agrees
+	 * within two samples (8 ms) rather than exactly.
+	 */
+	zassert_equal(raw_count, beat_count);
+	zassert_equal(filtered_count, raw_count);
+	for (size_t index = 1U; index < raw_count; ++index) {
+		int32_t raw_interval = (int32_t)(raw_peaks[index] - raw_peaks[index - 1U]);
+		int32_t filtered_interval =
+			(int32_t)(filtered_peaks[index] - filtered_peaks[index - 1U]);
+
+		zassert_true(abs(filtered_interval - raw_interval) <= 2,
+			     "RR interval %u differs by %d samples", (unsigned int)index,
+			     filtered_interval - raw_interval);
+	}
+}
+#endif
+#endif
+
+#if defined(CONFIG_TINYCARDIA_ECG_QRS_DETECTOR_ADAPTIVE)
+static size_t detect_pulse_train(const size_t *centers, const float *amplitudes,
+				 size_t beat_count, float t_wave_slope, size_t *peaks)
+{
+	static struct ecg_qrs_detector detector;
+
+	ecg_qrs_detector_reset(&detector);
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		ecg_qrs_detector_append(&detector,
+					fixture_input(pulse_train_sample(centers, amplitudes,
+									 beat_count, t_wave_slope,
+									 sample_index)));
+	}
+
+	return ecg_qrs_detector_finish(&detector, peaks, ECG_PROCESSING_MAX_R_PEAKS);
+}
+
+static void assert_pulse_train_peaks(const size_t *centers, size_t beat_count,
+				     const size_t *peaks, size_t peak_count)
+{
+	zassert_equal(peak_count, beat_count);
+	for (size_t index = 0; index < peak_count; ++index) {
+		zassert_equal(peaks[index], centers[index],
+			      "adaptive peak mismatch at %u", (unsigned int)index);
+	}
+}
+
+ZTEST(ecg_regression, test_adaptive_detector_keeps_fast_irregular_beats)
+{
+	/* AFib-like RR intervals of 332-547 ms, well inside the training refractory period. */
+	static const size_t intervals[] = { 95U, 130U, 88U, 140U, 101U, 117U, 85U, 126U };
+	size_t centers[ECG_PROCESSING_MAX_R_PEAKS];
+	float amplitudes[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t beat_count = 0U;
+
+	for (size_t center = 64U; center + 64U < ECG_PROCESSOR_WINDOW_SIZE;
+	     center += intervals[beat_count % ARRAY_SIZE(intervals)]) {
+		centers[beat_count] = center;
+		amplitudes[beat_count] = 3.2f;
+		++beat_count;
+	}
+	zassert_true(beat_count > 2U * ECG_PROCESSOR_WINDOW_SIZE / ECG_PROCESSOR_SAMPLE_RATE_HZ);
+
+	assert_pulse_train_peaks(centers, beat_count, peaks,
+				 detect_pulse_train(centers, amplitudes, beat_count, 0.0f, peaks));
+}
+
+ZTEST(ecg_regression, test_adaptive_detector_searches_back_for_a_weak_beat)
+{
+	float amplitudes[ARRAY_SIZE(fixture_centers)];
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+
+	/* A 1.2 mV beat falls below the detection threshold but not below half of it. */
+	for (size_t beat = 0; beat < ARRAY_SIZE(fixture_centers); ++beat) {
+		amplitudes[beat] = beat == 6U ? 1.2f : 3.2f;
+	}
+
+	assert_pulse_train_peaks(fixture_centers, ARRAY_SIZE(fixture_centers), peaks,
+				 detect_pulse_train(fixture_centers, amplitudes,
+						    ARRAY_SIZE(fixture_centers), 0.0f, peaks));
+}
+
+ZTEST(ecg_regression, test_adaptive_detector_rr_jitter_stays_small_in_noise)
+{
+	static struct ecg_qrs_detector detector;
+	float amplitudes[ARRAY_SIZE(fixture_centers)];
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+	uint32_t noise_state = 0x2545f491U;
+	size_t peak_count;
+
+	for (size_t beat = 0; beat < ARRAY_SIZE(fixture_centers); ++beat) {
+		amplitudes[beat] = 3.2f;
+	}
+
+	/* A 1,000 ms rhythm with +/-0.15 mV of uniform noise, enough to ripple the plateau. */
+	ecg_qrs_detector_reset(&detector);
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		float noise;
+
+		noise_state = noise_state * 1664525U + 1013904223U;
+		noise = 0.3f * ((float)(noise_state >> 8) / 16777216.0f - 0.5f);
+		ecg_qrs_detector_append(
+			&detector, fixture_input(1.5f + noise +
+						 pulse_train_sample(fixture_centers, amplitudes,
+								    ARRAY_SIZE(fixture_centers),
+								    0.0f, sample_index)));
+	}
+	peak_count = ecg_qrs_detector_finish(&detector, peaks, ARRAY_SIZE(peaks));
+
+	/* Each RR interval stays within one sample (3.9 ms) of the true 256. */
+	zassert_equal(peak_count, ARRAY_SIZE(fixture_centers));
+	for (size_t index = 1U; index < peak_count; ++index) {
+		int32_t interval = (int32_t)(peaks[index] - peaks[index - 1U]);
+
+		zassert_true(abs(interval - (int32_t)ECG_PROCESSOR_SAMPLE_RATE_HZ) <= 1,
+			     "RR interval %u is %d samples", (unsigned int)index, interval);
+	}
+}
+
+ZTEST(ecg_regression, test_adaptive_detector_rejects_tall_slow_t_waves)
+{
+	float amplitudes[ARRAY_SIZE(fixture_centers)];
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+
+	/* A 2 mV T wave crosses the threshold at half the 1 mV QRS, but rises far more slowly. */
+	for (size_t beat = 0; beat < ARRAY_SIZE(fixture_centers); ++beat) {
+		amplitudes[beat] = 1.0f;
+	}
+
+	assert_pulse_train_peaks(fixture_centers, ARRAY_SIZE(fixture_centers), peaks,
+				 detect_pulse_train(fixture_centers, amplitudes,
+						    ARRAY_SIZE(fixture_centers), 0.1f, peaks));
+}
+#endif
+
+#if !defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+ZTEST(ecg_regression, test_merged_hop_statistics_standardize_like_whole_window)
+{
+	/* Four 2.5-second hops, as kept by overlapping-window capture. */
+	static struct ecg_sample_window hop_window;
+	struct ecg_running_stats hops[4];
+	struct ecg_running_stats merged;
+	const size_t hop_size = ECG_PROCESSOR_WINDOW_SIZE / ARRAY_SIZE(hops);
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+	size_t peak_count;
+
+	reset_guarded_window();
+	ecg_sample_window_reset(&hop_window);
+	for (size_t hop = 0; hop < ARRAY_SIZE(hops); ++hop) {
+		ecg_running_stats_reset(&hops[hop]);
+	}
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		float sample = fixture_sample(sample_index);
+
+		(void)ecg_sample_window_append(&guarded_window.window, sample);
+		(void)ecg_sample_window_append(&hop_window, sample);
+		ecg_running_stats_add(&hops[sample_index / hop_size], sample);
+	}
+	ecg_running_stats_reset(&merged);
+	for (size_t hop = 0; hop < ARRAY_SIZE(hops); ++hop) {
+		ecg_running_stats_merge(&merged, &hops[hop]);
+	}
+	zassert_equal(merged.count, ECG_PROCESSOR_WINDOW_SIZE);
+
+	zassert_ok(ecg_prepare_model_inputs(&guarded_window.window, &workspace,
+					    &processing_result));
+	peak_count = processing_result.r_peak_count;
+	memcpy(peaks, workspace.r_peak_indices, sizeof(peaks));
+
+	ecg_running_stats_standardize(&merged, hop_window.samples, hop_window.samples,
+				      ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(ecg_prepare_standardized_model_inputs(&hop_window, &workspace,
+							 &processing_result));
+	assert_float_array(hop_window.samples, guarded_window.window.samples,
+			   ECG_PROCESSOR_WINDOW_SIZE, FLOAT_TOLERANCE);
+	zassert_equal(processing_result.r_peak_count, peak_count);
+	for (size_t index = 0; index < peak_count; ++index) {
+		zassert_equal(workspace.r_peak_indices[index], peaks[index],
+			      "merged-statistics peak mismatch at %u", (unsigned int)index);
+	}
+}
+#endif
+
+ZTEST(ecg_regression, test_fused_quantization_writes_the_int8_model_input)
+{
+	static struct ecg_qrs_detector detector;
+	static int8_t quantized[ECG_PROCESSOR_WINDOW_SIZE];
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+
+	reset_guarded_window();
+	ecg_qrs_detector_reset(&detector);
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		ecg_sample_t sample = fixture_input(1.5f + 3.2f * fixture_sample(sample_index));
+
+		(void)ecg_sample_window_append(&guarded_window.window, sample);
+		ecg_qrs_detector_append(&detector, sample);
+	}
+
+	zassert_ok(ecg_prepare_model_inputs_from_detector(&guarded_window.window, &detector,
+							  peaks, quantized, &processing_result));
+	zassert_equal(processing_result.r_peak_count, ARRAY_SIZE(fixture_expected_peaks));
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		/* The golden pulse peak also exercises saturation at INT8_MAX. */
+		zassert_within(quantized[sample_index],
+			       tinycardia_model_quantize(fixture_standardized_sample(sample_index),
+							 TINYCARDIA_MODEL_ECG_SCALE,
+							 TINYCARDIA_MODEL_ECG_ZERO_POINT),
+			       QUANTIZED_TOLERANCE, "quantized ECG model input mismatch at %u",
 			       (unsigned int)sample_index);
+		/* No float copy was written, so the window still holds its raw samples. */
+		zassert_equal(guarded_window.window.samples[sample_index],
+			      fixture_input(1.5f + 3.2f * fixture_sample(sample_index)));
 	}
 	zassert_equal(guarded_window.before, CANARY_BEFORE);
 	zassert_equal(guarded_window.after, CANARY_AFTER);
 }
 
+/* Statistics of a 1 Hz sine over the ten whole periods of one window, in millivolts. */
+static void sine_stats(struct ecg_running_stats *stats, float amplitude, float offset)
+{
+	ecg_running_stats_reset(stats);
+	for (size_t index = 0; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
+		float phase = 2.0f * 3.14159265f * (float)index / ECG_PROCESSOR_SAMPLE_RATE_HZ;
+
+		ecg_running_stats_add(stats, fixture_input(offset + amplitude * sinf(phase)));
+	}
+}
+
+ZTEST(ecg_regression, test_reference_statistics_tolerance)
+{
+	struct ecg_running_stats window;
+	struct ecg_running_stats reference;
+	struct ecg_running_stats empty;
+
+	/* A 2 mV sine has a standard deviation of 1.414 mV. */
+	sine_stats(&window, 2.0f, 0.5f);
+	zassert_true(ecg_running_stats_within(&window, &window, 0U));
+
+	/* A 14 uV offset is 10 thousandths of the standard deviation. */
+	sine_stats(&reference, 2.0f, 0.514f);
+	zassert_true(ecg_running_stats_within(&window, &reference, 12U));
+	zassert_false(ecg_running_stats_within(&window, &reference, 8U));
+
+	/* A 2% gain moves only the standard deviation. */
+	sine_stats(&reference, 2.04f, 0.5f);
+	zassert_true(ecg_running_stats_within(&window, &reference, 25U));
+	zassert_false(ecg_running_stats_within(&window, &reference, 15U));
+
+	ecg_running_stats_reset(&empty);
+	zassert_false(ecg_running_stats_within(&window, &empty, 1000U));
+	zassert_false(ecg_running_stats_within(&empty, &window, 1000U));
+	zassert_false(ecg_running_stats_within(NULL, &window, 1000U));
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_COMPACT_SAMPLES)
+ZTEST(ecg_regression, test_q15_samples_match_float_golden_model_inputs)
+{
+	/* Four 2.5-second hops, as kept by overlapping-window capture. */
+	static struct ecg_qrs_detector detector;
+	static int8_t quantized[ECG_PROCESSOR_WINDOW_SIZE];
+	static int8_t hop_quantized[ECG_PROCESSOR_WINDOW_SIZE];
+	struct ecg_running_stats hops[4];
+	struct ecg_running_stats merged;
+	const size_t hop_size = ECG_PROCESSOR_WINDOW_SIZE / ARRAY_SIZE(hops);
+	size_t peaks[ECG_PROCESSING_MAX_R_PEAKS];
+
+	/* The pulse shape is exact in Q15, so every value matches the float golden input. */
+	reset_guarded_window();
+	ecg_qrs_detector_reset(&detector);
+	for (size_t hop = 0; hop < ARRAY_SIZE(hops); ++hop) {
+		ecg_running_stats_reset(&hops[hop]);
+	}
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		ecg_sample_t sample = fixture_input(fixture_sample(sample_index));
+
+		(void)ecg_sample_window_append(&guarded_window.window, sample);
+		ecg_qrs_detector_append(&detector, sample);
+		ecg_running_stats_add(&hops[sample_index / hop_size], sample);
+	}
+
+	zassert_ok(ecg_prepare_model_inputs_from_detector(&guarded_window.window, &detector,
+							  peaks, quantized, &processing_result));
+	zassert_equal(processing_result.r_peak_count, ARRAY_SIZE(fixture_expected_peaks));
+	for (size_t index = 0; index < ARRAY_SIZE(fixture_expected_peaks); ++index) {
+		zassert_equal(peaks[index], fixture_expected_peaks[index],
+			      "fixed-point peak mismatch at %u", (unsigned int)index);
+	}
+	zassert_true(processing_result.rr.features_valid);
+	for (size_t sample_index = 0; sample_index < ECG_PROCESSOR_WINDOW_SIZE;
+	     ++sample_index) {
+		zassert_equal(quantized[sample_index],
+			      tinycardia_model_quantize(fixture_standardized_sample(sample_index),
+							TINYCARDIA_MODEL_ECG_SCALE,
+							TINYCARDIA_MODEL_ECG_ZERO_POINT),
+			      "fixed-point ECG model input mismatch at %u",
+			      (unsigned int)sample_index);
+	}
+
+	/* Per-hop statistics merge into the same model input as whole-window statistics. */
+	ecg_running_stats_reset(&merged);
+	for (size_t hop = 0; hop < ARRAY_SIZE(hops); ++hop) {
+		ecg_running_stats_merge(&merged, &hops[hop]);
+	}
+#if defined(CONFIG_TINYCARDIA_ECG_FIXED_POINT)
+	/* Integer block sums merge exactly. */
+	zassert_equal(merged.sum, guarded_window.window.stats.sum);
+	zassert_equal(merged.sum_squares, guarded_window.window.stats.sum_squares);
+#endif
+	ecg_running_stats_quantize(&merged, guarded_window.window.samples, hop_quantized,
+				   ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_mem_equal(hop_quantized, quantized, sizeof(quantized));
+
+	/* Without an INT8 destination there is no float model input to fall back to. */
+	zassert_equal(ecg_prepare_model_inputs_from_detector(&guarded_window.window, &detector,
+							     peaks, NULL, &processing_result),
+		      -ENOTSUP);
+	zassert_equal(guarded_window.before, CANARY_BEFORE);
+	zassert_equal(guarded_window.after, CANARY_AFTER);
+}
+#else
 ZTEST(ecg_regression, test_partial_window_cannot_be_prepared)
 {
 	reset_guarded_window();
@@ -330,8 +959,170 @@ ZTEST(ecg_regression, test_partial_window_cannot_be_prepared)
 		      -ENODATA);
 	zassert_equal(guarded_window.window.samples[0], 42.0f);
 }
+#endif
+
+/* Fixture millivolts as signed 18-bit MAX30003 counts, clamped to the input range. */
+static int32_t fixture_raw(float millivolts)
+{
+	long counts = lroundf(millivolts * 131072.0f / 32.5f);
+
+	if (counts > 131071L) {
+		return 131071;
+	}
+	if (counts < -131072L) {
+		return -131072;
+	}
+	return (int32_t)counts;
+}
+
+static int32_t clean_signal(size_t sample_index)
+{
+	return fixture_raw(1.5f + 3.2f * fixture_sample(sample_index));
+}
+
+/* Only the top sample of each pulse reaches the positive rail. */
+static int32_t clipped_signal(size_t sample_index)
+{
+	return fixture_raw(1.5f + 31.0f * fixture_sample(sample_index));
+}
+
+/* The front end sits on its rail for the first 1,000 samples. */
+static int32_t railed_signal(size_t sample_index)
+{
+	return sample_index < 1000U ? fixture_raw(40.0f) : clean_signal(sample_index);
+}
+
+/* One beat is missing, leaving about four flat seconds across several hops. */
+static int32_t flat_signal(size_t sample_index)
+{
+	return sample_index >= 500U && sample_index < 1400U ? fixture_raw(1.5f)
+							     : clean_signal(sample_index);
+}
+
+/* 0.5 mV of 50 Hz mains interference. */
+static int32_t mains_signal(size_t sample_index)
+{
+	float phase = 2.0f * 3.14159265f * 50.0f * (float)sample_index /
+		      (float)ECG_PROCESSOR_SAMPLE_RATE_HZ;
+
+	return fixture_raw(1.5f + 3.2f * fixture_sample(sample_index) + 0.5f * sinf(phase));
+}
+
+/* 0.2 mV of noise at the Nyquist frequency, like broadband EMG or a loose electrode. */
+static int32_t noisy_signal(size_t sample_index)
+{
+	return fixture_raw(1.5f + 3.2f * fixture_sample(sample_index) +
+			   ((sample_index & 1U) != 0U ? 0.2f : -0.2f));
+}
+
+static int32_t wandering_signal(size_t sample_index)
+{
+	return fixture_raw(1.5f + 3.2f * fixture_sample(sample_index) +
+			   3.0f * (float)sample_index / ECG_PROCESSOR_WINDOW_SIZE);
+}
+
+static int32_t motion_signal(size_t sample_index)
+{
+	return fixture_raw(1.5f + 3.2f * fixture_sample(sample_index) +
+			   10.0f * (float)sample_index / ECG_PROCESSOR_WINDOW_SIZE);
+}
+
+/* Evaluate one window of signal, accumulated in hop_count blocks and merged. */
+static void evaluate_signal_quality(int32_t (*signal)(size_t), size_t hop_count,
+				    struct ecg_signal_quality_index *quality)
+{
+	const size_t hop_size = ECG_PROCESSOR_WINDOW_SIZE / hop_count;
+	struct ecg_quality_tracker tracker;
+	struct ecg_quality_stats window_stats;
+	struct ecg_quality_stats hop_stats;
+
+	ecg_quality_tracker_reset(&tracker);
+	ecg_quality_stats_reset(&window_stats);
+	for (size_t hop = 0; hop < hop_count; ++hop) {
+		ecg_quality_stats_reset(&hop_stats);
+		for (size_t index = hop * hop_size; index < (hop + 1U) * hop_size; ++index) {
+			ecg_quality_stats_add(&hop_stats, &tracker, signal(index));
+		}
+		ecg_quality_stats_merge(&window_stats, &hop_stats);
+	}
+	zassert_equal(window_stats.count, ECG_PROCESSOR_WINDOW_SIZE);
+	ecg_quality_stats_evaluate(&window_stats, quality);
+}
+
+ZTEST(ecg_quality, test_clean_fixture_is_good)
+{
+	struct ecg_signal_quality_index index;
+
+	evaluate_signal_quality(clean_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_GOOD);
+	zassert_equal(index.saturated_sample_count, 0U);
+	/* The baseline between two pulses is flat, but for one second at most. */
+	zassert_equal(index.longest_flat_sample_count, 250U);
+	zassert_true(index.noise_permille < 1000U, "noise %u", index.noise_permille);
+	zassert_true(index.baseline_drift_uv < 2000U, "drift %u", index.baseline_drift_uv);
+}
+
+ZTEST(ecg_quality, test_saturation_and_flat_lines_are_detected)
+{
+	struct ecg_signal_quality_index index;
+
+	evaluate_signal_quality(clipped_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_POOR);
+	zassert_equal(index.saturated_sample_count, ARRAY_SIZE(fixture_centers));
+
+	evaluate_signal_quality(railed_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_UNUSABLE);
+	zassert_equal(index.saturated_sample_count, 1000U);
+
+	evaluate_signal_quality(flat_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_UNUSABLE);
+	zassert_equal(index.saturated_sample_count, 0U);
+	zassert_equal(index.longest_flat_sample_count, 1018U);
+}
+
+ZTEST(ecg_quality, test_noise_and_baseline_drift_are_graded)
+{
+	struct ecg_signal_quality_index index;
+
+	evaluate_signal_quality(mains_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_POOR, "noise %u", index.noise_permille);
+
+	evaluate_signal_quality(noisy_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_UNUSABLE, "noise %u",
+		      index.noise_permille);
+
+	evaluate_signal_quality(wandering_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_POOR, "drift %u", index.baseline_drift_uv);
+
+	evaluate_signal_quality(motion_signal, 1U, &index);
+	zassert_equal(index.level, ECG_SIGNAL_QUALITY_UNUSABLE, "drift %u",
+		      index.baseline_drift_uv);
+}
+
+ZTEST(ecg_quality, test_merged_hop_statistics_match_whole_window)
+{
+	/* Flat runs cross hop boundaries, one of them a hop that is flat throughout. */
+	int32_t (*const signals[])(size_t) = {
+		clean_signal, railed_signal, flat_signal, noisy_signal, motion_signal,
+	};
+
+	for (size_t signal = 0; signal < ARRAY_SIZE(signals); ++signal) {
+		struct ecg_signal_quality_index whole;
+		struct ecg_signal_quality_index merged;
+
+		evaluate_signal_quality(signals[signal], 1U, &whole);
+		evaluate_signal_quality(signals[signal], 4U, &merged);
+		zassert_equal(merged.level, whole.level, "signal %u", (unsigned int)signal);
+		zassert_equal(merged.saturated_sample_count, whole.saturated_sample_count);
+		zassert_equal(merged.longest_flat_sample_count, whole.longest_flat_sample_count,
+			      "signal %u", (unsigned int)signal);
+		zassert_equal(merged.noise_permille, whole.noise_permille);
+		zassert_equal(merged.baseline_drift_uv, whole.baseline_drift_uv);
+	}
+}
 
 ZTEST_SUITE(ecg_decode, NULL, NULL, NULL, NULL, NULL);
 ZTEST_SUITE(ecg_window, NULL, NULL, NULL, NULL, NULL);
 ZTEST_SUITE(ecg_rr, NULL, NULL, NULL, NULL, NULL);
 ZTEST_SUITE(ecg_regression, NULL, NULL, NULL, NULL, NULL);
+ZTEST_SUITE(ecg_quality, NULL, NULL, NULL, NULL, NULL);
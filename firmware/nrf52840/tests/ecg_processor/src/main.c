@@ -2,6 +2,10 @@
 
 #include "ecg_processor.h"
 
+#include "ecg_processing.h"
+
+#include <string.h>
+
 #include <zephyr/sys/atomic.h>
 #include <zephyr/ztest.h>
 
@@ -12,6 +16,15 @@ K_SEM_DEFINE(window_completed, 0, 8);
 static atomic_t completed_windows;
 static atomic_t block_next_handler;
 static atomic_t handler_error;
+static atomic_t expected_window_span_ms = ATOMIC_INIT(ECG_PROCESSOR_WINDOW_SIZE - 1U);
+static atomic_t last_filled_samples;
+static atomic_t last_fast_recovery_samples;
+static atomic_t last_lead_off_samples;
+static atomic_t last_window_usable;
+static atomic_t last_quality_level;
+static atomic_t last_window_streamed;
+static atomic_t next_chunk_offset;
+static int32_t signal_gain = 1;
 static uint32_t sample_timestamp;
 
 static void prepared_window_handler(const struct ecg_prepared_window *window,
@@ -23,7 +36,19 @@ static void prepared_window_handler(const struct ecg_prepared_window *window,
 		atomic_set(&handler_error, 1);
 	}
 	if ((uint32_t)(window->end_timestamp_ms - window->start_timestamp_ms) !=
-	    ECG_PROCESSOR_WINDOW_SIZE - 1U) {
+	    (uint32_t)atomic_get(&expected_window_span_ms)) {
+		atomic_set(&handler_error, 1);
+	}
+	atomic_set(&last_filled_samples, (atomic_val_t)window->filled_sample_count);
+	atomic_set(&last_fast_recovery_samples, (atomic_val_t)window->fast_recovery_sample_count);
+	atomic_set(&last_lead_off_samples, (atomic_val_t)window->lead_off_sample_count);
+	atomic_set(&last_window_usable, window->usable ? 1 : 0);
+	atomic_set(&last_quality_level, (atomic_val_t)window->quality.level);
+	atomic_set(&last_window_streamed, window->streamed ? 1 : 0);
+	if (window->streamed && atomic_get(&next_chunk_offset) != ECG_PROCESSOR_WINDOW_SIZE) {
+		atomic_set(&handler_error, 1);
+	}
+	if (window->usable != (window->ecg_samples != NULL)) {
 		atomic_set(&handler_error, 1);
 	}
 	if (atomic_cas(&block_next_handler, 1, 0)) {
@@ -44,8 +69,42 @@ static void submit_complete_window(void)
 	}
 }
 
+/* A 1 Hz triangle of about 0.25 mV peak to peak, clean enough for a good signal quality. */
+static uint32_t clean_signal_word(size_t sample_index)
+{
+	int32_t phase = (int32_t)(sample_index % ECG_PROCESSOR_SAMPLE_RATE_HZ);
+	int32_t value = signal_gain * (phase < 128 ? phase * 8 - 512 : 1536 - phase * 8);
+
+	return ((uint32_t)value & 0x3ffffU) << 6;
+}
+
+/* Submit window positions [first_index, first_index + count) at exact 256 Hz times. */
+static void submit_window_batches(size_t first_index, size_t count)
+{
+	/* 32 samples span exactly 125 ms. */
+	uint32_t batch[32];
+
+	for (size_t index = first_index; index < first_index + count; index += ARRAY_SIZE(batch)) {
+		size_t batch_count = MIN(ARRAY_SIZE(batch), first_index + count - index);
+
+		for (size_t offset = 0U; offset < batch_count; ++offset) {
+			batch[offset] = clean_signal_word(index + offset);
+		}
+
+		zassert_equal(ecg_processor_submit_samples(
+				      batch, batch_count,
+				      (uint32_t)((index * 1000U) / ECG_PROCESSOR_SAMPLE_RATE_HZ)),
+			      batch_count, "batch at sample %u was not preserved",
+			      (unsigned int)index);
+	}
+}
+
 ZTEST(ecg_processor, test_double_buffering_and_stopped_window_invalidation)
 {
+	/* 96 samples span exactly 375 ms, so batch timestamps stay exact. */
+	static const uint32_t batch[96];
+	size_t submitted = 0U;
+
 	atomic_set(&block_next_handler, 1);
 	zassert_ok(ecg_processor_init(prepared_window_handler, NULL));
 	zassert_ok(ecg_processor_set_monitoring(true));
@@ -81,6 +140,213 @@ ZTEST(ecg_processor, test_double_buffering_and_stopped_window_invalidation)
 	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
 	zassert_equal(atomic_get(&completed_windows), 4);
 	zassert_equal(atomic_get(&handler_error), 0);
+
+	/* Batches spanning a window boundary split exactly at the boundary. */
+	atomic_set(&expected_window_span_ms,
+		   ((ECG_PROCESSOR_WINDOW_SIZE - 1U) * 1000U) / ECG_PROCESSOR_SAMPLE_RATE_HZ);
+	while (submitted < ECG_PROCESSOR_WINDOW_SIZE) {
+		uint32_t first_timestamp = (uint32_t)((submitted * 1000U) /
+						      ECG_PROCESSOR_SAMPLE_RATE_HZ);
+
+		zassert_equal(ecg_processor_submit_samples(batch, ARRAY_SIZE(batch),
+							   first_timestamp),
+			      ARRAY_SIZE(batch), "batch at sample %u was not preserved",
+			      (unsigned int)submitted);
+		submitted += ARRAY_SIZE(batch);
+	}
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&completed_windows), 5);
+	zassert_equal(atomic_get(&handler_error), 0);
+	zassert_equal(atomic_get(&last_filled_samples), 0);
+
+	/* Restart capture to drop the batch remainder that began the next window. */
+	zassert_ok(ecg_processor_set_monitoring(false));
+	zassert_ok(ecg_processor_set_monitoring(true));
+
+	/* A short acquisition gap is bridged without moving later samples in the window. */
+	submit_window_batches(0U, 992U - CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES);
+	zassert_true(ecg_processor_submit_gap(CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES));
+	submit_window_batches(992U, ECG_PROCESSOR_WINDOW_SIZE - 992U);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&completed_windows), 6);
+	zassert_equal(atomic_get(&handler_error), 0);
+	zassert_equal(atomic_get(&last_filled_samples),
+		      CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES);
+
+	/* A longer gap restarts the partial window instead of shifting its RR timing. */
+	zassert_true(ecg_processor_submit_gap(CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES + 1U),
+		     "a gap between windows shifts nothing");
+	submit_window_batches(0U, 96U);
+	zassert_false(ecg_processor_submit_gap(CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES + 1U));
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	k_sleep(K_MSEC(50));
+	zassert_equal(atomic_get(&completed_windows), 7);
+	zassert_equal(atomic_get(&handler_error), 0);
+	zassert_equal(atomic_get(&last_filled_samples), 0);
+}
+
+ZTEST(ecg_processor, test_quality_flagged_windows_skip_preprocessing)
+{
+	/* ETAG 1 marks a sample taken while the front end was in fast recovery. */
+	static const uint32_t fast_recovery_word = 0x08U;
+
+	zassert_ok(ecg_processor_set_monitoring(false));
+	zassert_ok(ecg_processor_set_monitoring(true));
+
+	/* One fast-recovery sample, here the last, makes the whole window unusable. */
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE - 1U);
+	zassert_true(ecg_processor_submit_sample(
+		fast_recovery_word,
+		((ECG_PROCESSOR_WINDOW_SIZE - 1U) * 1000U) / ECG_PROCESSOR_SAMPLE_RATE_HZ));
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_usable), 0);
+	zassert_equal(atomic_get(&last_fast_recovery_samples), 1);
+	zassert_equal(atomic_get(&last_lead_off_samples), 0);
+
+	/* Samples acquired with an electrode off are counted and reject the window. */
+	ecg_processor_set_lead_off(true);
+	submit_window_batches(0U, 64U);
+	ecg_processor_set_lead_off(false);
+	submit_window_batches(64U, ECG_PROCESSOR_WINDOW_SIZE - 64U);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_usable), 0);
+	zassert_equal(atomic_get(&last_fast_recovery_samples), 0);
+	zassert_equal(atomic_get(&last_lead_off_samples), 64);
+
+	/* A clean window afterwards is prepared normally. */
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_usable), 1);
+	zassert_equal(atomic_get(&last_quality_level), ECG_SIGNAL_QUALITY_GOOD);
+	zassert_equal(atomic_get(&handler_error), 0);
+}
+
+ZTEST(ecg_processor, test_flat_line_window_is_rejected_by_signal_quality)
+{
+	/* 32 samples span exactly 125 ms. */
+	static const uint32_t flat_batch[32];
+
+	zassert_ok(ecg_processor_set_monitoring(false));
+	zassert_ok(ecg_processor_set_monitoring(true));
+
+	/* A railed or disconnected input holds one value without any tag or lead-off flag. */
+	for (size_t index = 0U; index < ECG_PROCESSOR_WINDOW_SIZE;
+	     index += ARRAY_SIZE(flat_batch)) {
+		zassert_equal(ecg_processor_submit_samples(
+				      flat_batch, ARRAY_SIZE(flat_batch),
+				      (uint32_t)((index * 1000U) / ECG_PROCESSOR_SAMPLE_RATE_HZ)),
+			      ARRAY_SIZE(flat_batch));
+	}
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_usable), 0);
+	zassert_equal(atomic_get(&last_quality_level), ECG_SIGNAL_QUALITY_UNUSABLE);
+	zassert_equal(atomic_get(&last_fast_recovery_samples), 0);
+	zassert_equal(atomic_get(&last_lead_off_samples), 0);
+
+	/* The signal-quality history restarts with capture, so the next clean window is good. */
+	zassert_ok(ecg_processor_set_monitoring(false));
+	zassert_ok(ecg_processor_set_monitoring(true));
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_usable), 1);
+	zassert_equal(atomic_get(&last_quality_level), ECG_SIGNAL_QUALITY_GOOD);
+	zassert_equal(atomic_get(&handler_error), 0);
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+static atomic_t streamed_chunks;
+static int8_t streamed_ecg[ECG_PROCESSOR_WINDOW_SIZE];
+
+static void chunk_handler(const int8_t *quantized_samples, size_t offset, size_t count,
+			  void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	/* Chunks arrive in order; offset 0 starts a new window. */
+	if (count != CONFIG_TINYCARDIA_ECG_STREAM_CHUNK_SAMPLES ||
+	    (offset != 0U && offset != (size_t)atomic_get(&next_chunk_offset)) ||
+	    offset + count > ECG_PROCESSOR_WINDOW_SIZE) {
+		atomic_set(&handler_error, 1);
+		return;
+	}
+	memcpy(&streamed_ecg[offset], quantized_samples, count);
+	atomic_set(&next_chunk_offset, (atomic_val_t)(offset + count));
+	atomic_inc(&streamed_chunks);
+}
+
+/* The exact quantization of a clean window, with its own statistics. */
+static void assert_streamed_window_exact(void)
+{
+	static ecg_sample_t samples[ECG_PROCESSOR_WINDOW_SIZE];
+	static int8_t expected[ECG_PROCESSOR_WINDOW_SIZE];
+	struct ecg_running_stats stats;
+
+	ecg_running_stats_reset(&stats);
+	for (size_t index = 0U; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
+		samples[index] = ecg_decode_sample(clean_signal_word(index));
+		ecg_running_stats_add(&stats, samples[index]);
+	}
+	ecg_running_stats_quantize(&stats, samples, expected, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_mem_equal(streamed_ecg, expected, sizeof(expected));
+}
+#endif
+
+ZTEST(ecg_processor, test_windows_stream_in_chunks_while_captured)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_STREAMING)
+	const size_t chunk_count =
+		ECG_PROCESSOR_WINDOW_SIZE / CONFIG_TINYCARDIA_ECG_STREAM_CHUNK_SAMPLES;
+
+	zassert_ok(ecg_processor_set_monitoring(false));
+	zassert_ok(ecg_processor_set_chunk_handler(chunk_handler, NULL));
+	zassert_ok(ecg_processor_set_monitoring(true));
+	atomic_set(&streamed_chunks, 0);
+
+	/* The first window has no previous statistics to quantize its chunks with. */
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_streamed), 0);
+	zassert_equal(atomic_get(&streamed_chunks), 0);
+
+	/* Chunks reach the handler while the rest of the window is still being captured. */
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE / 2U);
+	k_sleep(K_MSEC(50));
+	zassert_equal(atomic_get(&streamed_chunks), chunk_count / 2U);
+	submit_window_batches(ECG_PROCESSOR_WINDOW_SIZE / 2U, ECG_PROCESSOR_WINDOW_SIZE / 2U);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_streamed), 1);
+	zassert_equal(atomic_get(&streamed_chunks), chunk_count);
+	/* The periodic signal gives every window the same statistics. */
+	assert_streamed_window_exact();
+
+	/* A window restarted by a long gap streams again from its first chunk. */
+	submit_window_batches(0U, 3U * CONFIG_TINYCARDIA_ECG_STREAM_CHUNK_SAMPLES / 2U);
+	zassert_false(ecg_processor_submit_gap(CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES + 1U));
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_streamed), 1);
+	assert_streamed_window_exact();
+
+	/* Twice the amplitude moves the standard deviation too far from the reference. */
+	signal_gain = 2;
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_usable), 1);
+	zassert_equal(atomic_get(&last_window_streamed), 0);
+	signal_gain = 1;
+
+	/* Without a chunk handler nothing is streamed. */
+	zassert_ok(ecg_processor_set_chunk_handler(NULL, NULL));
+	atomic_set(&streamed_chunks, 0);
+	submit_window_batches(0U, ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_ok(k_sem_take(&window_completed, K_SECONDS(2)));
+	zassert_equal(atomic_get(&last_window_streamed), 0);
+	zassert_equal(atomic_get(&streamed_chunks), 0);
+	zassert_equal(atomic_get(&handler_error), 0);
+#else
+	zassert_equal(ecg_processor_set_chunk_handler(NULL, NULL), -ENOTSUP);
+#endif
 }
 
 ZTEST_SUITE(ecg_processor, NULL, NULL, NULL, NULL, NULL);
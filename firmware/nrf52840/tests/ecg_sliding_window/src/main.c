@@ -0,0 +1,413 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "ecg_processing.h"
+#include "ecg_processor.h"
+#include "model_contract.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/atomic.h>
+#include <zephyr/ztest.h>
+
+#define HOP_SIZE CONFIG_TINYCARDIA_ECG_WINDOW_HOP_SAMPLES
+/* 32 samples span exactly 125 ms, so every batch and hop starts on a whole millisecond. */
+#define BATCH_SIZE 32U
+
+K_SEM_DEFINE(handler_entered, 0, 1);
+K_SEM_DEFINE(handler_release, 0, 1);
+/* Start timestamps of delivered windows, in delivery order. */
+K_MSGQ_DEFINE(window_starts, sizeof(uint32_t), 16, 4);
+
+static atomic_t block_next_handler;
+static atomic_t handler_error;
+static atomic_t last_filled_samples;
+static atomic_t last_lead_off_samples;
+static atomic_t last_window_usable;
+static atomic_t last_r_peak_count;
+static size_t next_sample_index;
+static int8_t model_input[ECG_PROCESSOR_WINDOW_SIZE];
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+/* Stands in for the tensor arena scratch, which every inference overwrites. */
+static struct ecg_processing_workspace borrowed_workspace;
+#endif
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+/* The last quantized window, and how many windows matched it on the samples they share. */
+static int8_t previous_window[ECG_PROCESSOR_WINDOW_SIZE];
+static uint32_t previous_start_sample;
+static atomic_t identical_shared_windows;
+#endif
+
+BUILD_ASSERT(HOP_SIZE < ECG_PROCESSOR_WINDOW_SIZE, "this suite needs overlapping windows");
+BUILD_ASSERT(HOP_SIZE % BATCH_SIZE == 0U, "hops must start on a batch boundary");
+
+/*
+ * Deterministic 18-bit signal with a good signal-quality index: a triangle
+ * baseline every 1,000 samples plus a sharp pulse every 250 samples. Neither
+ * period divides the hop, so every window is distinct.
+ */
+static int32_t signal_value(size_t sample_index)
+{
+	int32_t phase = (int32_t)(sample_index % 1000U);
+	int32_t pulse_phase = (int32_t)(sample_index % 250U);
+	int32_t value = phase < 500 ? phase * 4 - 1000 : 3000 - phase * 4;
+
+	if (pulse_phase <= 16) {
+		value += 4000 - abs(pulse_phase - 8) * 500;
+	}
+
+	return value;
+}
+
+/*
+ * Largest difference, in INT8 steps, between a quantized sample and the exact
+ * standardized value z. Reference statistics within a tolerance t of the
+ * window's own move z by at most t * (1 + |z|) / (1 - t).
+ */
+static double quantized_tolerance(double z)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+	double tolerance = CONFIG_TINYCARDIA_ECG_STREAM_STATS_TOLERANCE_PERMILLE / 1000.0;
+
+	return 1.0 + tolerance * (1.0 + fabs(z)) / ((1.0 - tolerance) * TINYCARDIA_MODEL_ECG_SCALE);
+#else
+	ARG_UNUSED(z);
+
+	/* Float rounding may only move a value sitting on a half step. */
+	return 1.0;
+#endif
+}
+
+static uint32_t sample_timestamp_ms(size_t sample_index)
+{
+	return (uint32_t)((sample_index * 1000U) / ECG_PROCESSOR_SAMPLE_RATE_HZ);
+}
+
+/* Timestamps round down, so rounding back up recovers the sample index. */
+static size_t window_first_index(const struct ecg_prepared_window *window)
+{
+	return ((size_t)window->start_timestamp_ms * ECG_PROCESSOR_SAMPLE_RATE_HZ + 999U) / 1000U;
+}
+
+/* The model input must be the standardized last 2,560 samples, in order. */
+static bool window_matches_signal(const struct ecg_prepared_window *window)
+{
+	size_t first_index = window_first_index(window);
+	double mean = 0.0;
+	double variance = 0.0;
+	double standard_deviation;
+
+	for (size_t index = 0U; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
+		mean += signal_value(first_index + index);
+	}
+	mean /= ECG_PROCESSOR_WINDOW_SIZE;
+	for (size_t index = 0U; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
+		double difference = signal_value(first_index + index) - mean;
+
+		variance += difference * difference;
+	}
+	standard_deviation = sqrt(variance / ECG_PROCESSOR_WINDOW_SIZE);
+
+	for (size_t index = 0U; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
+		double expected = (signal_value(first_index + index) - mean) / standard_deviation;
+
+		if (window->ecg_quantized_samples != NULL) {
+			int8_t quantized = tinycardia_model_quantize(
+				(float)expected, TINYCARDIA_MODEL_ECG_SCALE,
+				TINYCARDIA_MODEL_ECG_ZERO_POINT);
+
+			if (abs(window->ecg_quantized_samples[index] - quantized) >
+			    quantized_tolerance(expected)) {
+				return false;
+			}
+		} else if (fabs(window->ecg_samples[index] - expected) > 1.0e-3) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void prepared_window_handler(const struct ecg_prepared_window *window,
+				    void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	if (window->sample_count != ECG_PROCESSOR_WINDOW_SIZE ||
+	    window->end_timestamp_ms - window->start_timestamp_ms !=
+		    sample_timestamp_ms(ECG_PROCESSOR_WINDOW_SIZE - 1U)) {
+		atomic_set(&handler_error, 1);
+	}
+	if (window->usable && window->filled_sample_count == 0U &&
+	    !window_matches_signal(window)) {
+		atomic_set(&handler_error, 1);
+	}
+	atomic_set(&last_filled_samples, (atomic_val_t)window->filled_sample_count);
+	atomic_set(&last_lead_off_samples, (atomic_val_t)window->lead_off_sample_count);
+	atomic_set(&last_window_usable, window->usable ? 1 : 0);
+	atomic_set(&last_r_peak_count, (atomic_val_t)window->r_peak_count);
+	if (window->start_sample % HOP_SIZE != 0U) {
+		atomic_set(&handler_error, 1);
+	}
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+	if (window->usable && window->ecg_quantized_samples != NULL) {
+		if (window->start_sample - previous_start_sample == HOP_SIZE &&
+		    memcmp(&previous_window[HOP_SIZE], window->ecg_quantized_samples,
+			   ECG_PROCESSOR_WINDOW_SIZE - HOP_SIZE) == 0) {
+			atomic_inc(&identical_shared_windows);
+		}
+		memcpy(previous_window, window->ecg_quantized_samples, sizeof(previous_window));
+		previous_start_sample = window->start_sample;
+	}
+#endif
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+	/* Like Invoke(), the handler may clobber the workspace the window was prepared in. */
+	memset(&borrowed_workspace, 0xa5, sizeof(borrowed_workspace));
+#endif
+	if (atomic_cas(&block_next_handler, 1, 0)) {
+		k_sem_give(&handler_entered);
+		if (k_sem_take(&handler_release, K_SECONDS(2)) < 0) {
+			atomic_set(&handler_error, 1);
+		}
+	}
+	(void)k_msgq_put(&window_starts, &window->start_timestamp_ms, K_NO_WAIT);
+}
+
+/* Submit the next count samples of the signal in FIFO-sized batches. */
+static void submit_signal(size_t count)
+{
+	uint32_t batch[BATCH_SIZE];
+
+	for (size_t submitted = 0U; submitted < count; submitted += BATCH_SIZE) {
+		size_t batch_count = MIN(BATCH_SIZE, count - submitted);
+
+		for (size_t index = 0U; index < batch_count; ++index) {
+			uint32_t value = (uint32_t)signal_value(next_sample_index + index);
+
+			batch[index] = (value & 0x3ffffU) << 6;
+		}
+		zassert_equal(ecg_processor_submit_samples(batch, batch_count,
+							   sample_timestamp_ms(next_sample_index)),
+			      batch_count, "batch at sample %u was not preserved",
+			      (unsigned int)next_sample_index);
+		next_sample_index += batch_count;
+	}
+}
+
+static void expect_window_starting_at(size_t first_index)
+{
+	uint32_t start_timestamp_ms;
+
+	zassert_ok(k_msgq_get(&window_starts, &start_timestamp_ms, K_SECONDS(2)));
+	zassert_equal(start_timestamp_ms, sample_timestamp_ms(first_index),
+		      "window should start at sample %u", (unsigned int)first_index);
+}
+
+static void expect_no_window(k_timeout_t timeout)
+{
+	uint32_t start_timestamp_ms;
+
+	zassert_not_equal(k_msgq_get(&window_starts, &start_timestamp_ms, timeout), 0,
+			  "unexpected window starting at %u ms", start_timestamp_ms);
+}
+
+static void restart_monitoring(void)
+{
+	zassert_ok(ecg_processor_set_monitoring(false));
+	zassert_ok(ecg_processor_set_monitoring(true));
+	k_msgq_purge(&window_starts);
+}
+
+static void *sliding_window_setup(void)
+{
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+	zassert_ok(ecg_processor_set_workspace(&borrowed_workspace, sizeof(borrowed_workspace)));
+#else
+	zassert_equal(ecg_processor_set_workspace(model_input, sizeof(model_input)), -ENOTSUP);
+#endif
+	zassert_ok(ecg_processor_init(prepared_window_handler, NULL));
+
+	return NULL;
+}
+
+ZTEST(ecg_sliding_window, test_each_hop_prepares_the_latest_full_window)
+{
+	restart_monitoring();
+
+	/* The first window needs a full 2,560 samples; nothing is prepared before. */
+	submit_signal(ECG_PROCESSOR_WINDOW_SIZE - BATCH_SIZE);
+	expect_no_window(K_MSEC(50));
+	submit_signal(BATCH_SIZE);
+	expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+
+	/* After that, every hop prepares one more window, including across the ring wrap. */
+	for (size_t hop = 0U; hop < 2U * ECG_PROCESSOR_WINDOW_SIZE / HOP_SIZE; ++hop) {
+		submit_signal(HOP_SIZE - BATCH_SIZE);
+		expect_no_window(K_MSEC(20));
+		submit_signal(BATCH_SIZE);
+		expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+	}
+	zassert_equal(atomic_get(&handler_error), 0);
+}
+
+ZTEST(ecg_sliding_window, test_slow_handler_skips_windows_without_losing_samples)
+{
+	size_t first_window_end;
+
+	restart_monitoring();
+	submit_signal(ECG_PROCESSOR_WINDOW_SIZE - HOP_SIZE);
+
+	/* Capture continues while the handler holds a window; at most two more stay queued. */
+	atomic_set(&block_next_handler, 1);
+	submit_signal(HOP_SIZE);
+	zassert_ok(k_sem_take(&handler_entered, K_SECONDS(2)));
+	submit_signal(3U * HOP_SIZE);
+	first_window_end = next_sample_index;
+	k_sem_give(&handler_release);
+	expect_window_starting_at(first_window_end - ECG_PROCESSOR_WINDOW_SIZE - 3U * HOP_SIZE);
+	expect_window_starting_at(first_window_end - ECG_PROCESSOR_WINDOW_SIZE - HOP_SIZE);
+	expect_window_starting_at(first_window_end - ECG_PROCESSOR_WINDOW_SIZE);
+	/* The oldest of three queued windows was replaced. */
+	expect_no_window(K_MSEC(50));
+
+	/* A queued window whose oldest hop is overwritten before preparation is skipped. */
+	atomic_set(&block_next_handler, 1);
+	submit_signal(HOP_SIZE);
+	zassert_ok(k_sem_take(&handler_entered, K_SECONDS(2)));
+	submit_signal(3U * HOP_SIZE + BATCH_SIZE);
+	k_sem_give(&handler_release);
+	expect_window_starting_at(first_window_end + HOP_SIZE - ECG_PROCESSOR_WINDOW_SIZE);
+	expect_window_starting_at(first_window_end + 4U * HOP_SIZE - ECG_PROCESSOR_WINDOW_SIZE);
+	expect_no_window(K_MSEC(50));
+	zassert_equal(atomic_get(&handler_error), 0);
+}
+
+ZTEST(ecg_sliding_window, test_gaps_and_quality_follow_every_overlapping_window)
+{
+	const size_t hops_per_window = ECG_PROCESSOR_WINDOW_SIZE / HOP_SIZE;
+
+	restart_monitoring();
+
+	/* Lead-off samples in one hop reject every window that contains that hop. */
+	submit_signal(ECG_PROCESSOR_WINDOW_SIZE - HOP_SIZE);
+	ecg_processor_set_lead_off(true);
+	submit_signal(64U);
+	ecg_processor_set_lead_off(false);
+	submit_signal(HOP_SIZE - 64U);
+	for (size_t window = 0U; window <= hops_per_window; ++window) {
+		if (window > 0U) {
+			submit_signal(HOP_SIZE);
+		}
+		expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+		zassert_equal(atomic_get(&last_window_usable), window < hops_per_window ? 0 : 1);
+		zassert_equal(atomic_get(&last_lead_off_samples),
+			      window < hops_per_window ? 64 : 0);
+	}
+
+	/* A short gap is bridged and counted in each window that overlaps it. */
+	submit_signal(HOP_SIZE - BATCH_SIZE - CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES);
+	next_sample_index += CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES;
+	zassert_true(ecg_processor_submit_gap(CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES));
+	submit_signal(BATCH_SIZE);
+	for (size_t window = 0U; window <= hops_per_window; ++window) {
+		if (window > 0U) {
+			submit_signal(HOP_SIZE);
+		}
+		expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+		zassert_equal(atomic_get(&last_filled_samples),
+			      window < hops_per_window ? CONFIG_TINYCARDIA_ECG_MAX_FILLED_GAP_SAMPLES
+						       : 0);
+	}
+
+	/* A longer gap restarts capture, so the next window needs a full window of samples. */
+	submit_signal(BATCH_SIZE);
+	next_sample_index += BATCH_SIZE;
+	zassert_false(ecg_processor_submit_gap(BATCH_SIZE));
+	submit_signal(ECG_PROCESSOR_WINDOW_SIZE - BATCH_SIZE);
+	expect_no_window(K_MSEC(50));
+	submit_signal(BATCH_SIZE);
+	expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_equal(atomic_get(&last_filled_samples), 0);
+	zassert_equal(atomic_get(&handler_error), 0);
+}
+
+ZTEST(ecg_sliding_window, test_model_input_is_quantized_while_copied_from_the_ring)
+{
+	static struct ecg_sample_window reference_window;
+	static struct ecg_processing_workspace reference_workspace;
+	static struct ecg_processing_result reference_result;
+	size_t first_index;
+
+	restart_monitoring();
+	ecg_processor_set_model_input(model_input);
+
+	/* The first window and one after a ring wrap both land in the model input. */
+	submit_signal(ECG_PROCESSOR_WINDOW_SIZE);
+	expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+	for (size_t hop = 0U; hop <= ECG_PROCESSOR_WINDOW_SIZE / HOP_SIZE; ++hop) {
+		submit_signal(HOP_SIZE);
+		expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+	}
+	first_index = next_sample_index - ECG_PROCESSOR_WINDOW_SIZE;
+	ecg_processor_set_model_input(NULL);
+	zassert_equal(atomic_get(&handler_error), 0);
+
+	/* Peaks found on the raw ring samples match those of the standardized window. */
+	ecg_sample_window_reset(&reference_window);
+	for (size_t index = 0U; index < ECG_PROCESSOR_WINDOW_SIZE; ++index) {
+		(void)ecg_sample_window_append(&reference_window,
+					       (float)signal_value(first_index + index));
+	}
+	zassert_ok(ecg_prepare_model_inputs(&reference_window, &reference_workspace,
+					    &reference_result));
+	zassert_equal(atomic_get(&last_r_peak_count), (atomic_val_t)reference_result.r_peak_count);
+}
+
+#if defined(CONFIG_TINYCARDIA_ECG_HOP_REFERENCE_STATS)
+ZTEST(ecg_sliding_window, test_reference_statistics_keep_shared_samples_identical)
+{
+	size_t hops = ECG_PROCESSOR_WINDOW_SIZE / HOP_SIZE + 1U;
+
+	restart_monitoring();
+	ecg_processor_set_model_input(model_input);
+	atomic_set(&identical_shared_windows, 0);
+
+	/* Every window after the first can reuse what the model computed for the one before. */
+	submit_signal(ECG_PROCESSOR_WINDOW_SIZE);
+	expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+	for (size_t hop = 0U; hop < hops; ++hop) {
+		submit_signal(HOP_SIZE);
+		expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+	}
+	ecg_processor_set_model_input(NULL);
+	zassert_equal(atomic_get(&identical_shared_windows), (atomic_val_t)hops);
+	zassert_equal(atomic_get(&handler_error), 0);
+}
+#endif
+
+#if defined(CONFIG_TINYCARDIA_ECG_ARENA_WORKSPACE)
+ZTEST(ecg_sliding_window, test_borrowed_workspace_is_validated)
+{
+	uint8_t *memory = (uint8_t *)&borrowed_workspace;
+
+	zassert_equal(ecg_processor_set_workspace(NULL, sizeof(borrowed_workspace)), -EINVAL);
+	zassert_equal(ecg_processor_set_workspace(memory + 1, sizeof(borrowed_workspace) - 1U),
+		      -EINVAL);
+	zassert_equal(ecg_processor_set_workspace(memory, sizeof(borrowed_workspace) - 1U),
+		      -ENOMEM);
+	zassert_ok(ecg_processor_set_workspace(memory, sizeof(borrowed_workspace)));
+
+	/* Windows prepared in the clobbered workspace still match the signal. */
+	restart_monitoring();
+	submit_signal(ECG_PROCESSOR_WINDOW_SIZE + HOP_SIZE);
+	expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE - HOP_SIZE);
+	expect_window_starting_at(next_sample_index - ECG_PROCESSOR_WINDOW_SIZE);
+	zassert_equal(atomic_get(&last_window_usable), 1);
+	zassert_true(atomic_get(&last_r_peak_count) > 0);
+	zassert_equal(atomic_get(&handler_error), 0);
+}
+#endif
+
+ZTEST_SUITE(ecg_sliding_window, NULL, sliding_window_setup, NULL, NULL, NULL);
@@ -0,0 +1,456 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "max30003.h"
+#include "max30003_emul.h"
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+#include "max30003_dma_emul.h"
+#endif
+
+#include <zephyr/drivers/emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#define CAPTURE_CAPACITY      512U
+#define FIFO_BATCH            16U
+#define ETAG_FIELD            GENMASK(5, 3)
+#define ETAG_FAST             1U
+#define ETAG_FAST_LAST        3U
+#define SERVICE_SETTLE        K_MSEC(5)
+#define REG_CNFG_GEN          0x10U
+#define REG_MNGR_INT          0x04U
+#define REG_EN_INT            0x02U
+#define REG_FIFO_RST          0x0aU
+#define CNFG_GEN_EN_ECG       BIT(19)
+#define STATUS_EOVF           BIT(22)
+#define RTOR_TICK_MS          (1000.0f / 128.0f)
+#define SAMPLE_PERIOD_MS      (1000.0f / MAX30003_SAMPLE_RATE_HZ)
+#define FIFO_DEPTH            32U
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+/* DMA capture wakes the CPU, and delivers samples, once per half of its burst ring. */
+#define WAKE_SAMPLES     (FIFO_BATCH * CONFIG_TINYCARDIA_MAX30003_DMA_BURSTS_PER_WAKE)
+/* An overflow stops the bursts that wake DMA capture, leaving it to the health check. */
+#define OVERFLOW_SETTLE  K_MSEC(CONFIG_TINYCARDIA_MAX30003_STATUS_POLL_MS + 5)
+#else
+#define WAKE_SAMPLES     FIFO_BATCH
+#define OVERFLOW_SETTLE  SERVICE_SETTLE
+#endif
+
+static const struct emul *max30003_emul = EMUL_DT_GET(DT_NODELABEL(max30003));
+
+static int32_t ramp_samples[CAPTURE_CAPACITY];
+static uint32_t captured_words[CAPTURE_CAPACITY];
+static uint32_t captured_timestamps[CAPTURE_CAPACITY];
+static size_t captured_count;
+static size_t captured_blocks;
+static uint32_t dropped_samples;
+static size_t gap_position;
+static enum max30003_lead_status last_lead_status = MAX30003_LEAD_STATUS_UNKNOWN;
+static float last_rr_interval_ms;
+static size_t rr_interval_count;
+static atomic_t stall_next_block;
+
+static void block_handler(const uint32_t *words, size_t count, uint32_t first_timestamp_ms,
+			  void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	/* Hold the acquisition work queue, and with it FIFO servicing, long enough to overflow. */
+	if (atomic_cas(&stall_next_block, 1, 0)) {
+		k_sleep(K_MSEC(300));
+	}
+	++captured_blocks;
+	for (size_t index = 0; index < count && captured_count < CAPTURE_CAPACITY; ++index) {
+		captured_words[captured_count] = words[index];
+		captured_timestamps[captured_count] =
+			max30003_block_timestamp_ms(first_timestamp_ms, index);
+		++captured_count;
+	}
+}
+
+static void drop_handler(uint32_t dropped, void *user_data)
+{
+	ARG_UNUSED(user_data);
+	dropped_samples += dropped;
+	gap_position = captured_count;
+}
+
+static void lead_status_handler(enum max30003_lead_status status, void *user_data)
+{
+	ARG_UNUSED(user_data);
+	last_lead_status = status;
+}
+
+static void rr_interval_handler(float interval_ms, uint32_t timestamp_ms, void *user_data)
+{
+	ARG_UNUSED(timestamp_ms);
+	ARG_UNUSED(user_data);
+	last_rr_interval_ms = interval_ms;
+	++rr_interval_count;
+}
+
+static int32_t decode_sample(uint32_t word)
+{
+	return (int32_t)(word << 8) >> 14;
+}
+
+/* Hold the system work queue, which acquisition must not depend on. */
+static void stall_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+	k_sleep(K_MSEC(300));
+}
+
+K_WORK_DEFINE(stall_work, stall_handler);
+
+/* Produce samples one FIFO batch at a time and let the work queue service each batch. */
+static void acquire(size_t sample_count)
+{
+	while (sample_count > 0U) {
+		size_t batch = MIN(sample_count, FIFO_BATCH);
+
+		max30003_emul_advance(max30003_emul, batch);
+		k_sleep(SERVICE_SETTLE);
+		sample_count -= batch;
+	}
+}
+
+static void *max30003_suite_setup(void)
+{
+	for (size_t index = 0; index < ARRAY_SIZE(ramp_samples); ++index) {
+		/* Exercise both signs of the 18-bit sample field. */
+		ramp_samples[index] = ((int32_t)index - 256) * 257;
+	}
+	max30003_emul_set_samples(max30003_emul, ramp_samples, ARRAY_SIZE(ramp_samples));
+
+	max30003_set_sample_block_handler(block_handler, NULL);
+	max30003_set_drop_handler(drop_handler, NULL);
+	max30003_set_rr_interval_handler(rr_interval_handler, NULL);
+	zassert_ok(max30003_init(NULL, NULL));
+	max30003_set_lead_status_handler(lead_status_handler, NULL);
+
+	return NULL;
+}
+
+static void max30003_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+	/* Restarting monitoring starts each test on an empty capture ring. */
+	max30003_dma_emul_set_edges_missed(false);
+	zassert_ok(max30003_set_monitoring(false));
+#endif
+	zassert_ok(max30003_set_monitoring(true));
+	max30003_emul_set_samples(max30003_emul, ramp_samples, ARRAY_SIZE(ramp_samples));
+	max30003_emul_set_fast_recovery(max30003_emul, false);
+	max30003_emul_set_lead_off(max30003_emul, 0U);
+	/* Discard a partial batch left behind by the previous test. */
+	zassert_ok(max30003_write_register(REG_FIFO_RST, 0U));
+	k_sleep(SERVICE_SETTLE);
+	max30003_emul_reset_stats(max30003_emul);
+	captured_count = 0U;
+	captured_blocks = 0U;
+	dropped_samples = 0U;
+	gap_position = 0U;
+}
+
+ZTEST(max30003, test_init_programs_and_verifies_configuration)
+{
+	uint32_t info;
+
+	zassert_ok(max30003_sanity_check(&info));
+	zassert_equal(max30003_emul_get_register(max30003_emul, REG_CNFG_GEN), 0x081213U);
+	zassert_equal(max30003_emul_get_register(max30003_emul, REG_MNGR_INT), 0x7f0004U,
+		      "EFIT must request one interrupt per 16 samples");
+	zassert_equal(max30003_emul_get_register(max30003_emul, REG_EN_INT),
+		      IS_ENABLED(CONFIG_TINYCARDIA_MAX30003_RTOR) ? 0x800003U | BIT(10) :
+								  0x800003U);
+	zassert_true(max30003_is_monitoring());
+}
+
+ZTEST(max30003, test_samples_arrive_in_order_once_per_fifo_batch)
+{
+	struct max30003_emul_stats stats;
+
+	acquire(4U * FIFO_BATCH);
+
+	zassert_equal(captured_count, 4U * FIFO_BATCH);
+	zassert_equal(captured_blocks, 4U, "each INT1 edge must produce exactly one batch");
+	for (size_t index = 1; index < captured_count; ++index) {
+		zassert_equal(decode_sample(captured_words[index]) -
+				      decode_sample(captured_words[index - 1U]),
+			      257, "sample %u is out of order", (unsigned int)index);
+		/* Per-block rounding keeps every timestamp within 1 ms of the 256 Hz grid. */
+		zassert_within((int32_t)(captured_timestamps[index] - captured_timestamps[0]),
+			       (int32_t)((index * MSEC_PER_SEC) / MAX30003_SAMPLE_RATE_HZ), 1,
+			       "timestamps are not continuous at %u", (unsigned int)index);
+	}
+
+	/* One burst per batch and one STATUS read per wakeup bound the SPI cost of acquisition. */
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.spi_transactions, 4U + 4U * FIFO_BATCH / WAKE_SAMPLES);
+	zassert_equal(stats.fifo_words_read, 4U * FIFO_BATCH);
+	zassert_equal(stats.overflows, 0U);
+}
+
+ZTEST(max30003, test_injected_overflow_resets_fifo_and_recovers)
+{
+	/* An injected overflow takes no sample time; exact loss is checked in real time below. */
+	max30003_emul_inject_overflow(max30003_emul);
+	k_sleep(OVERFLOW_SETTLE);
+
+	zassert_equal(max30003_emul_get_register(max30003_emul, 0x01U) & STATUS_EOVF, 0U,
+		      "the driver must reset the FIFO after an overflow");
+
+	acquire(WAKE_SAMPLES);
+	zassert_true(captured_count >= FIFO_BATCH, "acquisition must recover after overflow");
+}
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+
+ZTEST(max30003, test_dma_capture_continues_while_fifo_service_stalls)
+{
+	struct max30003_emul_stats stats;
+
+	atomic_set(&stall_next_block, 1);
+	max30003_emul_start_clock(max30003_emul);
+	k_sleep(K_MSEC(700));
+	max30003_emul_stop_clock(max30003_emul);
+	k_sleep(SERVICE_SETTLE);
+
+	/* Bursts kept emptying the FIFO while the CPU was held. */
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.overflows, 0U);
+	zassert_equal(dropped_samples, 0U);
+
+	/* Only the filling ring half and a partial batch still wait for delivery. */
+	zassert_true(captured_count <= stats.samples_generated &&
+			     captured_count + WAKE_SAMPLES + FIFO_BATCH > stats.samples_generated,
+		     "%u delivered of %u acquired", (unsigned int)captured_count,
+		     (unsigned int)stats.samples_generated);
+	for (size_t index = 1; index < captured_count; ++index) {
+		zassert_equal(decode_sample(captured_words[index]) -
+				      decode_sample(captured_words[index - 1U]),
+			      257, "sample %u is out of order", (unsigned int)index);
+	}
+}
+
+ZTEST(max30003, test_dma_overflow_loss_is_exact_and_timestamps_continue)
+{
+	struct max30003_emul_stats stats;
+	size_t accounted;
+	float gap_ms;
+
+	/* One ring half completes on a timed edge before the edges stop starting bursts. */
+	max30003_emul_start_clock(max30003_emul);
+	k_sleep(K_MSEC(300));
+	max30003_dma_emul_set_edges_missed(true);
+	k_sleep(K_MSEC(200));
+	max30003_dma_emul_set_edges_missed(false);
+	k_sleep(OVERFLOW_SETTLE);
+	max30003_emul_stop_clock(max30003_emul);
+	k_sleep(SERVICE_SETTLE);
+
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.overflows, 1U, "the missed edges did not overflow the FIFO once");
+	zassert_true(dropped_samples > FIFO_DEPTH);
+	zassert_equal(dropped_samples, stats.samples_discarded,
+		      "reported %u lost samples, the emulator discarded %u",
+		      (unsigned int)dropped_samples, (unsigned int)stats.samples_discarded);
+
+	/* Delivered plus dropped covers every acquired sample but the filling ring half. */
+	accounted = captured_count + dropped_samples;
+	zassert_true(accounted <= stats.samples_generated &&
+			     accounted + WAKE_SAMPLES + FIFO_BATCH > stats.samples_generated,
+		     "%u delivered and %u dropped of %u acquired", (unsigned int)captured_count,
+		     (unsigned int)dropped_samples, (unsigned int)stats.samples_generated);
+
+	/* The first sample after the gap sits where the lost samples would have ended. */
+	zassert_true(gap_position > 0U && gap_position < captured_count);
+	gap_ms = (float)(captured_timestamps[gap_position] -
+			 captured_timestamps[gap_position - 1U]);
+	zassert_within(gap_ms, (float)(dropped_samples + 1U) * SAMPLE_PERIOD_MS, 1.5f);
+}
+
+#else
+
+ZTEST(max30003, test_overflow_loss_is_exact_and_timestamps_continue)
+{
+	struct max30003_emul_stats stats;
+	size_t accounted;
+	float gap_ms;
+
+	atomic_set(&stall_next_block, 1);
+	max30003_emul_start_clock(max30003_emul);
+	k_sleep(K_MSEC(700));
+	max30003_emul_stop_clock(max30003_emul);
+	k_sleep(SERVICE_SETTLE);
+
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.overflows, 1U, "the stall did not overflow the FIFO once");
+	zassert_true(dropped_samples > FIFO_DEPTH);
+	zassert_equal(dropped_samples, stats.samples_discarded,
+		      "reported %u lost samples, the emulator discarded %u",
+		      (unsigned int)dropped_samples, (unsigned int)stats.samples_discarded);
+
+	/* Delivered plus dropped covers every acquired sample but a partial batch. */
+	accounted = captured_count + dropped_samples;
+	zassert_true(accounted <= stats.samples_generated &&
+			     accounted + FIFO_BATCH > stats.samples_generated,
+		     "%u delivered and %u dropped of %u acquired", (unsigned int)captured_count,
+		     (unsigned int)dropped_samples, (unsigned int)stats.samples_generated);
+
+	/* The first sample after the gap sits where the lost samples would have ended. */
+	zassert_true(gap_position > 0U && gap_position < captured_count);
+	gap_ms = (float)(captured_timestamps[gap_position] -
+			 captured_timestamps[gap_position - 1U]);
+	zassert_within(gap_ms, (float)(dropped_samples + 1U) * SAMPLE_PERIOD_MS, 1.5f);
+}
+
+#endif /* CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA */
+
+ZTEST(max30003, test_fast_recovery_tags_reach_the_application)
+{
+	max30003_emul_set_fast_recovery(max30003_emul, true);
+	acquire(WAKE_SAMPLES);
+
+	zassert_equal(captured_count, WAKE_SAMPLES);
+	for (size_t index = 0; index < captured_count; ++index) {
+		uint32_t etag = FIELD_GET(ETAG_FIELD, captured_words[index]);
+
+		zassert_true(etag == ETAG_FAST || etag == ETAG_FAST_LAST,
+			     "sample %u lost its fast-recovery tag", (unsigned int)index);
+	}
+}
+
+ZTEST(max30003, test_lead_off_is_decoded_from_the_fifo_service)
+{
+	max30003_emul_set_lead_off(max30003_emul, BIT(0));
+	acquire(WAKE_SAMPLES);
+	zassert_equal(last_lead_status, MAX30003_LEAD_STATUS_NEGATIVE_OFF);
+
+	max30003_emul_set_lead_off(max30003_emul, BIT(2) | BIT(0));
+	acquire(WAKE_SAMPLES);
+	zassert_equal(last_lead_status, MAX30003_LEAD_STATUS_BOTH_OFF);
+
+	max30003_emul_set_lead_off(max30003_emul, 0U);
+	acquire(WAKE_SAMPLES);
+	zassert_equal(last_lead_status, MAX30003_LEAD_STATUS_GOOD);
+}
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_RTOR)
+
+ZTEST(max30003, test_rtor_intervals_are_forwarded)
+{
+	size_t reported;
+
+	/* The first interval after a restart may be discarded as unprimed. */
+	max30003_emul_report_rr(max30003_emul, 100U);
+	k_sleep(SERVICE_SETTLE);
+	reported = rr_interval_count;
+
+	max30003_emul_report_rr(max30003_emul, 110U);
+	k_sleep(SERVICE_SETTLE);
+	zassert_equal(rr_interval_count, reported + 1U);
+	zassert_within(last_rr_interval_ms, 110.0f * RTOR_TICK_MS, 0.001f);
+}
+
+#endif /* CONFIG_TINYCARDIA_MAX30003_RTOR */
+
+ZTEST(max30003, test_register_shadow_skips_redundant_writes)
+{
+	struct max30003_emul_stats stats;
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_ACQUISITION_DMA)
+	/* DMA capture fixed its burst length at init. */
+	zassert_equal(max30003_set_fifo_threshold(FIFO_BATCH), -ENOTSUP);
+#else
+	/* An unchanged FIFO threshold is already known to the driver. */
+	zassert_ok(max30003_set_fifo_threshold(FIFO_BATCH));
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.spi_transactions, 0U);
+
+	/* A changed threshold is written once and verified once. */
+	zassert_ok(max30003_set_fifo_threshold(FIFO_BATCH / 2U));
+	zassert_ok(max30003_set_fifo_threshold(FIFO_BATCH));
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.spi_transactions, 2U * 2U);
+	zassert_equal(max30003_emul_get_register(max30003_emul, REG_MNGR_INT), 0x7f0004U);
+#endif
+
+	/* Stop is CNFG_GEN and FIFO_RST; start is CNFG_GEN and SYNCH, which empties the FIFO. */
+	max30003_emul_reset_stats(max30003_emul);
+	zassert_ok(max30003_set_monitoring(false));
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.spi_transactions, 2U);
+	zassert_ok(max30003_set_monitoring(true));
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.spi_transactions, 2U + 2U);
+	zassert_equal(max30003_emul_get_register(max30003_emul, REG_CNFG_GEN), 0x081213U);
+
+	/* An explicit write always reaches the device. */
+	max30003_emul_reset_stats(max30003_emul);
+	zassert_ok(max30003_write_register(REG_MNGR_INT, 0x7f0004U));
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.spi_transactions, 1U);
+}
+
+ZTEST(max30003, test_stopped_monitoring_produces_no_samples)
+{
+	zassert_ok(max30003_set_monitoring(false));
+	zassert_equal(max30003_emul_get_register(max30003_emul, REG_CNFG_GEN) & CNFG_GEN_EN_ECG,
+		      0U);
+	acquire(FIFO_BATCH);
+	zassert_equal(captured_count, 0U);
+
+	zassert_ok(max30003_set_monitoring(true));
+	acquire(WAKE_SAMPLES);
+	zassert_equal(captured_count, WAKE_SAMPLES);
+}
+
+ZTEST(max30003, test_real_time_clock_delivers_256_hz)
+{
+	max30003_emul_start_clock(max30003_emul);
+	k_sleep(K_SECONDS(1));
+	max30003_emul_stop_clock(max30003_emul);
+	k_sleep(SERVICE_SETTLE);
+
+	/* Up to one partial wakeup may still wait in the FIFO or the capture ring. */
+	zassert_true(captured_count >= 256U - WAKE_SAMPLES && captured_count <= 256U,
+		     "one second produced %u samples", (unsigned int)captured_count);
+	zassert_true(captured_blocks <= 256U / FIFO_BATCH, "more than one wakeup per batch");
+	zassert_equal(dropped_samples, 0U);
+}
+
+#if defined(CONFIG_TINYCARDIA_MAX30003_DEDICATED_WORK_QUEUE)
+
+ZTEST(max30003, test_system_work_queue_stall_does_not_delay_fifo_service)
+{
+	struct max30003_fifo_service_stats service;
+	struct max30003_emul_stats stats;
+
+	max30003_reset_fifo_service_stats();
+	max30003_emul_start_clock(max30003_emul);
+	k_sleep(K_MSEC(100));
+	zassert_true(k_work_submit(&stall_work) >= 0);
+	k_sleep(K_MSEC(500));
+	max30003_emul_stop_clock(max30003_emul);
+	k_sleep(SERVICE_SETTLE);
+
+	max30003_emul_get_stats(max30003_emul, &stats);
+	zassert_equal(stats.overflows, 0U, "FIFO service waited behind the system work queue");
+	zassert_equal(dropped_samples, 0U);
+	zassert_true(captured_count + WAKE_SAMPLES >= stats.samples_generated);
+
+	/* Every batch was serviced well inside the 16 samples of FIFO headroom. */
+	max30003_get_fifo_service_stats(&service);
+	zassert_true(service.services > 0U);
+	zassert_true(service.max_latency_us <= 62500U / 2U, "worst FIFO service latency %u us",
+		     (unsigned int)service.max_latency_us);
+}
+
+#endif /* CONFIG_TINYCARDIA_MAX30003_DEDICATED_WORK_QUEUE */
+
+ZTEST_SUITE(max30003, NULL, max30003_suite_setup, max30003_before, NULL, NULL);
@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: MIT */
+
+/*
+ * native_sim stand-in for the SPIM, TIMER, GPIOTE, and PPI half of
+ * src/max30003_dma.c; the burst ring itself is src/max30003_dma_ring.c.
+ *
+ * An INT1 edge reads one burst over the emulated SPI bus at once, as the
+ * PPI-started SPIM would, into the ring's next record. Completing a half runs
+ * the ready handler as the capture TIMER ISR does. Bursts take no time here,
+ * so pause never finds one in flight, and a half is timed at the edge of its
+ * last burst.
+ */
+
+#include "max30003_dma.h"
+#include "max30003_dma_emul.h"
+#include "max30003_dma_ring.h"
+
+#include <errno.h>
+
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#define DMA_EMUL_NODE DT_NODELABEL(max30003)
+
+static const struct spi_dt_spec dma_emul_spi = SPI_DT_SPEC_GET(
+	DMA_EMUL_NODE, SPI_OP_MODE_MASTER | SPI_TRANSFER_MSB | SPI_WORD_SET(8));
+static const struct gpio_dt_spec dma_emul_int1 = GPIO_DT_SPEC_GET(DMA_EMUL_NODE, int_gpios);
+
+static struct gpio_callback int1_callback;
+static max30003_dma_ready_handler_t ready_callback;
+static uint8_t burst_command;
+/* Bursts of the active half, as counted by the capture TIMER. */
+static uint32_t burst_count;
+static bool armed;
+static bool paused;
+static bool edges_missed;
+static bool initialized;
+
+/*
+ * One SPIM burst started by INT1 at edge_ticks, or -1 when started on resume,
+ * then the TIMER count that follows its END event.
+ */
+static void capture_burst(int64_t edge_ticks)
+{
+	const struct spi_buf tx_buf = {
+		.buf = &burst_command,
+		.len = sizeof(burst_command),
+	};
+	const struct spi_buf rx_buf = {
+		.buf = max30003_dma_ring_burst(max30003_dma_ring_active_half(), burst_count),
+		.len = max30003_dma_ring_record_size(),
+	};
+	const struct spi_buf_set tx = {
+		.buffers = &tx_buf,
+		.count = 1,
+	};
+	const struct spi_buf_set rx = {
+		.buffers = &rx_buf,
+		.count = 1,
+	};
+
+	if (spi_transceive_dt(&dma_emul_spi, &tx, &rx) < 0) {
+		return;
+	}
+	if (++burst_count < MAX30003_DMA_BURSTS_PER_HALF) {
+		return;
+	}
+
+	burst_count = 0U;
+	(void)max30003_dma_ring_complete_half(edge_ticks);
+	ready_callback();
+}
+
+static void start_burst_if_int1_active(void)
+{
+	if (gpio_pin_get_dt(&dma_emul_int1) > 0) {
+		capture_burst(-1);
+	}
+}
+
+static void int1_edge(const struct device *port, struct gpio_callback *callback,
+		      gpio_port_pins_t pins)
+{
+	ARG_UNUSED(port);
+	ARG_UNUSED(callback);
+	ARG_UNUSED(pins);
+
+	/* The PPI trigger channel is disabled while capture is paused. */
+	if (armed && !paused && !edges_missed) {
+		capture_burst(k_uptime_ticks());
+	}
+}
+
+int max30003_dma_init(max30003_dma_ready_handler_t ready_handler, uint8_t command,
+		      size_t burst_words)
+{
+	int err;
+
+	if (ready_handler == NULL || burst_words == 0U ||
+	    burst_words > MAX30003_DMA_MAX_BURST_WORDS) {
+		return -EINVAL;
+	}
+	if (initialized) {
+		return -EALREADY;
+	}
+
+	ready_callback = ready_handler;
+	burst_command = command;
+	max30003_dma_ring_init(burst_words);
+	gpio_init_callback(&int1_callback, int1_edge, BIT(dma_emul_int1.pin));
+	err = gpio_add_callback(dma_emul_int1.port, &int1_callback);
+	if (err < 0) {
+		return err;
+	}
+	err = gpio_pin_interrupt_configure_dt(&dma_emul_int1, GPIO_INT_EDGE_TO_ACTIVE);
+	if (err < 0) {
+		return err;
+	}
+	initialized = true;
+
+	return 0;
+}
+
+int max30003_dma_start(void)
+{
+	if (!initialized) {
+		return -EACCES;
+	}
+	if (armed) {
+		return 0;
+	}
+
+	max30003_dma_ring_reset();
+	burst_count = 0U;
+	armed = true;
+	max30003_dma_resume();
+
+	return 0;
+}
+
+void max30003_dma_stop(void)
+{
+	if (!armed) {
+		return;
+	}
+
+	max30003_dma_pause();
+	armed = false;
+	max30003_dma_ring_discard();
+}
+
+void max30003_dma_pause(void)
+{
+	if (armed) {
+		paused = true;
+	}
+}
+
+void max30003_dma_resume(void)
+{
+	if (!armed) {
+		return;
+	}
+
+	paused = false;
+	start_burst_if_int1_active();
+}
+
+uint32_t max30003_dma_position(void)
+{
+	return max30003_dma_ring_position(burst_count);
+}
+
+uint32_t max30003_dma_take_overrun_words(void)
+{
+	return max30003_dma_ring_take_overrun_words();
+}
+
+void max30003_dma_drain(max30003_dma_burst_handler_t handler, uint32_t position)
+{
+	max30003_dma_ring_drain(handler, position);
+}
+
+void max30003_dma_emul_set_edges_missed(bool missed)
+{
+	edges_missed = missed;
+}
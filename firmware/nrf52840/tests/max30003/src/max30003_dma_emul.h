@@ -0,0 +1,14 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TINYCARDIA_MAX30003_DMA_EMUL_H_
+#define TINYCARDIA_MAX30003_DMA_EMUL_H_
+
+#include <stdbool.h>
+
+/*
+ * Ignore INT1 edges, as a PPI trigger that failed to fire would, so the FIFO
+ * fills and overflows while capture stays armed.
+ */
+void max30003_dma_emul_set_edges_missed(bool missed);
+
+#endif /* TINYCARDIA_MAX30003_DMA_EMUL_H_ */
@@ -0,0 +1,482 @@
+/* SPDX-License-Identifier: MIT */
+
+#include "max30003_emul.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#define DT_DRV_COMPAT maxim_max30003
+
+#define EMUL_REG_COUNT      0x30U
+#define EMUL_REG_STATUS     0x01U
+#define EMUL_REG_EN_INT     0x02U
+#define EMUL_REG_MNGR_INT   0x04U
+#define EMUL_REG_SW_RST     0x08U
+#define EMUL_REG_SYNCH      0x09U
+#define EMUL_REG_FIFO_RST   0x0aU
+#define EMUL_REG_INFO       0x0fU
+#define EMUL_REG_CNFG_GEN   0x10U
+#define EMUL_REG_ECG_BURST  0x20U
+#define EMUL_REG_ECG_FIFO   0x21U
+#define EMUL_REG_RTOR       0x25U
+
+#define EMUL_STATUS_EINT     BIT(23)
+#define EMUL_STATUS_EOVF     BIT(22)
+#define EMUL_STATUS_DCLOFFINT BIT(19)
+#define EMUL_STATUS_RRINT    BIT(10)
+#define EMUL_STATUS_LDOFF    GENMASK(3, 0)
+#define EMUL_EN_INT_EN_EINT  BIT(23)
+#define EMUL_EN_INT_EN_DCLOFFINT BIT(19)
+#define EMUL_EN_INT_EN_RRINT BIT(10)
+#define EMUL_MNGR_INT_EFIT   GENMASK(23, 19)
+#define EMUL_CNFG_GEN_EN_ECG BIT(19)
+#define EMUL_RTOR_INTERVAL   GENMASK(23, 10)
+
+#define EMUL_FIFO_DEPTH      32U
+#define EMUL_SAMPLE_MASK     0x3ffffU
+#define EMUL_SAMPLE_SHIFT    6U
+#define EMUL_ETAG_SHIFT      3U
+#define EMUL_ETAG_VALID      0U
+#define EMUL_ETAG_FAST       1U
+#define EMUL_ETAG_VALID_LAST 2U
+#define EMUL_ETAG_FAST_LAST  3U
+#define EMUL_ETAG_EMPTY      6U
+#define EMUL_ETAG_OVF        7U
+/* The MAX30003 has no pace channel, so PTAG always reads as invalid. */
+#define EMUL_PTAG_NONE       7U
+#define EMUL_INFO_VALUE      0x513000U
+#define EMUL_SAMPLE_RATE_HZ  256U
+/*
+ * The clock derives samples from the tick count. At a tick rate that is a
+ * multiple of 256 Hz it fires exactly once per sample; otherwise every tick.
+ */
+#define EMUL_CLOCK_PERIOD_TICKS                                                            \
+	(CONFIG_SYS_CLOCK_TICKS_PER_SEC % EMUL_SAMPLE_RATE_HZ == 0 ?                       \
+		 CONFIG_SYS_CLOCK_TICKS_PER_SEC / EMUL_SAMPLE_RATE_HZ : 1)
+#define EMUL_MAX_TRANSFER    128U
+
+struct max30003_emul_config {
+	struct gpio_dt_spec int1;
+};
+
+struct max30003_emul_data {
+	const struct emul *emul;
+	struct k_spinlock lock;
+	struct k_timer sample_clock;
+	int64_t clock_start_ticks;
+	uint64_t clock_samples;
+	uint32_t registers[EMUL_REG_COUNT];
+	uint32_t fifo[EMUL_FIFO_DEPTH];
+	bool fifo_fast[EMUL_FIFO_DEPTH];
+	size_t fifo_head;
+	size_t fifo_count;
+	bool fifo_overflow;
+	bool fast_recovery;
+	const int32_t *samples;
+	size_t sample_count;
+	size_t sample_index;
+	struct max30003_emul_stats stats;
+};
+
+static void reset_fifo(struct max30003_emul_data *data)
+{
+	/* Samples still in the FIFO are never read. */
+	data->stats.samples_discarded += data->fifo_count;
+	data->fifo_head = 0U;
+	data->fifo_count = 0U;
+	data->fifo_overflow = false;
+}
+
+static void reset_registers(struct max30003_emul_data *data)
+{
+	memset(data->registers, 0, sizeof(data->registers));
+	data->registers[EMUL_REG_EN_INT] = 0x000003U;
+	data->registers[EMUL_REG_MNGR_INT] = 0x7f0004U;
+	data->registers[EMUL_REG_INFO] = EMUL_INFO_VALUE;
+	data->registers[EMUL_REG_CNFG_GEN] = 0x080004U;
+	reset_fifo(data);
+}
+
+static uint32_t status_locked(const struct max30003_emul_data *data)
+{
+	uint32_t status = data->registers[EMUL_REG_STATUS];
+	size_t threshold = FIELD_GET(EMUL_MNGR_INT_EFIT, data->registers[EMUL_REG_MNGR_INT]) + 1U;
+
+	status &= ~(EMUL_STATUS_EINT | EMUL_STATUS_EOVF);
+	if (data->fifo_overflow) {
+		status |= EMUL_STATUS_EINT | EMUL_STATUS_EOVF;
+	} else if (data->fifo_count >= threshold) {
+		status |= EMUL_STATUS_EINT;
+	}
+
+	return status;
+}
+
+static bool int1_active_locked(const struct max30003_emul_data *data)
+{
+	uint32_t status = status_locked(data);
+	uint32_t enabled = data->registers[EMUL_REG_EN_INT];
+
+	return ((status & EMUL_STATUS_EINT) != 0U && (enabled & EMUL_EN_INT_EN_EINT) != 0U) ||
+	       ((status & EMUL_STATUS_DCLOFFINT) != 0U &&
+		(enabled & EMUL_EN_INT_EN_DCLOFFINT) != 0U) ||
+	       ((status & EMUL_STATUS_RRINT) != 0U && (enabled & EMUL_EN_INT_EN_RRINT) != 0U);
+}
+
+/* Drive the open-drain INT1 line; the GPIO emulator raises edges on changes. */
+static void update_int1(const struct emul *target, bool active)
+{
+	const struct max30003_emul_config *config = target->cfg;
+
+	/* The pin is unconfigured until the driver initializes, so errors are expected. */
+	(void)gpio_emul_input_set(config->int1.port, config->int1.pin, active ? 0 : 1);
+}
+
+static uint32_t pop_fifo_word_locked(struct max30003_emul_data *data)
+{
+	uint32_t word;
+	bool fast;
+	bool last;
+
+	if (data->fifo_overflow) {
+		return (EMUL_ETAG_OVF << EMUL_ETAG_SHIFT) | EMUL_PTAG_NONE;
+	}
+	if (data->fifo_count == 0U) {
+		return (EMUL_ETAG_EMPTY << EMUL_ETAG_SHIFT) | EMUL_PTAG_NONE;
+	}
+
+	word = data->fifo[data->fifo_head];
+	fast = data->fifo_fast[data->fifo_head];
+	data->fifo_head = (data->fifo_head + 1U) % EMUL_FIFO_DEPTH;
+	--data->fifo_count;
+	++data->stats.fifo_words_read;
+
+	/* The end-of-file tag marks the last sample present at read time. */
+	last = data->fifo_count == 0U;
+	if (fast) {
+		word |= (last ? EMUL_ETAG_FAST_LAST : EMUL_ETAG_FAST) << EMUL_ETAG_SHIFT;
+	} else {
+		word |= (last ? EMUL_ETAG_VALID_LAST : EMUL_ETAG_VALID) << EMUL_ETAG_SHIFT;
+	}
+
+	return word;
+}
+
+static void write_register_locked(struct max30003_emul_data *data, uint8_t reg, uint32_t value)
+{
+	switch (reg) {
+	case EMUL_REG_SW_RST:
+		reset_registers(data);
+		break;
+	case EMUL_REG_SYNCH:
+	case EMUL_REG_FIFO_RST:
+		reset_fifo(data);
+		break;
+	case EMUL_REG_STATUS:
+	case EMUL_REG_INFO:
+	case EMUL_REG_RTOR:
+		/* Read-only. */
+		break;
+	default:
+		if (reg < EMUL_REG_COUNT) {
+			data->registers[reg] = value & 0xffffffU;
+		}
+		break;
+	}
+}
+
+static uint32_t read_register_locked(struct max30003_emul_data *data, uint8_t reg)
+{
+	uint32_t value;
+
+	switch (reg) {
+	case EMUL_REG_STATUS:
+		value = status_locked(data);
+		/* RRINT and DCLOFFINT clear on a STATUS read once their condition ends. */
+		data->registers[EMUL_REG_STATUS] &= ~EMUL_STATUS_RRINT;
+		if ((data->registers[EMUL_REG_STATUS] & EMUL_STATUS_LDOFF) == 0U) {
+			data->registers[EMUL_REG_STATUS] &= ~EMUL_STATUS_DCLOFFINT;
+		}
+		return value;
+	case EMUL_REG_ECG_BURST:
+	case EMUL_REG_ECG_FIFO:
+		return pop_fifo_word_locked(data);
+	default:
+		return reg < EMUL_REG_COUNT ? data->registers[reg] : 0U;
+	}
+}
+
+static int max30003_emul_io(const struct emul *target, const struct spi_config *config,
+			    const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs)
+{
+	struct max30003_emul_data *data = target->data;
+	uint8_t tx[EMUL_MAX_TRANSFER] = { 0 };
+	uint8_t rx[EMUL_MAX_TRANSFER] = { 0 };
+	size_t tx_length = 0U;
+	size_t rx_length = 0U;
+	size_t length;
+	k_spinlock_key_t key;
+	bool int1_active;
+	uint8_t reg;
+
+	ARG_UNUSED(config);
+
+	for (size_t index = 0; tx_bufs != NULL && index < tx_bufs->count; ++index) {
+		const struct spi_buf *buf = &tx_bufs->buffers[index];
+
+		if (tx_length + buf->len > sizeof(tx)) {
+			return -ENOMEM;
+		}
+		if (buf->buf != NULL) {
+			memcpy(&tx[tx_length], buf->buf, buf->len);
+		}
+		tx_length += buf->len;
+	}
+	for (size_t index = 0; rx_bufs != NULL && index < rx_bufs->count; ++index) {
+		rx_length += rx_bufs->buffers[index].len;
+	}
+	length = MAX(tx_length, rx_length);
+	if (length == 0U || length > sizeof(rx)) {
+		return -EINVAL;
+	}
+
+	reg = tx[0] >> 1;
+	key = k_spin_lock(&data->lock);
+	++data->stats.spi_transactions;
+	data->stats.spi_bytes += length;
+	if ((tx[0] & 1U) == 0U) {
+		if (length >= 4U) {
+			write_register_locked(data, reg, sys_get_be24(&tx[1]));
+		}
+	} else {
+		/* A burst continues with one FIFO word per further 24 clocks. */
+		for (size_t offset = 1U; offset + 3U <= length; offset += 3U) {
+			sys_put_be24(read_register_locked(data, reg), &rx[offset]);
+			if (reg != EMUL_REG_ECG_BURST) {
+				break;
+			}
+		}
+	}
+	int1_active = int1_active_locked(data);
+	k_spin_unlock(&data->lock, key);
+
+	for (size_t index = 0, offset = 0; rx_bufs != NULL && index < rx_bufs->count; ++index) {
+		const struct spi_buf *buf = &rx_bufs->buffers[index];
+
+		if (buf->buf != NULL) {
+			memcpy(buf->buf, &rx[offset], buf->len);
+		}
+		offset += buf->len;
+	}
+	update_int1(target, int1_active);
+
+	return 0;
+}
+
+static void acquire_sample_locked(struct max30003_emul_data *data)
+{
+	int32_t sample = 0;
+	size_t tail;
+
+	if ((data->registers[EMUL_REG_CNFG_GEN] & EMUL_CNFG_GEN_EN_ECG) == 0U) {
+		return;
+	}
+	if (data->samples != NULL && data->sample_count > 0U) {
+		sample = data->samples[data->sample_index];
+		data->sample_index = (data->sample_index + 1U) % data->sample_count;
+	}
+	++data->stats.samples_generated;
+
+	if (data->fifo_overflow) {
+		++data->stats.samples_discarded;
+		return;
+	}
+	if (data->fifo_count == EMUL_FIFO_DEPTH) {
+		data->fifo_overflow = true;
+		++data->stats.overflows;
+		++data->stats.samples_discarded;
+		return;
+	}
+
+	tail = (data->fifo_head + data->fifo_count) % EMUL_FIFO_DEPTH;
+	data->fifo[tail] = (((uint32_t)sample & EMUL_SAMPLE_MASK) << EMUL_SAMPLE_SHIFT) |
+			   EMUL_PTAG_NONE;
+	data->fifo_fast[tail] = data->fast_recovery;
+	++data->fifo_count;
+}
+
+void max30003_emul_advance(const struct emul *target, size_t count)
+{
+	struct max30003_emul_data *data = target->data;
+
+	for (size_t index = 0; index < count; ++index) {
+		k_spinlock_key_t key = k_spin_lock(&data->lock);
+		bool int1_active;
+
+		acquire_sample_locked(data);
+		int1_active = int1_active_locked(data);
+		k_spin_unlock(&data->lock, key);
+
+		/* Each sample may cross the threshold, exactly as on the real pin. */
+		update_int1(target, int1_active);
+	}
+}
+
+static void sample_clock_expired(struct k_timer *timer)
+{
+	struct max30003_emul_data *data =
+		CONTAINER_OF(timer, struct max30003_emul_data, sample_clock);
+	uint64_t due;
+
+	due = ((uint64_t)(k_uptime_ticks() - data->clock_start_ticks) * EMUL_SAMPLE_RATE_HZ) /
+	      CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	max30003_emul_advance(data->emul, (size_t)(due - data->clock_samples));
+	data->clock_samples = due;
+}
+
+void max30003_emul_start_clock(const struct emul *target)
+{
+	struct max30003_emul_data *data = target->data;
+
+	data->clock_start_ticks = k_uptime_ticks();
+	data->clock_samples = 0U;
+	k_timer_start(&data->sample_clock, K_TICKS(EMUL_CLOCK_PERIOD_TICKS),
+		      K_TICKS(EMUL_CLOCK_PERIOD_TICKS));
+}
+
+void max30003_emul_stop_clock(const struct emul *target)
+{
+	struct max30003_emul_data *data = target->data;
+
+	k_timer_stop(&data->sample_clock);
+}
+
+void max30003_emul_set_samples(const struct emul *target, const int32_t *samples,
+			       size_t count)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	data->samples = samples;
+	data->sample_count = samples != NULL ? count : 0U;
+	data->sample_index = 0U;
+	k_spin_unlock(&data->lock, key);
+}
+
+void max30003_emul_inject_overflow(const struct emul *target)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	bool int1_active;
+
+	data->fifo_overflow = true;
+	++data->stats.overflows;
+	int1_active = int1_active_locked(data);
+	k_spin_unlock(&data->lock, key);
+	update_int1(target, int1_active);
+}
+
+void max30003_emul_set_fast_recovery(const struct emul *target, bool enabled)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	data->fast_recovery = enabled;
+	k_spin_unlock(&data->lock, key);
+}
+
+void max30003_emul_set_lead_off(const struct emul *target, uint32_t ldoff_bits)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	uint32_t *status = &data->registers[EMUL_REG_STATUS];
+	bool int1_active;
+
+	*status = (*status & ~EMUL_STATUS_LDOFF) | (ldoff_bits & EMUL_STATUS_LDOFF);
+	if ((ldoff_bits & EMUL_STATUS_LDOFF) != 0U) {
+		*status |= EMUL_STATUS_DCLOFFINT;
+	}
+	int1_active = int1_active_locked(data);
+	k_spin_unlock(&data->lock, key);
+	update_int1(target, int1_active);
+}
+
+void max30003_emul_report_rr(const struct emul *target, uint32_t rtor_ticks)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	bool int1_active;
+
+	data->registers[EMUL_REG_RTOR] = FIELD_PREP(EMUL_RTOR_INTERVAL, rtor_ticks);
+	data->registers[EMUL_REG_STATUS] |= EMUL_STATUS_RRINT;
+	int1_active = int1_active_locked(data);
+	k_spin_unlock(&data->lock, key);
+	update_int1(target, int1_active);
+}
+
+uint32_t max30003_emul_get_register(const struct emul *target, uint8_t reg)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	uint32_t value = reg == EMUL_REG_STATUS ? status_locked(data) :
+			 reg < EMUL_REG_COUNT ? data->registers[reg] : 0U;
+
+	k_spin_unlock(&data->lock, key);
+
+	return value;
+}
+
+void max30003_emul_get_stats(const struct emul *target, struct max30003_emul_stats *stats)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	*stats = data->stats;
+	k_spin_unlock(&data->lock, key);
+}
+
+void max30003_emul_reset_stats(const struct emul *target)
+{
+	struct max30003_emul_data *data = target->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	memset(&data->stats, 0, sizeof(data->stats));
+	k_spin_unlock(&data->lock, key);
+}
+
+static int max30003_emul_init(const struct emul *target, const struct device *parent)
+{
+	struct max30003_emul_data *data = target->data;
+
+	ARG_UNUSED(parent);
+
+	data->emul = target;
+	reset_registers(data);
+	k_timer_init(&data->sample_clock, sample_clock_expired, NULL);
+
+	return 0;
+}
+
+static const struct spi_emul_api max30003_emul_api = {
+	.io = max30003_emul_io,
+};
+
+#define MAX30003_EMUL_DEFINE(n)                                                            \
+	static struct max30003_emul_data max30003_emul_data_##n;                           \
+	static const struct max30003_emul_config max30003_emul_config_##n = {              \
+		.int1 = GPIO_DT_SPEC_INST_GET(n, int_gpios),                               \
+	};                                                                                 \
+	EMUL_DT_INST_DEFINE(n, max30003_emul_init, &max30003_emul_data_##n,                \
+			    &max30003_emul_config_##n, &max30003_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(MAX30003_EMUL_DEFINE)
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: MIT */
+
+#ifndef TINYCARDIA_MAX30003_EMUL_H_
+#define TINYCARDIA_MAX30003_EMUL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/drivers/emul.h>
+
+/*
+ * SPI emulator for the MAX30003 on native_sim.
+ *
+ * The emulator serves the register map, keeps a 32-word ECG FIFO with the
+ * documented ETAG encoding, and drives INT1 through the GPIO emulator exactly
+ * as the open-drain, active-low pin would behave. Samples are produced either
+ * on demand with max30003_emul_advance() or at 256 Hz from a kernel timer.
+ */
+
+struct max30003_emul_stats {
+	uint32_t spi_transactions;
+	uint32_t spi_bytes;
+	uint32_t fifo_words_read;
+	uint32_t samples_generated;
+	uint32_t overflows;
+	/* Acquired samples never read: lost to a full FIFO or cleared by a reset. */
+	uint32_t samples_discarded;
+};
+
+/*
+ * Replay signed 18-bit samples, wrapping at the end. The array must remain
+ * valid while the emulator uses it; NULL produces a flat zero signal.
+ */
+void max30003_emul_set_samples(const struct emul *target, const int32_t *samples,
+			       size_t count);
+
+/* Acquire count samples immediately, as if count sample periods had elapsed. */
+void max30003_emul_advance(const struct emul *target, size_t count);
+
+/* Acquire samples in real time at 256 Hz until stopped. */
+void max30003_emul_start_clock(const struct emul *target);
+void max30003_emul_stop_clock(const struct emul *target);
+
+/*
+ * Put the FIFO into overflow until the driver writes FIFO_RST or SYNCH. No
+ * sample period elapses, so only the samples already in the FIFO are lost.
+ */
+void max30003_emul_inject_overflow(const struct emul *target);
+
+/* Tag subsequent samples as fast-recovery samples. */
+void max30003_emul_set_fast_recovery(const struct emul *target, bool enabled);
+
+/* Set the STATUS LDOFF bits (3:0); nonzero also asserts DCLOFFINT. */
+void max30003_emul_set_lead_off(const struct emul *target, uint32_t ldoff_bits);
+
+/* Report one R-to-R interval in RTOR ticks and assert RRINT. */
+void max30003_emul_report_rr(const struct emul *target, uint32_t rtor_ticks);
+
+uint32_t max30003_emul_get_register(const struct emul *target, uint8_t reg);
+void max30003_emul_get_stats(const struct emul *target, struct max30003_emul_stats *stats);
+void max30003_emul_reset_stats(const struct emul *target);
+
+#endif /* TINYCARDIA_MAX30003_EMUL_H_ */
@@ -0,0 +1,184 @@
+#include "model_aot.h"
+#include "model_inference.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#define SAMPLE_RATE_HZ 256.0f
+#define RANDOM_WINDOWS 4U
+
+/* The supplied partial reference: all RR values and the first ten ECG values. */
+static const int8_t known_ecg[] = {
+	-19, -33, -28, -30, -27, -27, -24, -26, -35, -37,
+};
+static const int8_t known_rr[] = {-18, -60, -67, -89, -23, -72, -45};
+
+static uint32_t random_state;
+
+static uint32_t next_random(void)
+{
+	random_state = random_state * 1103515245U + 12345U;
+	return random_state >> 16;
+}
+
+/*
+ * Run the TFLM interpreter on the window already in its ECG input tensor and
+ * the ahead-of-time graph on a copy of the same inputs, and require the exact
+ * same INT8 output. On native_sim both use the reference kernel arithmetic; in
+ * the cmsis_nn scenario both use the CMSIS-NN DSP kernels of a Cortex-M4.
+ */
+static void assert_engines_agree(const float *rr_features, int8_t *output, const char *label)
+{
+	struct tinycardia_model_result result;
+
+	memcpy(tinycardia_aot_ecg_input, tinycardia_model_ecg_input(),
+	       sizeof(tinycardia_aot_ecg_input));
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_RR_COUNT; ++index) {
+		tinycardia_aot_rr_input[index] =
+			tinycardia_model_quantize(rr_features[index], TINYCARDIA_MODEL_RR_SCALE,
+						  TINYCARDIA_MODEL_RR_ZERO_POINT);
+	}
+
+	zassert_ok(tinycardia_model_infer_quantized(rr_features, TINYCARDIA_MODEL_RR_COUNT,
+						    &result));
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		const struct tinycardia_aot_operator *op = &tinycardia_aot_operators[index];
+
+		if (op->invoke != NULL) {
+			zassert_ok(op->invoke(), "%s: operator %u (%s)", label,
+				   (unsigned int)index, op->name);
+		}
+	}
+
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_CLASS_COUNT; ++index) {
+		zassert_equal(tinycardia_aot_output[index], result.quantized_probabilities[index],
+			      "%s: output %u is %d, TFLM gives %d", label, (unsigned int)index,
+			      tinycardia_aot_output[index], result.quantized_probabilities[index]);
+		if (output != NULL) {
+			output[index] = tinycardia_aot_output[index];
+		}
+	}
+}
+
+ZTEST(model_aot, test_graph_metadata_and_plan)
+{
+	size_t conv_count = 0U;
+
+	zassert_ok(tinycardia_aot_prepare());
+	zassert_true(tinycardia_aot_arena_size > 0U);
+	zassert_equal((uintptr_t)tinycardia_aot_arena % 16U, 0U);
+	zassert_true(tinycardia_aot_output >= tinycardia_aot_arena &&
+		     tinycardia_aot_output + TINYCARDIA_MODEL_CLASS_COUNT <=
+			     tinycardia_aot_arena + tinycardia_aot_arena_size);
+	/* The plan must not need more than the interpreter's own arena. */
+	zassert_true(tinycardia_aot_arena_size < tinycardia_model_arena_used_bytes(),
+		     "AOT arena %u bytes, TFLM %u", (unsigned int)tinycardia_aot_arena_size,
+		     (unsigned int)tinycardia_model_arena_used_bytes());
+
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		const struct tinycardia_aot_operator *op = &tinycardia_aot_operators[index];
+
+		zassert_not_null(op->name);
+		if (strcmp(op->name, "CONV_2D") == 0) {
+			++conv_count;
+		}
+		/* Only shape changes are folded away. */
+		zassert_equal(op->invoke == NULL,
+			      strcmp(op->name, "RESHAPE") == 0 ||
+				      strcmp(op->name, "EXPAND_DIMS") == 0,
+			      "operator %u (%s)", (unsigned int)index, op->name);
+	}
+	zassert_equal(conv_count, 3U);
+	zassert_str_equal(tinycardia_aot_operators[TINYCARDIA_MODEL_OPERATOR_COUNT - 1U].name,
+			  "SOFTMAX");
+}
+
+ZTEST(model_aot, test_zero_input_sentinel_matches_tflm)
+{
+	static const float rr_features[TINYCARDIA_MODEL_RR_COUNT];
+	int8_t *ecg = tinycardia_model_ecg_input();
+	int8_t output[TINYCARDIA_MODEL_CLASS_COUNT];
+
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+		ecg[index] = TINYCARDIA_MODEL_ECG_ZERO_POINT;
+	}
+	assert_engines_agree(rr_features, output, "zero input");
+	/* Independent LiteRT 2.2.0 oracle, as in the model_inference suite. */
+	zassert_equal(output[0], -49);
+	zassert_equal(output[1], 49);
+}
+
+ZTEST(model_aot, test_known_partial_reference_matches_tflm)
+{
+	float rr_features[TINYCARDIA_MODEL_RR_COUNT];
+	int8_t *ecg = tinycardia_model_ecg_input();
+
+	/* The 2,550 missing ECG values stay at the zero point rather than invented. */
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+		ecg[index] = index < ARRAY_SIZE(known_ecg) ? known_ecg[index]
+							   : TINYCARDIA_MODEL_ECG_ZERO_POINT;
+	}
+	for (size_t index = 0U; index < ARRAY_SIZE(known_rr); ++index) {
+		rr_features[index] =
+			tinycardia_model_dequantize(known_rr[index], TINYCARDIA_MODEL_RR_SCALE,
+						    TINYCARDIA_MODEL_RR_ZERO_POINT);
+	}
+	assert_engines_agree(rr_features, NULL, "partial reference");
+}
+
+ZTEST(model_aot, test_deterministic_windows_match_tflm)
+{
+	/* Two-tone windows whose outputs stay away from saturation, and one that clips. */
+	static const float tones[][2] = {
+		{1.2f, 0.5f}, {1.7f, 1.0f}, {0.8f, 0.2f}, {2.5f, 2.0f}, {1.0f, 8.0f},
+	};
+	float rr_features[TINYCARDIA_MODEL_RR_COUNT];
+	int8_t *ecg = tinycardia_model_ecg_input();
+	char label[32];
+
+	for (size_t window = 0U; window < ARRAY_SIZE(tones); ++window) {
+		float frequency = tones[window][0];
+		float amplitude = tones[window][1];
+
+		for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+			float phase =
+				2.0f * 3.14159265f * frequency * (float)index / SAMPLE_RATE_HZ;
+			float value =
+				amplitude * (sinf(phase) + 0.3f * sinf(3.1f * phase));
+
+			ecg[index] = tinycardia_model_quantize(value, TINYCARDIA_MODEL_ECG_SCALE,
+							       TINYCARDIA_MODEL_ECG_ZERO_POINT);
+		}
+		for (size_t index = 0U; index < TINYCARDIA_MODEL_RR_COUNT; ++index) {
+			rr_features[index] = 0.3f * ((float)index - 3.0f) * (float)(window + 1U);
+		}
+		snprintk(label, sizeof(label), "tone window %u", (unsigned int)window);
+		assert_engines_agree(rr_features, NULL, label);
+	}
+
+	random_state = 0x7c1aU;
+	for (size_t window = 0U; window < RANDOM_WINDOWS; ++window) {
+		for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+			ecg[index] = (int8_t)next_random();
+		}
+		for (size_t index = 0U; index < TINYCARDIA_MODEL_RR_COUNT; ++index) {
+			rr_features[index] = tinycardia_model_dequantize(
+				(int8_t)next_random(), TINYCARDIA_MODEL_RR_SCALE,
+				TINYCARDIA_MODEL_RR_ZERO_POINT);
+		}
+		snprintk(label, sizeof(label), "random window %u", (unsigned int)window);
+		assert_engines_agree(rr_features, NULL, label);
+	}
+}
+
+static void *model_aot_setup(void)
+{
+	zassert_ok(tinycardia_model_init());
+	return NULL;
+}
+
+ZTEST_SUITE(model_aot, NULL, model_aot_setup, NULL, NULL, NULL);
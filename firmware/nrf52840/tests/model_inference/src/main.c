@@ -1,8 +1,10 @@
+#include "ecg_processing.h"
 #include "inference_policy.h"
 #include "model_inference.h"
 
 #include <errno.h>
 #include <math.h>
+#include <string.h>
 
 #include <zephyr/sys/util.h>
 #include <zephyr/ztest.h>
@@ -16,28 +18,52 @@ ZTEST(inference_policy, test_rejects_invalid_or_low_quality_windows)
 {
 	const uint32_t window_start_ms = 10000U;
 	const uint32_t good_before_window_ms = 9000U;
+	const enum ecg_signal_quality good_window = ECG_SIGNAL_QUALITY_GOOD;
 
 	zassert_true(tinycardia_inference_window_is_eligible(
-		true, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms, good_before_window_ms));
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms,
+		good_before_window_ms));
 	zassert_false(tinycardia_inference_window_is_eligible(
-		false, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms, good_before_window_ms));
+		false, good_window, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms,
+		good_before_window_ms));
 	zassert_false(tinycardia_inference_window_is_eligible(
-		true, TINYCARDIA_SIGNAL_QUALITY_POOR, window_start_ms, good_before_window_ms));
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_POOR, window_start_ms,
+		good_before_window_ms));
 	zassert_false(tinycardia_inference_window_is_eligible(
-		true, TINYCARDIA_SIGNAL_QUALITY_LEAD_OFF, window_start_ms, good_before_window_ms));
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_LEAD_OFF, window_start_ms,
+		good_before_window_ms));
 	zassert_false(tinycardia_inference_window_is_eligible(
-		true, TINYCARDIA_SIGNAL_QUALITY_UNKNOWN, window_start_ms, good_before_window_ms));
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_UNKNOWN, window_start_ms,
+		good_before_window_ms));
+	/* A poor window is still classified; an unusable one never is. */
+	zassert_true(tinycardia_inference_window_is_eligible(
+		true, ECG_SIGNAL_QUALITY_POOR, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms,
+		good_before_window_ms));
+	zassert_false(tinycardia_inference_window_is_eligible(
+		true, ECG_SIGNAL_QUALITY_UNUSABLE, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms,
+		good_before_window_ms));
 	/* Contact recovered after capture began: this window is contaminated. */
-	zassert_false(tinycardia_inference_window_is_eligible(true, TINYCARDIA_SIGNAL_QUALITY_GOOD,
-							      window_start_ms, 15000U));
+	zassert_false(tinycardia_inference_window_is_eligible(
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms, 15000U));
 	/* Contact may become good at the exact capture boundary. */
-	zassert_true(tinycardia_inference_window_is_eligible(true, TINYCARDIA_SIGNAL_QUALITY_GOOD,
-							     window_start_ms, window_start_ms));
+	zassert_true(tinycardia_inference_window_is_eligible(
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_GOOD, window_start_ms,
+		window_start_ms));
 	/* Expanded timestamp ordering remains valid across the 32-bit wire wrap. */
-	zassert_true(tinycardia_inference_window_is_eligible(true, TINYCARDIA_SIGNAL_QUALITY_GOOD,
-							     0x100000100ULL, 0x0fffffff0ULL));
-	zassert_false(tinycardia_inference_window_is_eligible(true, TINYCARDIA_SIGNAL_QUALITY_GOOD,
-							      0x0fffffff0ULL, 0x100000100ULL));
+	zassert_true(tinycardia_inference_window_is_eligible(
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_GOOD, 0x100000100ULL,
+		0x0fffffff0ULL));
+	zassert_false(tinycardia_inference_window_is_eligible(
+		true, good_window, TINYCARDIA_SIGNAL_QUALITY_GOOD, 0x0fffffff0ULL,
+		0x100000100ULL));
+}
+
+ZTEST(inference_policy, test_reported_quality_follows_the_window_sqi)
+{
+	zassert_equal(tinycardia_inference_reported_quality(ECG_SIGNAL_QUALITY_GOOD),
+		      TINYCARDIA_SIGNAL_QUALITY_GOOD);
+	zassert_equal(tinycardia_inference_reported_quality(ECG_SIGNAL_QUALITY_POOR),
+		      TINYCARDIA_SIGNAL_QUALITY_POOR);
 }
 
 ZTEST(model_quantization, test_zero_positive_negative_and_saturation)
@@ -115,13 +141,45 @@ ZTEST(model_quantization, test_output_dequantization_reference)
 		       0.99609375f, FLOAT_TOLERANCE);
 }
 
+static void assert_operator_profile(uint32_t invocations)
+{
+	static struct tinycardia_model_profile profile;
+#if defined(CONFIG_TINYCARDIA_MODEL_PROFILING)
+	size_t conv_count = 0U;
+
+	zassert_equal(tinycardia_model_get_profile(NULL), -EINVAL);
+	zassert_ok(tinycardia_model_get_profile(&profile));
+	/* The startup self-test is not part of the profile. */
+	zassert_equal(profile.invocations, invocations);
+	zassert_true(profile.cycles_per_second > 0U);
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_OPERATOR_COUNT; ++index) {
+		zassert_not_null(profile.operators[index].name, "operator %u is unnamed",
+				 (unsigned int)index);
+		if (strcmp(profile.operators[index].name, "CONV_2D") == 0) {
+			++conv_count;
+		}
+	}
+	zassert_true(conv_count > 0U);
+	zassert_str_equal(profile.operators[TINYCARDIA_MODEL_OPERATOR_COUNT - 1U].name,
+			  "SOFTMAX");
+#else
+	ARG_UNUSED(invocations);
+	zassert_equal(tinycardia_model_get_profile(&profile), -ENOTSUP);
+#endif
+}
+
 ZTEST(model_runtime, test_metadata_allocation_and_real_invoke)
 {
 	struct tinycardia_model_result result;
 	float probability_sum;
 	float selected_probability;
 	long expected_confidence;
+	int8_t *quantized_ecg_input;
+	uint8_t *scratch;
+	size_t scratch_size = 0U;
 
+	zassert_is_null(tinycardia_model_ecg_input());
+	zassert_is_null(tinycardia_model_scratch(&scratch_size));
 	zassert_ok(tinycardia_model_init(),
 		   "init validates schema, graph, names, shapes, types and quantization");
 	zassert_true(tinycardia_model_arena_used_bytes() > 0U);
@@ -161,6 +219,210 @@ ZTEST(model_runtime, test_metadata_allocation_and_real_invoke)
 	}
 	expected_confidence = lroundf(selected_probability * 10000.0f);
 	zassert_equal(result.confidence, expected_confidence);
+
+	/* Preprocessing may write the quantized window straight into the input tensor. */
+	quantized_ecg_input = tinycardia_model_ecg_input();
+	zassert_not_null(quantized_ecg_input);
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+		quantized_ecg_input[index] = TINYCARDIA_MODEL_ECG_ZERO_POINT;
+	}
+	zassert_ok(tinycardia_model_infer_quantized(rr_input, ARRAY_SIZE(rr_input), &result));
+	zassert_equal(result.quantized_probabilities[0], -49);
+	zassert_equal(result.quantized_probabilities[1], 49);
+	zassert_equal(result.confidence, 6914U);
+
+	/* Activation scratch holds preprocessing work between inferences. */
+	scratch = tinycardia_model_scratch(&scratch_size);
+	zassert_not_null(scratch);
+	zassert_true(scratch_size >= sizeof(struct ecg_processing_workspace),
+		     "only %u bytes of arena scratch", (unsigned int)scratch_size);
+	zassert_true(scratch + scratch_size <= (uint8_t *)quantized_ecg_input ||
+		     scratch >= (uint8_t *)quantized_ecg_input + TINYCARDIA_MODEL_ECG_COUNT);
+	memset(scratch, 0x5a, scratch_size);
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+		zassert_equal(quantized_ecg_input[index], TINYCARDIA_MODEL_ECG_ZERO_POINT);
+	}
+	zassert_ok(tinycardia_model_infer_quantized(rr_input, ARRAY_SIZE(rr_input), &result));
+	zassert_equal(result.quantized_probabilities[0], -49);
+	zassert_equal(result.quantized_probabilities[1], 49);
+
+	assert_operator_profile(3U);
+}
+
+/* Stream window in chunks of chunk_size samples and require the whole-window invoke's output. */
+static void assert_stream_matches(const int8_t *window, size_t chunk_size,
+				  const struct tinycardia_model_result *expected)
+{
+	struct tinycardia_model_result result;
+
+	for (size_t offset = 0U; offset < TINYCARDIA_MODEL_ECG_COUNT; offset += chunk_size) {
+		size_t count = MIN(chunk_size, TINYCARDIA_MODEL_ECG_COUNT - offset);
+
+		zassert_ok(tinycardia_model_stream_append(&window[offset], offset, count));
+	}
+	zassert_ok(tinycardia_model_stream_finish(rr_input, ARRAY_SIZE(rr_input), &result));
+	zassert_mem_equal(result.quantized_probabilities, expected->quantized_probabilities,
+			  sizeof(result.quantized_probabilities), "%u-sample chunks",
+			  (unsigned int)chunk_size);
+	zassert_equal(result.classification, expected->classification);
+	zassert_equal(result.confidence, expected->confidence);
+	/* A finished window is consumed. */
+	zassert_equal(tinycardia_model_stream_finish(rr_input, ARRAY_SIZE(rr_input), &result),
+		      -ENODATA);
+}
+
+ZTEST(model_runtime, test_streamed_windows_match_whole_invokes)
+{
+	static const size_t chunk_sizes[] = {256U, 100U, 7U, 2560U};
+	static int8_t window[TINYCARDIA_MODEL_ECG_COUNT];
+	struct tinycardia_model_result expected;
+	uint32_t random_state = 0x2f6bU;
+	int8_t *input;
+
+	if (!IS_ENABLED(CONFIG_TINYCARDIA_MODEL_STREAMING)) {
+		zassert_equal(tinycardia_model_stream_append(window, 0U, 1U), -ENOTSUP);
+		zassert_equal(tinycardia_model_stream_finish(rr_input, ARRAY_SIZE(rr_input),
+							     &expected),
+			      -ENOTSUP);
+		return;
+	}
+
+	input = tinycardia_model_ecg_input();
+	zassert_not_null(input);
+	zassert_equal(tinycardia_model_stream_append(NULL, 0U, 1U), -EINVAL);
+	zassert_ok(tinycardia_model_stream_append(window, 0U, 64U));
+	zassert_equal(tinycardia_model_stream_append(window, 32U, 32U), -EINVAL);
+	zassert_equal(tinycardia_model_stream_append(window, 64U, TINYCARDIA_MODEL_ECG_COUNT),
+		      -EINVAL);
+	zassert_equal(tinycardia_model_stream_finish(rr_input, ARRAY_SIZE(rr_input), &expected),
+		      -ENODATA);
+
+	for (size_t variant = 0U; variant < 3U; ++variant) {
+		for (size_t index = 0U; index < TINYCARDIA_MODEL_ECG_COUNT; ++index) {
+			float phase = 2.0f * 3.14159265f * 1.3f * (float)index / 256.0f;
+
+			if (variant == 0U) {
+				window[index] = TINYCARDIA_MODEL_ECG_ZERO_POINT;
+			} else if (variant == 1U) {
+				window[index] = tinycardia_model_quantize(
+					2.0f * sinf(phase) + 0.5f * sinf(4.0f * phase),
+					TINYCARDIA_MODEL_ECG_SCALE,
+					TINYCARDIA_MODEL_ECG_ZERO_POINT);
+			} else {
+				random_state = random_state * 1103515245U + 12345U;
+				window[index] = (int8_t)(random_state >> 16);
+			}
+		}
+		for (size_t index = 0U; index < TINYCARDIA_MODEL_RR_COUNT; ++index) {
+			rr_input[index] = 0.25f * (float)variant * ((float)index - 3.0f);
+		}
+		memcpy(input, window, sizeof(window));
+		zassert_ok(tinycardia_model_infer_quantized(rr_input, ARRAY_SIZE(rr_input),
+							    &expected));
+		for (size_t chunk = 0U; chunk < ARRAY_SIZE(chunk_sizes); ++chunk) {
+			assert_stream_matches(window, chunk_sizes[chunk], &expected);
+		}
+	}
+
+	/* Whole-window inferences between chunks leave the streamed window intact. */
+	zassert_ok(tinycardia_model_stream_append(window, 0U, 1280U));
+	zassert_ok(tinycardia_model_infer_quantized(rr_input, ARRAY_SIZE(rr_input), &expected));
+	zassert_ok(tinycardia_model_stream_append(&window[1280], 1280U, 1280U));
+	assert_stream_matches(window, TINYCARDIA_MODEL_ECG_COUNT, &expected);
+	for (size_t index = 0U; index < ARRAY_SIZE(rr_input); ++index) {
+		rr_input[index] = 0.0f;
+	}
+}
+
+#if defined(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE)
+#define REUSE_STREAM_SAMPLES (4U * TINYCARDIA_MODEL_ECG_COUNT)
+
+static int8_t reuse_stream[REUSE_STREAM_SAMPLES];
+
+/*
+ * Infer the window at start_sample of reuse_stream, with its first sample
+ * changed when perturbed, and require the output of a whole-window invoke
+ * after reusing reused samples of the previous window.
+ */
+static void assert_window_matches(uint32_t start_sample, bool perturbed, int reused)
+{
+	int8_t *input = tinycardia_model_ecg_input();
+	struct tinycardia_model_result expected;
+	struct tinycardia_model_result result;
+
+	for (size_t index = 0U; index < TINYCARDIA_MODEL_RR_COUNT; ++index) {
+		rr_input[index] = 0.001f * (float)start_sample - 0.2f * (float)index;
+	}
+	memcpy(input, &reuse_stream[start_sample], TINYCARDIA_MODEL_ECG_COUNT);
+	if (perturbed) {
+		input[0] ^= 1;
+	}
+	zassert_ok(tinycardia_model_infer_quantized(rr_input, ARRAY_SIZE(rr_input), &expected));
+	zassert_equal(tinycardia_model_infer_window(start_sample, rr_input, ARRAY_SIZE(rr_input),
+						    &result),
+		      reused, "window at %u", (unsigned int)start_sample);
+	zassert_mem_equal(result.quantized_probabilities, expected.quantized_probabilities,
+			  sizeof(result.quantized_probabilities), "window at %u",
+			  (unsigned int)start_sample);
+	zassert_equal(result.classification, expected.classification);
+	zassert_equal(result.confidence, expected.confidence);
+}
+#endif
+
+ZTEST(model_runtime, test_overlapping_windows_reuse_front_end_exactly)
+{
+#if defined(CONFIG_TINYCARDIA_MODEL_WINDOW_REUSE)
+	uint32_t random_state = 0x51d3U;
+	struct tinycardia_model_result result;
+
+	/* A rhythm that changes along the stream, with noise and clipped stretches. */
+	for (size_t index = 0U; index < REUSE_STREAM_SAMPLES; ++index) {
+		float phase = 2.0f * 3.14159265f * (float)index / 256.0f;
+		float value = 2.0f * sinf((1.1f + 0.00005f * (float)index) * phase) +
+			      0.6f * sinf(5.3f * phase);
+
+		random_state = random_state * 1103515245U + 12345U;
+		value += 0.2f * (float)(int8_t)(random_state >> 16) / 128.0f;
+		if (index / 1000U == 7U) {
+			value *= 4.0f;
+		}
+		reuse_stream[index] = tinycardia_model_quantize(value, TINYCARDIA_MODEL_ECG_SCALE,
+								TINYCARDIA_MODEL_ECG_ZERO_POINT);
+	}
+
+	zassert_equal(tinycardia_model_infer_window(0U, NULL, ARRAY_SIZE(rr_input), &result),
+		      -EINVAL);
+	assert_window_matches(0U, false, 0);
+	/* Hops of 640, 256, and 1280 samples. */
+	assert_window_matches(640U, false, 1920);
+	assert_window_matches(1280U, false, 1920);
+	assert_window_matches(1536U, false, 2304);
+	assert_window_matches(2816U, false, 1280);
+	/* A shift off the pooling grid, the same window again, then a 16-sample step. */
+	assert_window_matches(2824U, false, 0);
+	assert_window_matches(2824U, false, 0);
+	assert_window_matches(2840U, false, 2544);
+	/* Backwards, and a window whose shared samples differ from the cached ones. */
+	assert_window_matches(1280U, false, 0);
+	assert_window_matches(1920U, true, 0);
+	/* The changed sample is not shared with the next window. */
+	assert_window_matches(2560U, false, 1920);
+	assert_window_matches(3200U, false, 1920);
+	/* No overlap at all, then the end of the stream. */
+	assert_window_matches(5760U, false, 0);
+	for (uint32_t start = 6400U; start <= REUSE_STREAM_SAMPLES - TINYCARDIA_MODEL_ECG_COUNT;
+	     start += 640U) {
+		assert_window_matches(start, false, 1920);
+	}
+	for (size_t index = 0U; index < ARRAY_SIZE(rr_input); ++index) {
+		rr_input[index] = 0.0f;
+	}
+#else
+	struct tinycardia_model_result result;
+
+	zassert_equal(tinycardia_model_infer_window(0U, rr_input, ARRAY_SIZE(rr_input), &result),
+		      -ENOTSUP);
+#endif
 }
 
 ZTEST_SUITE(model_quantization, NULL, NULL, NULL, NULL, NULL);